@@ -0,0 +1,127 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Managers/PersistentStateManager.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/SoftObjectPath.h"
+
+/** Default state shared between static object instances with the same archetype */
+struct FPersistentStateSharedDefaultState
+{
+	/** object class */
+	FSoftClassPath Class;
+	/** default SaveGame property values */
+	FPersistentStatePropertyBunch SaveGameBunch;
+};
+
+namespace UE::PersistentState::Private
+{
+	/**
+	 * Content addressed store for default object states, keyed by object archetype and SaveGame bunch hash.
+	 * Store holds weak references, shared state lifetime is controlled by object states that reference it.
+	 */
+	class FDefaultStateStore
+	{
+	public:
+		FORCEINLINE static FDefaultStateStore& Get()
+		{
+			return Instance;
+		}
+
+		/** @return shared default state for a given archetype and SaveGame bunch, creates a new one if no other instance shares it */
+		TSharedRef<const FPersistentStateSharedDefaultState> FindOrAdd(const UObject* Archetype, const FSoftClassPath& Class, FPersistentStatePropertyBunch&& SaveGameBunch)
+		{
+			const FKey Key{Archetype, FCrc::MemCrc32(SaveGameBunch.Value.GetData(), SaveGameBunch.Num())};
+			TWeakPtr<const FPersistentStateSharedDefaultState>& WeakState = States.FindOrAdd(Key);
+			
+			if (TSharedPtr<const FPersistentStateSharedDefaultState> SharedState = WeakState.Pin())
+			{
+				if (SharedState->Class == Class && SharedState->SaveGameBunch == SaveGameBunch)
+				{
+					return SharedState.ToSharedRef();
+				}
+				
+				// hash collision, keep default state unique
+				return MakeShared<FPersistentStateSharedDefaultState>(FPersistentStateSharedDefaultState{Class, MoveTemp(SaveGameBunch)});
+			}
+
+			TSharedRef<const FPersistentStateSharedDefaultState> NewState = MakeShared<FPersistentStateSharedDefaultState>(FPersistentStateSharedDefaultState{Class, MoveTemp(SaveGameBunch)});
+			WeakState = NewState;
+			
+			return NewState;
+		}
+
+		/** @return number of alive shared states */
+		int32 Num() const
+		{
+			int32 Result = 0;
+			for (const auto& [Key, WeakState]: States)
+			{
+				Result += WeakState.IsValid() ? 1 : 0;
+			}
+			return Result;
+		}
+
+		/** @return memory allocated by the store and alive shared states */
+		uint32 GetAllocatedSize() const
+		{
+			uint32 TotalMemory = States.GetAllocatedSize();
+			for (const auto& [Key, WeakState]: States)
+			{
+				if (TSharedPtr<const FPersistentStateSharedDefaultState> SharedState = WeakState.Pin())
+				{
+					TotalMemory += sizeof(FPersistentStateSharedDefaultState) + SharedState->SaveGameBunch.Value.GetAllocatedSize();
+				}
+			}
+			return TotalMemory;
+		}
+
+		/** register engine delegates, called on module startup */
+		void Initialize()
+		{
+			PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FDefaultStateStore::OnPostGarbageCollect);
+		}
+
+		/** unregister engine delegates, called on module shutdown */
+		void Shutdown()
+		{
+			FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+			PostGarbageCollectHandle.Reset();
+			States.Reset();
+		}
+		
+	private:
+		static FDefaultStateStore Instance;
+
+		/** remove expired shared states and states for archetypes that has been garbage collected */
+		void OnPostGarbageCollect()
+		{
+			for (auto It = States.CreateIterator(); It; ++It)
+			{
+				if (!It->Value.IsValid() || It->Key.Archetype.ResolveObjectPtr() == nullptr)
+				{
+					It.RemoveCurrent();
+				}
+			}
+		}
+
+		struct FKey
+		{
+			TObjectKey<UObject> Archetype;
+			uint32 Hash = 0;
+
+			friend bool operator==(const FKey& A, const FKey& B)
+			{
+				return A.Hash == B.Hash && A.Archetype == B.Archetype;
+			}
+
+			friend uint32 GetTypeHash(const FKey& Value)
+			{
+				return HashCombineFast(GetTypeHash(Value.Archetype), Value.Hash);
+			}
+		};
+
+		TMap<FKey, TWeakPtr<const FPersistentStateSharedDefaultState>> States;
+		FDelegateHandle PostGarbageCollectHandle;
+	};
+}
@@ -1,5 +1,6 @@
 #include "Managers/PersistentStateManager.h"
 
+#include "PersistentStateSchema.h"
 #include "PersistentStateSerialization.h"
 #include "PersistentStateSubsystem.h"
 
@@ -33,6 +34,15 @@ bool FPersistentStatePropertyBunch::Serialize(FStructuredArchive::FSlot Slot)
 }
 #endif
 
+void FPersistentStatePropertyBunch::PostSerialize(const FArchive& Ar)
+{
+	// debug formatters store human-readable bunches that don't reference schemas
+	if (Ar.IsSaving() && FPersistentStateFormatter::IsReleaseFormatter())
+	{
+		FPersistentStateSchemaReferenceScope::AddBunchReference(Value);
+	}
+}
+
 UWorld* UPersistentStateManager::GetWorld() const
 {
 	return GetTypedOuter<UPersistentStateSubsystem>()->GetWorld();
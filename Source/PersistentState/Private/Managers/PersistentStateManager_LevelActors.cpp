@@ -1,13 +1,18 @@
 #include "Managers/PersistentStateManager_LevelActors.h"
 
+#include "Managers/PersistentStateDefaultStateStore.h"
 #include "PersistentStateArchive.h"
+#include "PersistentStateCVars.h"
 #include "PersistentStateModule.h"
 #include "PersistentStateInterface.h"
 #include "PersistentStateObjectId.h"
+#include "PersistentStateSchema.h"
 #include "PersistentStateSerialization.h"
+#include "PersistentStateSettings.h"
 #include "PersistentStateStatics.h"
 #include "PersistentStateSubsystem.h"
 #include "Engine/AssetManager.h"
+#include "Serialization/VarInt.h"
 #include "Streaming/LevelStreamingDelegates.h"
 
 DECLARE_DWORD_COUNTER_STAT(TEXT("Tracked Levels"),		STAT_PersistentState_NumLevels,			STATGROUP_PersistentState);
@@ -16,6 +21,401 @@ DECLARE_DWORD_COUNTER_STAT(TEXT("Tracked Components"),	STAT_PersistentState_NumC
 DECLARE_DWORD_COUNTER_STAT(TEXT("Tracked Dependencies"),STAT_PersistentState_NumDependencies,	STATGROUP_PersistentState);
 DECLARE_DWORD_COUNTER_STAT(TEXT("Destroyed Objects"),	STAT_PersistentState_DestroyedObjects,	STATGROUP_PersistentState);
 DECLARE_DWORD_COUNTER_STAT(TEXT("Outdated Objects"),	STAT_PersistentState_OutdatedObjects,	STATGROUP_PersistentState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Default States"),STAT_PersistentState_SharedDefaultStates,STATGROUP_PersistentState);
+DECLARE_MEMORY_STAT(TEXT("Shared Default States Memory"),STAT_PersistentState_SharedDefaultStatesMemory,STATGROUP_PersistentState);
+
+namespace UE::PersistentState::Private
+{
+	FDefaultStateStore FDefaultStateStore::Instance;
+
+	/** @return transform components that differ between @Default and @Current transforms */
+	EPersistentStateTransformFlags GetChangedTransformComponents(const FTransform& Default, const FTransform& Current)
+	{
+		EPersistentStateTransformFlags Result = EPersistentStateTransformFlags::None;
+		if (!Default.GetLocation().Equals(Current.GetLocation()))
+		{
+			Result |= EPersistentStateTransformFlags::Location;
+		}
+		if (!Default.GetRotation().Equals(Current.GetRotation()))
+		{
+			Result |= EPersistentStateTransformFlags::Rotation;
+		}
+		if (!Default.GetScale3D().Equals(Current.GetScale3D()))
+		{
+			Result |= EPersistentStateTransformFlags::Scale;
+		}
+		
+		return Result;
+	}
+
+#if WITH_COMPACT_SERIALIZATION
+	template <typename T>
+	FORCEINLINE bool IsFloatExact(const T& Value)
+	{
+		return static_cast<double>(static_cast<float>(Value)) == Value;
+	}
+
+	FORCEINLINE bool IsFloatExact(const FVector& Value)
+	{
+		return IsFloatExact(Value.X) && IsFloatExact(Value.Y) && IsFloatExact(Value.Z);
+	}
+
+	FORCEINLINE bool IsFloatExact(const FQuat& Value)
+	{
+		return IsFloatExact(Value.X) && IsFloatExact(Value.Y) && IsFloatExact(Value.Z) && IsFloatExact(Value.W);
+	}
+
+	/** number of bits per quaternion component for smallest three encoding */
+	constexpr int32 QuatComponentBits = 20;
+	constexpr uint64 QuatComponentMask = (1ULL << QuatComponentBits) - 1;
+	
+	/** @return quaternion packed with smallest three encoding: index of the largest component and three remaining components */
+	uint64 PackQuat(FQuat Value)
+	{
+		Value.Normalize();
+		const double Components[4] = {Value.X, Value.Y, Value.Z, Value.W};
+		
+		int32 LargestIndex = 0;
+		for (int32 Index = 1; Index < 4; ++Index)
+		{
+			if (FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]))
+			{
+				LargestIndex = Index;
+			}
+		}
+
+		// q and -q represent the same rotation, flip sign so that omitted component is positive
+		const double Sign = Components[LargestIndex] < 0.0 ? -1.0 : 1.0;
+		
+		uint64 Result = LargestIndex;
+		for (int32 Index = 0, Shift = 2; Index < 4; ++Index)
+		{
+			if (Index != LargestIndex)
+			{
+				// remaining components are in [-1/sqrt(2), 1/sqrt(2)] range
+				const double Normalized = (Components[Index] * Sign * UE_DOUBLE_INV_SQRT_2 + 0.5);
+				const uint64 Quantized = static_cast<uint64>(FMath::Clamp<int64>(FMath::RoundToInt64(Normalized * QuatComponentMask), 0, QuatComponentMask));
+				Result |= Quantized << Shift;
+				Shift += QuatComponentBits;
+			}
+		}
+
+		return Result;
+	}
+
+	/** @return quaternion unpacked from smallest three encoding */
+	FQuat UnpackQuat(uint64 Value)
+	{
+		const int32 LargestIndex = static_cast<int32>(Value & 3);
+		double Components[4];
+		double SumSquared = 0.0;
+		
+		for (int32 Index = 0, Shift = 2; Index < 4; ++Index)
+		{
+			if (Index != LargestIndex)
+			{
+				const double Normalized = static_cast<double>((Value >> Shift) & QuatComponentMask) / QuatComponentMask;
+				Components[Index] = (Normalized - 0.5) * UE_DOUBLE_SQRT_2;
+				SumSquared += Components[Index] * Components[Index];
+				Shift += QuatComponentBits;
+			}
+		}
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.0, 1.0 - SumSquared));
+
+		FQuat Result{Components[0], Components[1], Components[2], Components[3]};
+		Result.Normalize();
+		
+		return Result;
+	}
+
+	void SerializeVector(FArchive& Ar, FVector& Value, bool bSinglePrecision)
+	{
+		if (bSinglePrecision)
+		{
+			FVector3f FloatValue{Value};
+			Ar << FloatValue;
+			Value = FVector{FloatValue};
+		}
+		else
+		{
+			Ar << Value;
+		}
+	}
+
+	/**
+	 * quantized location precision of the level state that is being serialized on this thread. Precision is stored
+	 * with the level state, so that locations are restored with the precision they were saved with @see FLevelPersistentState::Serialize
+	 */
+	static thread_local double GLevelLocationPrecision = 0.0;
+
+	/** @return quantized location precision of the level state that is being serialized */
+	double GetLocationPrecision()
+	{
+		return GLevelLocationPrecision > 0.0 ? GLevelLocationPrecision : UPersistentStateSettings::Get()->QuantizedLocationPrecision;
+	}
+	
+	/**
+	 * serialize transform flags of @Desc, transform components are serialized separately with the returned flags
+	 * Transform components are stored in single precision if it doesn't lose precision, and quantized for classes that opt in
+	 * to lossy transforms @see UPersistentStateSettings::QuantizedTransformClasses
+	 */
+	EPersistentStateTransformFlags SerializeTransformFlags(FArchive& Ar, FPersistentStateObjectDesc& Desc)
+	{
+		using EFlags = EPersistentStateTransformFlags;
+		
+		EFlags Flags = EFlags::None;
+		if (Ar.IsSaving())
+		{
+			const FTransform& Transform = Desc.Transform;
+			Flags = Desc.TransformComponents & EFlags::All;
+			if (Desc.bQuantizeTransform)
+			{
+				Flags |= EFlags::QuantizedLocation | EFlags::QuantizedRotation;
+			}
+			else
+			{
+				Flags |= IsFloatExact(Transform.GetLocation()) ? EFlags::FloatLocation : EFlags::None;
+				Flags |= IsFloatExact(Transform.GetRotation()) ? EFlags::FloatRotation : EFlags::None;
+			}
+			Flags |= IsFloatExact(Transform.GetScale3D()) ? EFlags::FloatScale : EFlags::None;
+			Flags |= Transform.GetScale3D().AllComponentsEqual(0.0) ? EFlags::UniformScale : EFlags::None;
+		}
+
+		uint16 FlagsValue = static_cast<uint16>(Flags);
+		Ar << FlagsValue;
+		Flags = static_cast<EFlags>(FlagsValue);
+
+		if (Ar.IsLoading())
+		{
+			Desc.TransformComponents = Flags & EFlags::All;
+		}
+
+		return Flags;
+	}
+
+	/** serialize transform location of @Desc if it is stored in @Flags */
+	void SerializeTransformLocation(FArchive& Ar, FPersistentStateObjectDesc& Desc, EPersistentStateTransformFlags Flags)
+	{
+		using EFlags = EPersistentStateTransformFlags;
+		if (!EnumHasAnyFlags(Flags, EFlags::Location))
+		{
+			return;
+		}
+		
+		FVector Location = Desc.Transform.GetLocation();
+		if (EnumHasAnyFlags(Flags, EFlags::QuantizedLocation))
+		{
+			const double Precision = GetLocationPrecision();
+			for (int32 Index = 0; Index < 3; ++Index)
+			{
+				if (Ar.IsSaving())
+				{
+					WriteVarIntToArchive(Ar, FMath::RoundToInt64(Location[Index] / Precision));
+				}
+				else
+				{
+					Location[Index] = static_cast<double>(ReadVarIntFromArchive(Ar)) * Precision;
+				}
+			}
+		}
+		else
+		{
+			SerializeVector(Ar, Location, EnumHasAnyFlags(Flags, EFlags::FloatLocation));
+		}
+
+		if (Ar.IsLoading())
+		{
+			Desc.Transform.SetLocation(Location);
+		}
+	}
+
+	/** serialize transform rotation of @Desc if it is stored in @Flags */
+	void SerializeTransformRotation(FArchive& Ar, FPersistentStateObjectDesc& Desc, EPersistentStateTransformFlags Flags)
+	{
+		using EFlags = EPersistentStateTransformFlags;
+		if (!EnumHasAnyFlags(Flags, EFlags::Rotation))
+		{
+			return;
+		}
+		
+		FQuat Rotation = Desc.Transform.GetRotation();
+		if (EnumHasAnyFlags(Flags, EFlags::QuantizedRotation))
+		{
+			uint64 PackedRotation = Ar.IsSaving() ? PackQuat(Rotation) : 0;
+			Ar << PackedRotation;
+			Rotation = UnpackQuat(PackedRotation);
+		}
+		else if (EnumHasAnyFlags(Flags, EFlags::FloatRotation))
+		{
+			FQuat4f FloatRotation{Rotation};
+			Ar << FloatRotation;
+			Rotation = FQuat{FloatRotation};
+		}
+		else
+		{
+			Ar << Rotation;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Desc.Transform.SetRotation(Rotation);
+		}
+	}
+
+	/** serialize transform scale of @Desc if it is stored in @Flags */
+	void SerializeTransformScale(FArchive& Ar, FPersistentStateObjectDesc& Desc, EPersistentStateTransformFlags Flags)
+	{
+		using EFlags = EPersistentStateTransformFlags;
+		if (!EnumHasAnyFlags(Flags, EFlags::Scale))
+		{
+			return;
+		}
+		
+		FVector Scale = Desc.Transform.GetScale3D();
+		if (EnumHasAnyFlags(Flags, EFlags::UniformScale))
+		{
+			if (EnumHasAnyFlags(Flags, EFlags::FloatScale))
+			{
+				float Value = static_cast<float>(Scale.X);
+				Ar << Value;
+				Scale = FVector{Value};
+			}
+			else
+			{
+				double Value = Scale.X;
+				Ar << Value;
+				Scale = FVector{Value};
+			}
+		}
+		else
+		{
+			SerializeVector(Ar, Scale, EnumHasAnyFlags(Flags, EFlags::FloatScale));
+		}
+
+		if (Ar.IsLoading())
+		{
+			Desc.Transform.SetScale3D(Scale);
+		}
+	}
+
+	/** serialize transform components stored in @Desc @see SerializeTransformFlags */
+	void SerializeTransform(FArchive& Ar, FPersistentStateObjectDesc& Desc)
+	{
+		const EPersistentStateTransformFlags Flags = SerializeTransformFlags(Ar, Desc);
+		SerializeTransformLocation(Ar, Desc, Flags);
+		SerializeTransformRotation(Ar, Desc, Flags);
+		SerializeTransformScale(Ar, Desc, Flags);
+	}
+
+	/** level state on-disk layout */
+	enum class ELevelStateLayout: uint8
+	{
+		/** actor states are serialized one after another, each actor is followed by its components */
+		Rows = 0,
+		/** object state fields are grouped into columns, each column is serialized for all objects at once */
+		Columns = 1,
+	};
+
+	/** references to the serialized fields of actor or component state */
+	struct FObjectStateColumns
+	{
+		FPersistentStateObjectId* Handle = nullptr;
+		FPersistentStateDescFlags* Flags = nullptr;
+		FPersistentStateObjectDesc* Desc = nullptr;
+		FInstancedStruct* InstanceState = nullptr;
+	};
+
+	/**
+	 * serialize object state columns: flags, then each object desc field for all saved objects that have it.
+	 * Object handles should be serialized by the caller, as they're required to create object states on load.
+	 * SaveGame bunches are read directly to the level @Arena.
+	 */
+	void SerializeObjectColumns(FArchive& Ar, FPersistentStateLevelArena& Arena, TConstArrayView<FObjectStateColumns> Objects)
+	{
+		for (const FObjectStateColumns& Object: Objects)
+		{
+			Ar << *Object.Flags;
+		}
+
+		auto ForEachSaved = [Objects](auto&& Pred, auto&& Func)
+		{
+			for (const FObjectStateColumns& Object: Objects)
+			{
+				if (Object.Flags->bStateSaved && Pred(Object))
+				{
+					Func(Object);
+				}
+			}
+		};
+
+		auto IsDynamic		= [](const FObjectStateColumns& Object) { return Object.Handle->IsDynamic(); };
+		auto HasOwner		= [](const FObjectStateColumns& Object) { return Object.Flags->bHasInstanceOwner == true; };
+		auto HasTransform	= [](const FObjectStateColumns& Object) { return Object.Flags->bHasInstanceTransform == true; };
+		auto HasAttachment	= [](const FObjectStateColumns& Object) { return Object.Flags->bHasInstanceAttachment == true; };
+		auto HasBunch		= [](const FObjectStateColumns& Object) { return Object.Flags->bHasInstanceSaveGameBunch == true; };
+		auto Always			= [](const FObjectStateColumns& Object) { return true; };
+
+		ForEachSaved(IsDynamic,		[&Ar](const FObjectStateColumns& Object) { Ar << Object.Desc->Name; });
+		ForEachSaved(IsDynamic,		[&Ar](const FObjectStateColumns& Object) { Ar << Object.Desc->Class; });
+		ForEachSaved(HasOwner,		[&Ar](const FObjectStateColumns& Object) { Ar << Object.Desc->OwnerID; });
+		// transform is split into flags, location, rotation and scale columns, so that each column stores values of the same type
+		TArray<EPersistentStateTransformFlags, TInlineAllocator<64>> TransformFlags;
+		ForEachSaved(HasTransform,	[&Ar, &TransformFlags](const FObjectStateColumns& Object) { TransformFlags.Add(SerializeTransformFlags(Ar, *Object.Desc)); });
+		int32 TransformIndex = 0;
+		ForEachSaved(HasTransform,	[&Ar, &TransformFlags, &TransformIndex](const FObjectStateColumns& Object) { SerializeTransformLocation(Ar, *Object.Desc, TransformFlags[TransformIndex++]); });
+		TransformIndex = 0;
+		ForEachSaved(HasTransform,	[&Ar, &TransformFlags, &TransformIndex](const FObjectStateColumns& Object) { SerializeTransformRotation(Ar, *Object.Desc, TransformFlags[TransformIndex++]); });
+		TransformIndex = 0;
+		ForEachSaved(HasTransform,	[&Ar, &TransformFlags, &TransformIndex](const FObjectStateColumns& Object) { SerializeTransformScale(Ar, *Object.Desc, TransformFlags[TransformIndex++]); });
+		ForEachSaved(HasAttachment, [&Ar](const FObjectStateColumns& Object) { Ar << Object.Desc->AttachParentID; });
+		ForEachSaved(HasAttachment, [&Ar](const FObjectStateColumns& Object) { Ar << Object.Desc->AttachSocketName; });
+		// bunch sizes are stored in a separate column, so that bunch data column is a single contiguous blob
+		int32 NumBunchBytes = 0;
+		ForEachSaved(HasBunch,		[&Ar, &NumBunchBytes](const FObjectStateColumns& Object)
+		{
+			FPersistentStateArenaRange& Range = Object.Desc->SaveGameRange;
+			if (Ar.IsLoading())
+			{
+				Range.Num = static_cast<int32>(ReadVarUInt(Ar));
+			}
+			else
+			{
+				WriteVarUInt(Ar, static_cast<uint64>(Range.Num));
+			}
+			NumBunchBytes += Range.Num;
+		});
+		if (Ar.IsLoading())
+		{
+			// bunch data column is read to the level arena at once
+			const FPersistentStateArenaRange Column = Arena.AddUninitialized(NumBunchBytes);
+			Ar.Serialize(Arena.GetData(Column), NumBunchBytes);
+
+			int32 Offset = Column.Offset;
+			ForEachSaved(HasBunch,	[&Offset](const FObjectStateColumns& Object)
+			{
+				Object.Desc->SaveGameRange.Offset = Offset;
+				Offset += Object.Desc->SaveGameRange.Num;
+			});
+		}
+		else
+		{
+			ForEachSaved(HasBunch,	[&Ar, &Arena](const FObjectStateColumns& Object)
+			{
+				const FPersistentStateArenaRange& Range = Object.Desc->SaveGameRange;
+				Ar.Serialize(Arena.GetData(Range), Range.Num);
+			});
+		}
+		ForEachSaved(Always,		[&Ar](const FObjectStateColumns& Object) { Object.InstanceState->Serialize(Ar); });
+	}
+#endif // WITH_COMPACT_SERIALIZATION
+}
+
+FLevelLoadContext::FLevelLoadContext(FLevelDependencyTable& InDependencies, const FPersistentStateLevelArena& InArena, bool bInFromLevelStreaming)
+	: Dependencies(InDependencies)
+	, DependencyTracker(InDependencies.Tracker)
+	, Arena(InArena)
+	, bFromLevelStreaming(bInFromLevelStreaming)
+{}
 
 void FLevelLoadContext::AddCreatedActor(const FActorPersistentState& ActorState)
 {
@@ -29,6 +429,35 @@ void FLevelLoadContext::AddCreatedComponent(const FComponentPersistentState& Com
 	CreatedComponents.Add(ComponentState.GetHandle());
 }
 
+UClass* FLevelLoadContext::ResolveClass(const FSoftClassPath& ClassPath)
+{
+	return Dependencies.ResolveClass(ClassPath);
+}
+
+FLevelSaveContext::FLevelSaveContext(FLevelDependencyTable& InDependencies, FPersistentStateLevelArena& InArena, bool bInFromLevelStreaming)
+	: DependencyTracker(InDependencies.Tracker)
+	, Arena(InArena)
+	, bFromLevelStreaming(bInFromLevelStreaming)
+{}
+
+FPersistentStateArenaRange FPersistentStateLevelArena::Add(TConstArrayView<uint8> Bytes)
+{
+	FPersistentStateArenaRange Range = AddUninitialized(Bytes.Num());
+	FMemory::Memcpy(GetData(Range), Bytes.GetData(), Bytes.Num());
+	
+	return Range;
+}
+
+FPersistentStateArenaRange FPersistentStateLevelArena::AddUninitialized(int32 Num)
+{
+	check(Num >= 0);
+	FPersistentStateArenaRange Range{};
+	Range.Offset = Data.AddUninitialized(Num);
+	Range.Num = Num;
+	
+	return Range;
+}
+
 void FLevelSaveContext::ProcessActorState(const FActorPersistentState& State)
 {
 	if (State.IsDynamic())
@@ -49,7 +478,7 @@ void FLevelSaveContext::ProcessComponentState(const FComponentPersistentState& S
 	}
 }
 
-FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(AActor& Actor, FPersistentStateObjectTracker& DependencyTracker)
+FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(AActor& Actor, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStateDefaultObjectDesc* Default)
 {
 	FPersistentStateObjectDesc Result{};
 
@@ -79,12 +508,22 @@ FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(AActor& Actor, FPe
 		}
 	}
 
-	UE::PersistentState::SaveObject(Actor, Result.SaveGameBunch, DependencyTracker);
+	Result.bQuantizeTransform = Result.bHasTransform && UPersistentStateSettings::Get()->ShouldQuantizeTransform(Actor.GetClass());
+	if (Default != nullptr)
+	{
+		Result.InitTransformComponents(*Default);
+		// static actor, store only properties that were changed compared to the default state
+		UE::PersistentState::SaveObject(Actor, Result.SaveGameBunch, DependencyTracker, Default->GetSaveGameBunch());
+	}
+	else
+	{
+		UE::PersistentState::SaveObject(Actor, Result.SaveGameBunch, DependencyTracker);
+	}
 
 	return Result;
 }
 
-FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(UActorComponent& Component, FPersistentStateObjectTracker& DependencyTracker)
+FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(UActorComponent& Component, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStateDefaultObjectDesc* Default)
 {
 	FPersistentStateObjectDesc Result{};
 
@@ -113,7 +552,17 @@ FPersistentStateObjectDesc FPersistentStateObjectDesc::Create(UActorComponent& C
 		}
 	}
 
-	UE::PersistentState::SaveObject(Component, Result.SaveGameBunch, DependencyTracker);
+	Result.bQuantizeTransform = Result.bHasTransform && UPersistentStateSettings::Get()->ShouldQuantizeTransform(Component.GetClass());
+	if (Default != nullptr)
+	{
+		Result.InitTransformComponents(*Default);
+		// static component, store only properties that were changed compared to the default state
+		UE::PersistentState::SaveObject(Component, Result.SaveGameBunch, DependencyTracker, Default->GetSaveGameBunch());
+	}
+	else
+	{
+		UE::PersistentState::SaveObject(Component, Result.SaveGameBunch, DependencyTracker);
+	}
 
 	return Result;
 }
@@ -129,13 +578,77 @@ uint32 FPersistentStateObjectDesc::GetAllocatedSize() const
 	return SaveGameBunch.Value.GetAllocatedSize();
 }
 
+void FPersistentStateObjectDesc::MoveSaveGameBunch(FPersistentStateLevelArena& Arena, bool bHasSaveGameBunch)
+{
+	SaveGameRange = bHasSaveGameBunch ? Arena.Add(SaveGameBunch.Value) : FPersistentStateArenaRange{};
+	SaveGameBunch.Value.Empty();
+}
+
+void FPersistentStateObjectDesc::InitTransformComponents(const FPersistentStateDefaultObjectDesc& Default)
+{
+	const bool bSameAttachment = Default.AttachParentID == AttachParentID && Default.AttachSocketName == AttachSocketName;
+	// transform space changes together with attachment, so transform can be delta serialized only for the same attachment
+	TransformComponents = bSameAttachment ? UE::PersistentState::Private::GetChangedTransformComponents(Default.Transform, Transform) : EPersistentStateTransformFlags::All;
+}
+
+FTransform FPersistentStateObjectDesc::GetTransform(const FTransform& DefaultTransform) const
+{
+	if (TransformComponents == EPersistentStateTransformFlags::All)
+	{
+		return Transform;
+	}
+	
+	FTransform Result = DefaultTransform;
+	if (EnumHasAnyFlags(TransformComponents, EPersistentStateTransformFlags::Location))
+	{
+		Result.SetLocation(Transform.GetLocation());
+	}
+	if (EnumHasAnyFlags(TransformComponents, EPersistentStateTransformFlags::Rotation))
+	{
+		Result.SetRotation(Transform.GetRotation());
+	}
+	if (EnumHasAnyFlags(TransformComponents, EPersistentStateTransformFlags::Scale))
+	{
+		Result.SetScale3D(Transform.GetScale3D());
+	}
+
+	return Result;
+}
+
+FPersistentStateDefaultObjectDesc FPersistentStateDefaultObjectDesc::Create(const UObject& Object, FPersistentStateObjectDesc&& Desc)
+{
+	FPersistentStateDefaultObjectDesc Result{};
+	
+	Result.Transform = Desc.Transform;
+	Result.OwnerID = Desc.OwnerID;
+	Result.AttachParentID = Desc.AttachParentID;
+	Result.Name = Desc.Name;
+	Result.AttachSocketName = Desc.AttachSocketName;
+	Result.bHasTransform = Desc.bHasTransform;
+	Result.SharedState = UE::PersistentState::Private::FDefaultStateStore::Get().FindOrAdd(Object.GetArchetype(), Desc.Class, MoveTemp(Desc.SaveGameBunch));
+	
+	return Result;
+}
+
+const FSoftClassPath& FPersistentStateDefaultObjectDesc::GetClass() const
+{
+	check(SharedState.IsValid());
+	return SharedState->Class;
+}
+
+const FPersistentStatePropertyBunch& FPersistentStateDefaultObjectDesc::GetSaveGameBunch() const
+{
+	check(SharedState.IsValid());
+	return SharedState->SaveGameBunch;
+}
+
 FPersistentStateDescFlags FPersistentStateDescFlags::GetFlagsForStaticObject(
 	FPersistentStateDescFlags SourceFlags,
-    const FPersistentStateObjectDesc& Default,
+    const FPersistentStateDefaultObjectDesc& Default,
     const FPersistentStateObjectDesc& Current) const
 {
 	checkf(Default.Name == Current.Name, TEXT("renaming statically created objects is not supported."));
-	checkf(Default.Class == Current.Class, TEXT("static object class should not change."));
+	checkf(Default.GetClass() == Current.Class, TEXT("static object class should not change."));
 	checkf(Default.bHasTransform == Current.bHasTransform, TEXT("transform property should not flip."));
 	
 	FPersistentStateDescFlags Result = SourceFlags;
@@ -143,8 +656,8 @@ FPersistentStateDescFlags FPersistentStateDescFlags::GetFlagsForStaticObject(
 	Result.bHasInstanceOwner			= Default.OwnerID != Current.OwnerID;
 	Result.bHasInstanceAttachment		= !(Default.AttachParentID == Current.AttachParentID && Default.AttachSocketName == Current.AttachSocketName);
 	Result.bHasInstanceTransform		= Result.bHasInstanceAttachment || (Current.bHasTransform && !Default.Transform.Equals(Current.Transform));
-	// @todo: equal save game is always different between Default and Current if it contains soft object references
-	Result.bHasInstanceSaveGameBunch	= !Default.EqualSaveGame(Current);
+	// current SaveGame bunch is delta serialized against default state, empty delta means property values match defaults
+	Result.bHasInstanceSaveGameBunch	= !Current.SaveGameBunch.IsEmpty();
 
 	return Result;
 }
@@ -171,10 +684,13 @@ void FPersistentStateDescFlags::SerializeObjectState(FArchive& Ar, FPersistentSt
 	Ar << TDeltaSerializeHelper(State.Name, ObjectHandle.IsDynamic());
 	Ar << TDeltaSerializeHelper(State.Class, ObjectHandle.IsDynamic());
 	Ar << TDeltaSerializeHelper(State.OwnerID, bHasInstanceOwner);
-	Ar << TDeltaSerializeHelper(State.Transform, bHasInstanceTransform);
+	if (bHasInstanceTransform)
+	{
+		UE::PersistentState::Private::SerializeTransform(Ar, State);
+	}
 	Ar << TDeltaSerializeHelper(State.AttachParentID, bHasInstanceAttachment);
 	Ar << TDeltaSerializeHelper(State.AttachSocketName, bHasInstanceAttachment);
-	Ar << TDeltaSerializeHelper(State.SaveGameBunch.Value, bHasInstanceSaveGameBunch);
+	Ar << TDeltaSerializeHelper(State.SaveGameRange, bHasInstanceSaveGameBunch);
 
 	check(!Ar.IsLoading() || bStateSaved == true);
 }
@@ -219,13 +735,13 @@ void FComponentPersistentState::LinkComponentHandle(UActorComponent* Component,
 	}
 }
 
-UActorComponent* FComponentPersistentState::CreateDynamicComponent(AActor* OwnerActor) const
+UActorComponent* FComponentPersistentState::CreateDynamicComponent(FLevelLoadContext& Context, AActor* OwnerActor) const
 {
 	check(ComponentHandle.IsValid());
 	// verify that persistent state is valid for creating a dynamic component
 	check(StateFlags.bStateLinked == false && StateFlags.bStateSaved && ComponentHandle.IsDynamic());
 
-	UClass* Class = SavedComponentState.Class.ResolveClass();
+	UClass* Class = Context.ResolveClass(SavedComponentState.Class);
 	check(Class);
 
 	UActorComponent* Component = nullptr;
@@ -256,7 +772,7 @@ void FComponentPersistentState::LoadComponent(FLevelLoadContext& Context)
 	if (IsStatic())
 	{
 		FPersistentStateObjectTracker DummyTracker{};
-		DefaultComponentState = FPersistentStateObjectDesc::Create(*Component, DummyTracker);
+		DefaultComponentState = FPersistentStateDefaultObjectDesc::Create(*Component, FPersistentStateObjectDesc::Create(*Component, DummyTracker));
 	}
 	
 	if (StateFlags.bStateSaved)
@@ -286,18 +802,18 @@ void FComponentPersistentState::LoadComponent(FLevelLoadContext& Context)
 					
 				}
 
-				SceneComponent->SetRelativeTransform(SavedComponentState.Transform);
+				SceneComponent->SetRelativeTransform(SavedComponentState.GetTransform(SceneComponent->GetRelativeTransform()));
 			}
 			else
 			{
 				// component is not attached to anything, ComponentTransform is world transform
-				SceneComponent->SetWorldTransform(SavedComponentState.Transform);
+				SceneComponent->SetWorldTransform(SavedComponentState.GetTransform(SceneComponent->GetComponentTransform()));
 			}
 		}
 
 		if (StateFlags.bHasInstanceSaveGameBunch)
 		{
-			UE::PersistentState::LoadObject(*Component, SavedComponentState.SaveGameBunch, Context.DependencyTracker);
+			UE::PersistentState::LoadObject(*Component, Context.Arena.GetView(SavedComponentState.SaveGameRange), Context.DependencyTracker);
 		}
 		
 		if (InstanceState.IsValid())
@@ -351,7 +867,7 @@ void FComponentPersistentState::SaveComponent(FLevelSaveContext& Context)
 	
 	State->PreSaveState();
 
-	SavedComponentState = FPersistentStateObjectDesc::Create(*Component, Context.DependencyTracker);
+	SavedComponentState = FPersistentStateObjectDesc::Create(*Component, Context.DependencyTracker, IsStatic() ? &DefaultComponentState : nullptr);
 	if (IsStatic())
 	{
 		StateFlags = StateFlags.GetFlagsForStaticObject(StateFlags, DefaultComponentState, SavedComponentState);
@@ -360,6 +876,7 @@ void FComponentPersistentState::SaveComponent(FLevelSaveContext& Context)
 	{
 		StateFlags = StateFlags.GetFlagsForDynamicObject(StateFlags, SavedComponentState);
 	}
+	SavedComponentState.MoveSaveGameBunch(Context.Arena, StateFlags.bHasInstanceSaveGameBunch);
 	
 	// process component state through save context
 	Context.ProcessComponentState(*this);
@@ -428,22 +945,29 @@ void FActorPersistentState::LinkActorHandle(AActor* Actor, const FPersistentStat
 	}
 }
 
-AActor* FActorPersistentState::CreateDynamicActor(UWorld* World, FActorSpawnParameters& SpawnParams) const
+AActor* FLevelPersistentState::CreateDynamicActor(int32 ActorIndex, FLevelLoadContext& Context, UWorld* World, FActorSpawnParameters& SpawnParams)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(Actors.IsValidIndex(ActorIndex));
+	
+	// actor states can be reallocated by actors spawned during dynamic actor creation, so actor state data is copied
+	// before spawn and actor state is accessed by index afterwards
+	const FActorPersistentState& ActorState = Actors[ActorIndex];
+	const FPersistentStateObjectId ActorHandle = ActorState.ActorHandle;
+	const FTransform Transform = ActorState.SavedActorState.Transform;
 	check(ActorHandle.IsValid());
 	// verify that persistent state can create a dynamic actor
-	check(!StateFlags.bStateLinked && !StateFlags.bStateInitialized && StateFlags.bStateSaved && ActorHandle.IsDynamic());
+	check(!ActorState.StateFlags.bStateLinked && !ActorState.StateFlags.bStateInitialized && ActorState.StateFlags.bStateSaved && ActorHandle.IsDynamic());
 
-	UClass* ActorClass = SavedActorState.Class.ResolveClass();
+	UClass* ActorClass = Context.ResolveClass(ActorState.SavedActorState.Class);
 	check(ActorClass);
 
 	check(SpawnParams.OverrideLevel);
-	SpawnParams.Name = SavedActorState.Name;
-	SpawnParams.CustomPreSpawnInitalization = [this, Callback = SpawnParams.CustomPreSpawnInitalization](AActor* Actor)
+	SpawnParams.Name = ActorState.SavedActorState.Name;
+	SpawnParams.CustomPreSpawnInitalization = [this, ActorIndex, ActorHandle, Callback = SpawnParams.CustomPreSpawnInitalization](AActor* Actor)
 	{
 		// assign actor id before actor is fully spawned
-		LinkActorHandle(Actor, ActorHandle);
+		Actors[ActorIndex].LinkActorHandle(Actor, ActorHandle);
 
 		if (Callback)
 		{
@@ -465,7 +989,7 @@ AActor* FActorPersistentState::CreateDynamicActor(UWorld* World, FActorSpawnPara
 		FGuardValue_Bitfield(SpawnParams.OverrideLevel->bAlreadyInitializedNetworkActors, true);
 		// actor transform is going to be overriden later by LoadActor call
 		FPersistentStateObjectIdScope Initializer{ActorHandle, SpawnParams.Name, ActorClass};
-		Actor = World->SpawnActor(ActorClass, &SavedActorState.Transform, SpawnParams);
+		Actor = World->SpawnActor(ActorClass, &Transform, SpawnParams);
 	}
 
 	// @todo: GSpawnActorDeferredTransformCache is not cleared from a deferred spawned actor
@@ -473,11 +997,11 @@ AActor* FActorPersistentState::CreateDynamicActor(UWorld* World, FActorSpawnPara
 	if (SpawnParams.bDeferConstruction)
 	{
 		FEditorScriptExecutionGuard ScriptGuard;
-		Actor->ExecuteConstruction(SavedActorState.Transform, nullptr, nullptr, false);
+		Actor->ExecuteConstruction(Transform, nullptr, nullptr, false);
 	}
 	
 	check(Actor && Actor->HasActorRegisteredAllComponents() && !Actor->IsActorInitialized() && !Actor->HasActorBegunPlay());
-	UE_LOG(LogPersistentState, Verbose, TEXT("created dynamic actor %s"), *ToString());
+	UE_LOG(LogPersistentState, Verbose, TEXT("created dynamic actor %s"), *ActorHandle.ToString());
 
 	return Actor;
 }
@@ -496,7 +1020,7 @@ void FActorPersistentState::LoadActor(FLevelLoadContext& Context)
 	{
 		// save default sate for static actors to compared it with runtime state during save
 		FPersistentStateObjectTracker DummyTracker{};
-		DefaultActorState = FPersistentStateObjectDesc::Create(*Actor, DummyTracker);
+		DefaultActorState = FPersistentStateDefaultObjectDesc::Create(*Actor, FPersistentStateObjectDesc::Create(*Actor, DummyTracker));
 	}
 
 	// load components
@@ -540,18 +1064,18 @@ void FActorPersistentState::LoadActor(FLevelLoadContext& Context)
 					}
 				}
 				
-				Actor->SetActorRelativeTransform(SavedActorState.Transform);
+				Actor->SetActorRelativeTransform(SavedActorState.GetTransform(Actor->GetRootComponent()->GetRelativeTransform()));
 			}
 			else
 			{
 				// actor is not attached to anything, transform is in world space
-				Actor->SetActorTransform(SavedActorState.Transform);
+				Actor->SetActorTransform(SavedActorState.GetTransform(Actor->GetActorTransform()));
 			}
 		}
 
 		if (StateFlags.bHasInstanceSaveGameBunch)
 		{
-			UE::PersistentState::LoadObject(*Actor, SavedActorState.SaveGameBunch, Context.DependencyTracker);
+			UE::PersistentState::LoadObject(*Actor, Context.Arena.GetView(SavedActorState.SaveGameRange), Context.DependencyTracker);
 		}
 		
 		if (InstanceState.IsValid())
@@ -633,7 +1157,7 @@ void FActorPersistentState::SaveActor(FLevelSaveContext& Context)
 		}
 	}
 
-	SavedActorState = FPersistentStateObjectDesc::Create(*Actor, Context.DependencyTracker);
+	SavedActorState = FPersistentStateObjectDesc::Create(*Actor, Context.DependencyTracker, IsStatic() ? &DefaultActorState : nullptr);
 	if (IsStatic())
 	{
 		StateFlags = StateFlags.GetFlagsForStaticObject(StateFlags, DefaultActorState, SavedActorState);
@@ -642,6 +1166,7 @@ void FActorPersistentState::SaveActor(FLevelSaveContext& Context)
 	{
 		StateFlags = StateFlags.GetFlagsForDynamicObject(StateFlags, SavedActorState);
 	}
+	SavedActorState.MoveSaveGameBunch(Context.Arena, StateFlags.bHasInstanceSaveGameBunch);
 
 	// process actor state through save context
 	Context.ProcessActorState(*this);
@@ -716,7 +1241,6 @@ void FActorPersistentState::UpdateActorComponents(FLevelSaveContext& Context, co
 uint32 FActorPersistentState::GetAllocatedSize() const
 {
 	uint32 TotalMemory = 0;
-	TotalMemory += DefaultActorState.GetAllocatedSize();
 	TotalMemory += SavedActorState.GetAllocatedSize();
 	TotalMemory += Components.GetAllocatedSize();
 	
@@ -756,22 +1280,109 @@ FLevelPersistentState::FLevelPersistentState(const ULevel* Level)
 	check(LevelHandle.IsValid());
 }
 
+#if WITH_COMPACT_SERIALIZATION
+bool FLevelPersistentState::Serialize(FArchive& Ar)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	using namespace UE::PersistentState::Private;
+
+	Ar << LevelHandle;
+	Ar << Dependencies;
+
+	uint8 Layout = static_cast<uint8>(UE::PersistentState::GPersistentState_ColumnarLevelEncoding ? ELevelStateLayout::Columns : ELevelStateLayout::Rows);
+	Ar << Layout;
+
+	// quantized locations are restored with the precision they were saved with, even if project settings have changed
+	double LocationPrecision = UPersistentStateSettings::Get()->QuantizedLocationPrecision;
+	Ar << LocationPrecision;
+	
+	if (Layout > static_cast<uint8>(ELevelStateLayout::Columns) || !(LocationPrecision > 0.0))
+	{
+		// level state data is already consumed, so serializer reports the error and returns true to prevent
+		// tagged serialization fallback from reading the rest of the state data as tagged properties
+		UE_LOG(LogPersistentState, Error, TEXT("%s: level state %s has unknown layout %d or invalid location precision %f."),
+			*FString(__FUNCTION__), *LevelHandle.ToString(), Layout, LocationPrecision);
+		Ar.SetError();
+		return true;
+	}
+	TGuardValue PrecisionGuard{GLevelLocationPrecision, LocationPrecision};
+
+	if (Layout == static_cast<uint8>(ELevelStateLayout::Rows))
+	{
+		Ar << Arena.Data;
+		Ar << Actors;
+		ActorIndices.Reset();
+		return true;
+	}
+
+	int32 NumActors = Actors.Num();
+	Ar << NumActors;
+
+	if (Ar.IsLoading())
+	{
+		Actors.Reset(NumActors);
+		Actors.SetNum(NumActors);
+		ActorIndices.Reset();
+		Arena.Reset();
+	}
+
+	TArray<FObjectStateColumns> Objects;
+	Objects.Reserve(NumActors);
+	// actor handles column
+	for (FActorPersistentState& ActorState: Actors)
+	{
+		Ar << ActorState.ActorHandle;
+		Objects.Add({&ActorState.ActorHandle, &ActorState.StateFlags, &ActorState.SavedActorState, &ActorState.InstanceState});
+	}
+	SerializeObjectColumns(Ar, Arena, Objects);
+
+	// component count column for saved actors
+	int32 NumComponents = 0;
+	for (FActorPersistentState& ActorState: Actors)
+	{
+		if (ActorState.StateFlags.bStateSaved)
+		{
+			if (Ar.IsLoading())
+			{
+				ActorState.Components.SetNum(static_cast<int32>(ReadVarUInt(Ar)));
+			}
+			else
+			{
+				WriteVarUInt(Ar, static_cast<uint64>(ActorState.Components.Num()));
+			}
+			NumComponents += ActorState.Components.Num();
+		}
+	}
+
+	// component handles column, followed by component state columns for all actors
+	Objects.Reset(NumComponents);
+	for (FActorPersistentState& ActorState: Actors)
+	{
+		if (ActorState.StateFlags.bStateSaved)
+		{
+			for (FComponentPersistentState& ComponentState: ActorState.Components)
+			{
+				Ar << ComponentState.ComponentHandle;
+				Objects.Add({&ComponentState.ComponentHandle, &ComponentState.StateFlags, &ComponentState.SavedComponentState, &ComponentState.InstanceState});
+			}
+		}
+	}
+	SerializeObjectColumns(Ar, Arena, Objects);
+
+	return true;
+}
+#endif // WITH_COMPACT_SERIALIZATION
+
 bool FLevelPersistentState::HasActor(const FPersistentStateObjectId& ActorId) const
 {
-	return Actors.Contains(ActorId);
+	return FindActorIndex(ActorId) != INDEX_NONE;
 }
 
 bool FLevelPersistentState::HasComponent(const FPersistentStateObjectId& ActorId, const FPersistentStateObjectId& ComponentId) const
 {
-	if (const FActorPersistentState* ActorState = Actors.Find(ActorId))
+	if (const FActorPersistentState* ActorState = GetActorState(ActorId))
 	{
-		if (ActorState->Components.ContainsByPredicate([&ComponentId](const FComponentPersistentState& ComponentState)
-		{
-			return ComponentState.GetHandle() == ComponentId;
-		}))
-		{
-			return true;
-		}
+		return ActorState->GetComponentState(ComponentId) != nullptr;
 	}
 
 	return false;
@@ -779,36 +1390,147 @@ bool FLevelPersistentState::HasComponent(const FPersistentStateObjectId& ActorId
 
 const FActorPersistentState* FLevelPersistentState::GetActorState(const FPersistentStateObjectId& ActorHandle) const
 {
-	return Actors.Find(ActorHandle);
+	const int32 Index = FindActorIndex(ActorHandle);
+	return Index != INDEX_NONE ? &Actors[Index] : nullptr;
 }
 
 FActorPersistentState* FLevelPersistentState::GetActorState(const FPersistentStateObjectId& ActorHandle)
 {
-	return Actors.Find(ActorHandle);
+	const int32 Index = FindActorIndex(ActorHandle);
+	return Index != INDEX_NONE ? &Actors[Index] : nullptr;
 }
 
 FActorPersistentState* FLevelPersistentState::CreateActorState(AActor* Actor, const FPersistentStateObjectId& ActorHandle)
 {
-	check(GetActorState(ActorHandle) == nullptr);
-	FActorPersistentState* ActorState = &Actors.Add(ActorHandle, FActorPersistentState{Actor, ActorHandle});
+	check(FindActorIndex(ActorHandle) == INDEX_NONE);
+	const int32 Index = Actors.Emplace(Actor, ActorHandle);
+	ActorIndices.Add(ActorHandle, Index);
 	
-	return ActorState;
+	return &Actors[Index];
+}
+
+int32 FLevelPersistentState::FindActorIndex(const FPersistentStateObjectId& ActorHandle) const
+{
+	if (ActorIndices.Num() != Actors.Num())
+	{
+		CacheActorIndices();
+	}
+
+	const int32* Index = ActorIndices.Find(ActorHandle);
+	checkSlow(Index == nullptr || Actors[*Index].GetHandle() == ActorHandle);
+	
+	return Index != nullptr ? *Index : INDEX_NONE;
+}
+
+void FLevelPersistentState::RemoveActorState(const FPersistentStateObjectId& ActorHandle)
+{
+	const int32 Index = FindActorIndex(ActorHandle);
+	if (Index != INDEX_NONE)
+	{
+		RemoveActorStateAt(Index);
+	}
+}
+
+void FLevelPersistentState::RemoveActorStateAt(int32 Index)
+{
+	check(Actors.IsValidIndex(Index));
+	ActorIndices.Remove(Actors[Index].GetHandle());
+	Actors.RemoveAtSwap(Index, 1, false);
+	
+	if (Actors.IsValidIndex(Index))
+	{
+		// last actor state has been moved to the removed slot
+		ActorIndices.Add(Actors[Index].GetHandle(), Index);
+	}
+}
+
+void FLevelPersistentState::CompactArena()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+
+	int32 NumLiveBytes = 0;
+	for (const FActorPersistentState& ActorState: Actors)
+	{
+		NumLiveBytes += ActorState.SavedActorState.SaveGameRange.Num;
+		for (const FComponentPersistentState& ComponentState: ActorState.Components)
+		{
+			NumLiveBytes += ComponentState.SavedComponentState.SaveGameRange.Num;
+		}
+	}
+
+	if (NumLiveBytes == Arena.Num())
+	{
+		// arena doesn't have any released data
+		return;
+	}
+
+	FPersistentStateLevelArena NewArena;
+	NewArena.Data.Reserve(NumLiveBytes);
+	
+	auto MoveRange = [this, &NewArena](FPersistentStateArenaRange& Range)
+	{
+		if (!Range.IsEmpty())
+		{
+			Range = NewArena.Add(Arena.GetView(Range));
+		}
+	};
+	
+	for (FActorPersistentState& ActorState: Actors)
+	{
+		MoveRange(ActorState.SavedActorState.SaveGameRange);
+		for (FComponentPersistentState& ComponentState: ActorState.Components)
+		{
+			MoveRange(ComponentState.SavedComponentState.SaveGameRange);
+		}
+	}
+
+	Arena = MoveTemp(NewArena);
+}
+
+void FLevelPersistentState::PostSerialize(const FArchive& Ar)
+{
+	// debug formatters store human-readable bunches that don't reference schemas
+	if (!Ar.IsSaving() || !FPersistentStateFormatter::IsReleaseFormatter())
+	{
+		return;
+	}
+	
+	for (const FActorPersistentState& ActorState: Actors)
+	{
+		FPersistentStateSchemaReferenceScope::AddBunchReference(Arena.GetView(ActorState.SavedActorState.SaveGameRange));
+		for (const FComponentPersistentState& ComponentState: ActorState.Components)
+		{
+			FPersistentStateSchemaReferenceScope::AddBunchReference(Arena.GetView(ComponentState.SavedComponentState.SaveGameRange));
+		}
+	}
 }
 
-FLevelLoadContext FLevelPersistentState::CreateLoadContext()
+void FLevelPersistentState::CacheActorIndices() const
 {
-	return FLevelLoadContext{DependencyTracker, !!bStreamingLevel};;
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	
+	ActorIndices.Reset();
+	ActorIndices.Reserve(Actors.Num());
+	for (int32 Index = 0; Index < Actors.Num(); ++Index)
+	{
+		ActorIndices.Add(Actors[Index].GetHandle(), Index);
+	}
 }
 
-FLevelSaveContext FLevelPersistentState::CreateSaveContext(bool bFromLevelStreaming)
+FLevelLoadContext FLevelPersistentState::CreateLoadContext(FLevelDependencyTable& DependencyTable)
 {
-	return FLevelSaveContext{DependencyTracker, bFromLevelStreaming};
+	return FLevelLoadContext{DependencyTable, Arena, !!bStreamingLevel};
 }
 
-void FLevelPersistentState::PreLoadAssets(FStreamableDelegate LoadCompletedDelegate)
+FLevelSaveContext FLevelPersistentState::CreateSaveContext(FLevelDependencyTable& DependencyTable, bool bFromLevelStreaming)
 {
-	check(!AssetHandle.IsValid());
-	if (DependencyTracker.IsEmpty())
+	return FLevelSaveContext{DependencyTable, Arena, bFromLevelStreaming};
+}
+
+void FLevelPersistentState::PreLoadAssets(FLevelDependencyTable& DependencyTable, FStreamableDelegate LoadCompletedDelegate)
+{
+	check(!AssetHandle.IsValid() && LoadedDependencies.IsEmpty());
+	if (Dependencies.IsEmpty())
 	{
 		if (LoadCompletedDelegate.IsBound())
 		{
@@ -817,14 +1539,15 @@ void FLevelPersistentState::PreLoadAssets(FStreamableDelegate LoadCompletedDeleg
 		return;
 	}
 
-	AssetHandle = UAssetManager::Get().GetStreamableManager().RequestAsyncLoad(DependencyTracker.Values);
+	LoadedDependencies = Dependencies;
+	AssetHandle = DependencyTable.RequestAssets(LoadedDependencies);
 	// asset handle can be invalid if level state doesn't have any hard dependencies
 	if (!AssetHandle.IsValid() || AssetHandle->HasLoadCompleted())
 	{
 		// do not use FStreamableDelegate::Execute because it is delayed one frame
 		LoadCompletedDelegate.Execute();
 	}
-	else\
+	else
 	{
 		AssetHandle->BindCompleteDelegate(LoadCompletedDelegate);
 		AssetHandle->BindCancelDelegate(FStreamableDelegate::CreateLambda([]
@@ -842,23 +1565,25 @@ void FLevelPersistentState::FinishLoadAssets()
 	}
 }
 
-void FLevelPersistentState::ReleaseLevelAssets()
+void FLevelPersistentState::ReleaseLevelAssets(FLevelDependencyTable& DependencyTable)
 {
 	ensureAlwaysMsgf(!AssetHandle.IsValid() || AssetHandle->HasLoadCompleted(), TEXT("%s: level hasn't finished loading level assets"), *FString(__FUNCTION__));
-	if (AssetHandle.IsValid())
-	{
-		AssetHandle->ReleaseHandle();
-		AssetHandle = nullptr;
-	}
+	// asset handle can be shared with other levels, dependency table releases it when it is no longer referenced
+	AssetHandle.Reset();
+	DependencyTable.ReleaseAssets(LoadedDependencies);
+	LoadedDependencies.Reset();
 }
 
 uint32 FLevelPersistentState::GetAllocatedSize() const
 {
 	uint32 TotalMemory = 0;
 	TotalMemory += Actors.GetAllocatedSize();
-	TotalMemory += DependencyTracker.NumValues() * sizeof(FSoftObjectPath);
+	TotalMemory += ActorIndices.GetAllocatedSize();
+	TotalMemory += Arena.GetAllocatedSize();
+	TotalMemory += Dependencies.GetAllocatedSize();
+	TotalMemory += LoadedDependencies.GetAllocatedSize();
 
-	for (const auto& [ActorId, ActorState]: Actors)
+	for (const FActorPersistentState& ActorState: Actors)
 	{
 		TotalMemory += ActorState.GetAllocatedSize();
 	}
@@ -866,6 +1591,150 @@ uint32 FLevelPersistentState::GetAllocatedSize() const
 	return TotalMemory;
 }
 
+FLevelDependencyTable::FDependencyEntry& FLevelDependencyTable::GetEntry(int32 Index)
+{
+	check(Index > 0 && Index <= Tracker.NumValues());
+	if (Entries.Num() < Tracker.NumValues())
+	{
+		Entries.SetNum(Tracker.NumValues());
+	}
+
+	return Entries[Index - 1];
+}
+
+TSharedPtr<FStreamableHandle> FLevelDependencyTable::RequestAssets(TConstArrayView<int32> Indices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	FStreamableManager& StreamableManager = UAssetManager::Get().GetStreamableManager();
+	
+	TArray<FSoftObjectPath> PendingPaths;
+	TArray<int32, TInlineAllocator<16>> PendingIndices;
+	TArray<TSharedPtr<FStreamableHandle>, TInlineAllocator<4>> SharedHandles;
+	
+	for (const int32 Index: Indices)
+	{
+		FDependencyEntry& Entry = GetEntry(Index);
+		++Entry.NumRefs;
+
+		if (Entry.Handle.IsValid())
+		{
+			// dependency has already been requested by another level
+			SharedHandles.AddUnique(Entry.Handle);
+		}
+		else
+		{
+			PendingPaths.Add(Tracker.LoadValue(Index));
+			PendingIndices.Add(Index);
+		}
+	}
+
+	TSharedPtr<FStreamableHandle> Handle;
+	if (!PendingPaths.IsEmpty())
+	{
+		Handle = StreamableManager.RequestAsyncLoad(MoveTemp(PendingPaths));
+		if (Handle.IsValid())
+		{
+			for (const int32 Index: PendingIndices)
+			{
+				GetEntry(Index).Handle = Handle;
+			}
+			HandleRefs.Add(Handle.Get(), PendingIndices.Num());
+		}
+	}
+
+	if (SharedHandles.IsEmpty())
+	{
+		return Handle;
+	}
+
+	// combine shared handles, so that caller doesn't override delegates bound by other levels
+	if (Handle.IsValid())
+	{
+		SharedHandles.Add(Handle);
+	}
+	return StreamableManager.CreateCombinedHandle(SharedHandles);
+}
+
+void FLevelDependencyTable::ReleaseAssets(TConstArrayView<int32> Indices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	
+	for (const int32 Index: Indices)
+	{
+		FDependencyEntry& Entry = GetEntry(Index);
+		check(Entry.NumRefs > 0);
+		
+		if (--Entry.NumRefs == 0 && Entry.Handle.IsValid())
+		{
+			// handle can still be shared with dependencies referenced by other levels. Streamable manager keeps its own
+			// reference to the handle, so handle is released based on the number of entries that share it
+			int32& NumHandleRefs = HandleRefs.FindChecked(Entry.Handle.Get());
+			if (--NumHandleRefs == 0)
+			{
+				HandleRefs.Remove(Entry.Handle.Get());
+				Entry.Handle->ReleaseHandle();
+			}
+			Entry.Handle.Reset();
+		}
+	}
+}
+
+void FLevelDependencyTable::ReleaseUnreferenced(const TBitArray<>& ReferencedIndices)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	
+	const int32 NumValues = Tracker.NumValues();
+	for (int32 Index = 1; Index <= NumValues; ++Index)
+	{
+		if (Index < ReferencedIndices.Num() && ReferencedIndices[Index])
+		{
+			continue;
+		}
+		
+		// dependency can still be loaded by a level that has been saved without it
+		if (Entries.IsValidIndex(Index - 1))
+		{
+			if (Entries[Index - 1].NumRefs > 0)
+			{
+				continue;
+			}
+			Entries[Index - 1] = FDependencyEntry{};
+		}
+		
+		Tracker.ReleaseValue(Index);
+	}
+}
+
+UClass* FLevelDependencyTable::ResolveClass(const FSoftClassPath& ClassPath)
+{
+	const int32 Index = static_cast<int32>(Tracker.FindValue(ClassPath));
+	if (Index == 0)
+	{
+		return ClassPath.ResolveClass();
+	}
+
+	FDependencyEntry& Entry = GetEntry(Index);
+	if (UObject* Object = Entry.Object.Get())
+	{
+		return CastChecked<UClass>(Object);
+	}
+
+	UClass* Class = ClassPath.ResolveClass();
+	Entry.Object = Class;
+	
+	return Class;
+}
+
+uint32 FLevelDependencyTable::GetAllocatedSize() const
+{
+	uint32 TotalMemory = 0;
+	TotalMemory += Tracker.NumValues() * sizeof(FSoftObjectPath);
+	TotalMemory += Entries.GetAllocatedSize();
+	TotalMemory += HandleRefs.GetAllocatedSize();
+
+	return TotalMemory;
+}
+
 UPersistentStateManager_LevelActors::UPersistentStateManager_LevelActors()
 {
 	ManagerType = EManagerStorageType::World;
@@ -997,7 +1866,7 @@ void UPersistentStateManager_LevelActors::NotifyObjectInitialized(UObject& Objec
 	FComponentPersistentState* ComponentState = ActorState->CreateComponentState(Component, ComponentId);
 	check(ComponentState && ComponentState->IsLinked());
 
-	FLevelLoadContext LoadContext = LevelState->CreateLoadContext();
+	FLevelLoadContext LoadContext = LevelState->CreateLoadContext(DependencyTable);
 	ComponentState->LoadComponent(LoadContext);
 }
 
@@ -1030,6 +1899,17 @@ void UPersistentStateManager_LevelActors::SaveState()
 			SaveLevel(LevelState, bFromLevelStreaming);
 		}
 	}
+
+	// release world dependencies that are no longer referenced by any level state
+	TBitArray<> ReferencedDependencies{false, DependencyTable.NumDependencies() + 1};
+	for (auto& [LevelName, LevelState]: Levels)
+	{
+		for (const int32 Index: LevelState.Dependencies)
+		{
+			ReferencedDependencies[Index] = true;
+		}
+	}
+	DependencyTable.ReleaseUnreferenced(ReferencedDependencies);
 }
 
 void UPersistentStateManager_LevelActors::AddDestroyedObject(const FPersistentStateObjectId& ObjectId)
@@ -1050,8 +1930,8 @@ void UPersistentStateManager_LevelActors::AddDestroyedObject(const FPersistentSt
 
 void UPersistentStateManager_LevelActors::SaveLevel(FLevelPersistentState& LevelState, bool bFromLevelStreaming)
 {
-	// reset hard dependencies
-	LevelState.DependencyTracker.Reset();
+	// reset level dependencies, dependency table itself is never reset as other level states reference it by index
+	LevelState.Dependencies.Reset();
 	if (LevelState.IsEmpty())
 	{
 		return;
@@ -1062,13 +1942,17 @@ void UPersistentStateManager_LevelActors::SaveLevel(FLevelPersistentState& Level
 	check(Level && LevelState.bLevelInitialized == true);
 	FScopeCycleCounterUObject Scope{Level};
 	
-	FLevelSaveContext SaveContext = LevelState.CreateSaveContext(bFromLevelStreaming);
+	FLevelSaveContext SaveContext = LevelState.CreateSaveContext(DependencyTable, bFromLevelStreaming);
+	// collect world dependencies referenced by the level state
+	FPersistentStateObjectTracker::FCollectReferencesScope DependencyScope{DependencyTable.Tracker, LevelState.Dependencies};
 
 	// finish async asset loading and spawn dynamic actors
 	LevelState.FinishLoadAssets();
-	for (auto It = LevelState.Actors.CreateIterator(); It; ++It)
+	// iterate backwards, so that removing actor state swaps in already processed state
+	for (int32 ActorIndex = LevelState.Actors.Num() - 1; ActorIndex >= 0; --ActorIndex)
 	{
-		auto& [ActorId, ActorState] = *It;
+		FActorPersistentState& ActorState = LevelState.Actors[ActorIndex];
+		const FPersistentStateObjectId ActorId = ActorState.GetHandle();
 		if (ActorState.IsLinked())
 		{
 			ActorState.SaveActor(SaveContext);
@@ -1089,10 +1973,13 @@ void UPersistentStateManager_LevelActors::SaveLevel(FLevelPersistentState& Level
 			OutdatedObjects.Add(ActorId);
             			
 			// remove outdated actor state
-			It.RemoveCurrent();
+			LevelState.RemoveActorStateAt(ActorIndex);
 		}
 	}
 
+	// release arena data of the previous level save
+	LevelState.CompactArena();
+
 	// append outdated objects
 	OutdatedObjects.Append(SaveContext.OutdatedObjects);
 	SET_DWORD_STAT(STAT_PersistentState_OutdatedObjects, OutdatedObjects.Num());
@@ -1123,7 +2010,7 @@ void UPersistentStateManager_LevelActors::InitializeLevel(ULevel* Level, bool bF
 	static TArray<AActor*> PendingDestroyActors;
 	PendingDestroyActors.Reset();
 	
-	FLevelLoadContext Context = LevelState.CreateLoadContext();
+	FLevelLoadContext Context = LevelState.CreateLoadContext(DependencyTable);
 	
 	// create object identifiers for level static actors
 	for (AActor* Actor: Level->Actors)
@@ -1194,7 +2081,7 @@ void UPersistentStateManager_LevelActors::InitializeLevel(ULevel* Level, bool bF
 	// actor classes and other asset dependencies may or may not be loaded when level becomes visible
 	// LevelState requests async load for asset dependencies required to properly restore level state
 	// if no loading required, dynamic actors are created right away, but AFTER we process static actors on the level
-	LevelState.PreLoadAssets(FStreamableDelegate::CreateUObject(this, &ThisClass::CreateDynamicActors, Level));
+	LevelState.PreLoadAssets(DependencyTable, FStreamableDelegate::CreateUObject(this, &ThisClass::CreateDynamicActors, Level));
 	
 	for (AActor* Actor: PendingDestroyActors)
 	{
@@ -1214,7 +2101,7 @@ void UPersistentStateManager_LevelActors::CreateDynamicActors(ULevel* Level)
 		return;
 	}
 	
-	FLevelLoadContext Context = LevelState.CreateLoadContext();
+	FLevelLoadContext Context = LevelState.CreateLoadContext(DependencyTable);
 	
 	FActorSpawnParameters SpawnParams{};
 	SpawnParams.bNoFail = true;
@@ -1227,9 +2114,11 @@ void UPersistentStateManager_LevelActors::CreateDynamicActors(ULevel* Level)
 	FGuardValue_Bitfield(bCreatingDynamicActors, true);
 	
 	TArray<FPersistentStateObjectId, TInlineAllocator<16>> OutdatedActors;
-	for (auto It = LevelState.Actors.CreateIterator(); It; ++It)
+	// iterate backwards, so that removing actor state swaps in already processed state.
+	// Actor states created while dynamic actors are spawned are appended to the end and are already linked
+	for (int32 ActorIndex = LevelState.Actors.Num() - 1; ActorIndex >= 0; --ActorIndex)
 	{
-		FActorPersistentState& ActorState = It.Value();
+		FActorPersistentState& ActorState = LevelState.Actors[ActorIndex];
 		
 		if (ActorState.IsStatic() || ActorState.IsLinked())
 		{
@@ -1239,7 +2128,7 @@ void UPersistentStateManager_LevelActors::CreateDynamicActors(ULevel* Level)
 		if (!ActorState.IsSaved())
 		{
 			// remove dynamic actor state because it cannot be re-created
-			It.RemoveCurrent();
+			LevelState.RemoveActorStateAt(ActorIndex);
 			continue;
 		}
 
@@ -1248,7 +2137,7 @@ void UPersistentStateManager_LevelActors::CreateDynamicActors(ULevel* Level)
 		if (ActorState.IsOutdated())
 		{
 			OutdatedActors.Add(ActorId);
-			It.RemoveCurrent();
+			LevelState.RemoveActorStateAt(ActorIndex);
 			continue;
 		}
 #endif
@@ -1256,18 +2145,19 @@ void UPersistentStateManager_LevelActors::CreateDynamicActors(ULevel* Level)
 		AActor* DynamicActor = ActorState.GetHandle().ResolveObject<AActor>();
 		if (DynamicActor == nullptr)
 		{
-			SpawnParams.CustomPreSpawnInitalization = [&ActorState, &Context, this](AActor* DynamicActor)
+			// actor states can be reallocated by actors spawned during dynamic actor creation, access actor state by index
+			SpawnParams.CustomPreSpawnInitalization = [&LevelState, ActorIndex, &Context, this](AActor* DynamicActor)
 			{
 				CurrentlyProcessedActor = DynamicActor;
-				InitializeActorComponents(*DynamicActor, ActorState, Context);
+				InitializeActorComponents(*DynamicActor, LevelState.Actors[ActorIndex], Context);
 			};
 			// dynamically spawned actors have fully registered components after spawn regardless of the owning world state
 			// we process static native components and spawn dynamically created components in PreSpawnInitialization callback
 			// SCS spawned components are going to be processed right after actor initialization with NotifyInitialized() callback
-			DynamicActor = ActorState.CreateDynamicActor(World, SpawnParams);
+			DynamicActor = LevelState.CreateDynamicActor(ActorIndex, Context, World, SpawnParams);
 			check(DynamicActor);
 
-			Context.AddCreatedActor(ActorState);
+			Context.AddCreatedActor(LevelState.Actors[ActorIndex]);
 			CurrentlyProcessedActor = nullptr;
 		}
 	}
@@ -1388,7 +2278,7 @@ void UPersistentStateManager_LevelActors::InitializeActorComponents(AActor& Acto
 		}
 #endif
 		
-		UActorComponent* Component = ComponentState.CreateDynamicComponent(&Actor);
+		UActorComponent* Component = ComponentState.CreateDynamicComponent(Context, &Actor);
 		check(Component);
 
 		Context.AddCreatedComponent(ComponentState);
@@ -1456,7 +2346,7 @@ void UPersistentStateManager_LevelActors::OnLevelBecomeInvisible(UWorld* World,
 			SaveLevel(*LevelState, bFromLevelStreaming);
 
 			// release level assets
-			LevelState->ReleaseLevelAssets();
+			LevelState->ReleaseLevelAssets(DependencyTable);
 
 			LevelState->bLevelAdded = false;
 			LevelState->bLevelInitialized = false;
@@ -1528,7 +2418,7 @@ void UPersistentStateManager_LevelActors::OnActorInitialized(AActor* Actor)
 	// finish loading assets if it is not done yet
 	LevelState.FinishLoadAssets();
 	
-	FLevelLoadContext LoadContext = LevelState.CreateLoadContext();
+	FLevelLoadContext LoadContext = LevelState.CreateLoadContext(DependencyTable);
 	FActorPersistentState* ActorState = nullptr;
 	
 	{
@@ -1566,20 +2456,19 @@ void UPersistentStateManager_LevelActors::OnActorDestroyed(AActor* Actor)
 	}
 		
 	// remove ActorState for destroyed actor
-	LevelState.Actors.Remove(ActorId);
+	LevelState.RemoveActorState(ActorId);
 }
 
 void UPersistentStateManager_LevelActors::UpdateStats() const
 {
 #if STATS
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
-	int32 NumLevels{Levels.Num()}, NumActors{0}, NumComponents{0}, NumDependencies{0};
+	int32 NumLevels{Levels.Num()}, NumActors{0}, NumComponents{0}, NumDependencies{DependencyTable.NumDependencies()};
 	for (auto& [LevelId, LevelState]: Levels)
 	{
 		NumActors += LevelState.Actors.Num();
-		NumDependencies += LevelState.DependencyTracker.NumValues();
 		
-		for (auto& [ActorId, ActorState]: LevelState.Actors)
+		for (const FActorPersistentState& ActorState: LevelState.Actors)
 		{
 			NumComponents += ActorState.Components.Num();
 		}
@@ -1591,6 +2480,9 @@ void UPersistentStateManager_LevelActors::UpdateStats() const
 	SET_DWORD_STAT(STAT_PersistentState_NumActors, NumActors);
 	SET_DWORD_STAT(STAT_PersistentState_NumComponents, NumComponents);
 	SET_DWORD_STAT(STAT_PersistentState_NumDependencies, NumDependencies);
+	SET_DWORD_STAT(STAT_PersistentState_SharedDefaultStates, UE::PersistentState::Private::FDefaultStateStore::Get().Num());
+	// shared default states are global, so they're reported once instead of being added to the manager memory
+	SET_MEMORY_STAT(STAT_PersistentState_SharedDefaultStatesMemory, UE::PersistentState::Private::FDefaultStateStore::Get().GetAllocatedSize());
 	INC_DWORD_STAT_BY(STAT_PersistentState_NumObjects, NumActors + NumComponents);
 #endif
 }
@@ -1603,6 +2495,7 @@ uint32 UPersistentStateManager_LevelActors::GetAllocatedSize() const
 	TotalMemory += DestroyedObjects.GetAllocatedSize();
 	TotalMemory += OutdatedObjects.GetAllocatedSize();
 	TotalMemory += Levels.GetAllocatedSize();
+	TotalMemory += DependencyTable.GetAllocatedSize();
 
 	for (const auto& [LevelId, LevelState]: Levels)
 	{
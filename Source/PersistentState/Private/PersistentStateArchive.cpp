@@ -4,18 +4,40 @@
 
 uint64 FPersistentStateObjectTracker::SaveValue(const FSoftObjectPath& Value)
 {
-	if (int32* Index = ValueMap.Find(Value))
+	if (IsValueMapDirty())
 	{
-		check(Values.Contains(Value));
-		return *Index;
+		CacheValueMap();
+	}
+	
+	int32 Index = INDEX_NONE;
+	if (int32* ExistingIndex = ValueMap.Find(Value))
+	{
+		checkSlow(Values.Contains(Value));
+		Index = *ExistingIndex;
+	}
+	else
+	{
+		checkSlow(!Values.Contains(Value));
+		if (!FreeIndices.IsEmpty())
+		{
+			// reuse released index, so that tracker doesn't grow with values that are no longer referenced
+			Index = FreeIndices.Pop(false);
+			Values[Index - 1] = Value;
+			--NumReleasedValues;
+		}
+		else
+		{
+			Index = Values.Add(Value) + 1;
+		}
+		ValueMap.Add(Value, Index);
+	}
+
+	if (ReferenceCollector != nullptr)
+	{
+		ReferenceCollector->AddReference(Index);
 	}
 		
-	check(!Values.Contains(Value));
-		
-	int32 Index = Values.Add(Value);
-	ValueMap.Add(Value, Index + 1);
-		
-	return Index + 1;
+	return Index;
 }
 
 FSoftObjectPath FPersistentStateObjectTracker::LoadValue(uint64 Index)
@@ -24,28 +46,85 @@ FSoftObjectPath FPersistentStateObjectTracker::LoadValue(uint64 Index)
 	return Values[Index - 1];
 }
 
+uint64 FPersistentStateObjectTracker::FindValue(const FSoftObjectPath& Value)
+{
+	if (IsValueMapDirty())
+	{
+		CacheValueMap();
+	}
+
+	const int32* Index = ValueMap.Find(Value);
+	return Index != nullptr ? *Index : 0;
+}
+
+void FPersistentStateObjectTracker::ReleaseValue(int32 Index)
+{
+	check(Values.IsValidIndex(Index - 1));
+	if (IsValueMapDirty())
+	{
+		CacheValueMap();
+	}
+	
+	FSoftObjectPath& Value = Values[Index - 1];
+	if (!Value.IsNull())
+	{
+		ValueMap.Remove(Value);
+		Value.Reset();
+		FreeIndices.Add(Index);
+		++NumReleasedValues;
+	}
+}
+
+void FPersistentStateObjectTracker::CacheValueMap()
+{
+	ValueMap.Reset();
+	ValueMap.Reserve(Values.Num());
+	FreeIndices.Reset();
+	NumReleasedValues = 0;
+	for (int32 Index = 0; Index < Values.Num(); ++Index)
+	{
+		// released values are stored as empty object paths
+		if (Values[Index].IsNull())
+		{
+			FreeIndices.Add(Index + 1);
+			++NumReleasedValues;
+		}
+		else
+		{
+			ValueMap.Add(Values[Index], Index + 1);
+		}
+	}
+}
+
 template <bool bLoading>
-uint64 FPersistentStateStringTracker<bLoading>::SaveValue(const FString& Value) requires !bLoading
+uint64 FPersistentStateStringTracker<bLoading>::SaveValue(FName Value) requires !bLoading
 {
 	if (int32* Index = ValueMap.Find(Value))
 	{
-		check(Values.Contains(Value));
 		return *Index;
 	}
-		
-	check(!Values.Contains(Value));
-		
-	int32 Index = Values.Add(Value);
+	
+	int32 Index = Values.Add(Value.ToString());
 	ValueMap.Add(Value, Index + 1);
 		
 	return Index + 1;
 }
 
 template <bool bLoading>
-FString FPersistentStateStringTracker<bLoading>::LoadValue(uint64 Index) requires bLoading
+FName FPersistentStateStringTracker<bLoading>::LoadValue(uint64 Index) const requires bLoading
 {
-	check(Values.IsValidIndex(Index - 1));
-	return Values[Index - 1];
+	check(Names.IsValidIndex(Index - 1));
+	return Names[Index - 1];
+}
+
+template <bool bLoading>
+void FPersistentStateStringTracker<bLoading>::CacheNames() requires bLoading
+{
+	Names.Reset(Values.Num());
+	for (const FString& Value: Values)
+	{
+		Names.Add(FName{Value});
+	}
 }
 
 template struct FPersistentStateStringTracker<true>;
@@ -79,12 +158,11 @@ FArchive& FPersistentStateStringTrackerProxy<bLoading>::operator<<(FName& Name)
 		const uint64 Index = ReadVarUIntFromArchive(InnerArchive);
 		check(Index != 0);
 
-		FString Str = StringTracker.LoadValue(Index);
-		Name = FName{Str};
+		Name = StringTracker.LoadValue(Index);
 	}
 	else
 	{
-		const uint64 Index = StringTracker.SaveValue(Name.ToString());
+		const uint64 Index = StringTracker.SaveValue(Name);
 		check(Index != 0);
 		
 		WriteVarUIntToArchive(InnerArchive, Index);
@@ -259,3 +337,168 @@ template struct FPersistentStateObjectTrackerProxy<true, ESerializeObjectDepende
 template struct FPersistentStateObjectTrackerProxy<false, ESerializeObjectDependency::Soft>;
 template struct FPersistentStateObjectTrackerProxy<false, ESerializeObjectDependency::Hard>;
 template struct FPersistentStateObjectTrackerProxy<false, ESerializeObjectDependency::All>;
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+void FPersistentStateStateArchive<bLoading, DependencyMode>::WriteTables(uint32& OutObjectTablePosition, uint32& OutStringTablePosition) requires !bLoading
+{
+	FArchive& Ar = *this;
+	OutObjectTablePosition = Ar.Tell();
+	
+	int32 Num = ObjectTracker.NumValues();
+	Ar << Num;
+	
+	// soft object paths are serialized as string, so they are caught by a string tracker
+	for (FSoftObjectPath& Obj: ObjectTracker.GetValues())
+	{
+		Obj.SerializePath(Ar);
+	}
+
+	OutStringTablePosition = Ar.Tell();
+	InnerArchive << StringTracker;
+}
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+void FPersistentStateStateArchive<bLoading, DependencyMode>::ReadTables(int32 ObjectTablePosition, int32 StringTablePosition) requires bLoading
+{
+	FArchive& Ar = *this;
+	const int32 CurrentPosition = Ar.Tell();
+
+	// string table is read first, as object table references it
+	Ar.Seek(StringTablePosition);
+	InnerArchive << StringTracker;
+	
+	Ar.Seek(ObjectTablePosition);
+	int32 Num{};
+	Ar << Num;
+
+	ObjectTracker.Values.SetNum(Num);
+	for (FSoftObjectPath& Obj: ObjectTracker.Values)
+	{
+		Obj.SerializePath(Ar);
+	}
+
+	Ar.Seek(CurrentPosition);
+}
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+FArchive& FPersistentStateStateArchive<bLoading, DependencyMode>::operator<<(FName& Name)
+{
+	if constexpr (bLoading)
+	{
+		const uint64 Index = ReadVarUIntFromArchive(InnerArchive);
+		check(Index != 0);
+
+		Name = StringTracker.LoadValue(Index);
+	}
+	else
+	{
+		const uint64 Index = StringTracker.SaveValue(Name);
+		check(Index != 0);
+		
+		WriteVarUIntToArchive(InnerArchive, Index);
+	}
+
+	return *this;
+}
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+FArchive& FPersistentStateStateArchive<bLoading, DependencyMode>::operator<<(UObject*& Obj)
+{
+	if constexpr (DependencyMode & ESerializeObjectDependency::Hard)
+	{
+		if constexpr (bLoading)
+		{
+			// if this is 0, then it wasn't a top level asset
+			if (const uint64 Index = ReadVarUIntFromArchive(InnerArchive); Index != 0)
+			{
+				FSoftObjectPath ObjectPath = ObjectTracker.LoadValue(Index);
+				check(ObjectPath.IsValid());
+			
+				UObject* Object = ObjectPath.ResolveObject();
+				check(Object);
+
+				Obj = Object;
+				return *this;
+			}
+		}
+		else
+		{
+			if (UObject* Object = Obj; Object && FAssetData::IsTopLevelAsset(Object))
+			{
+				uint64 ObjectIndex = ObjectTracker.SaveValue(FSoftObjectPath{Object});
+				check(ObjectIndex != 0);
+			
+				WriteVarUIntToArchive(InnerArchive, ObjectIndex);
+				return *this;
+			}
+			
+			WriteVarUIntToArchive(InnerArchive, 0ULL);
+		}
+	}
+
+	// object is serialized by unique object id or by path
+	return FPersistentStateProxyArchive::operator<<(Obj);
+}
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+FArchive& FPersistentStateStateArchive<bLoading, DependencyMode>::operator<<(FSoftObjectPtr& Value)
+{
+	if constexpr (DependencyMode & ESerializeObjectDependency::Soft)
+	{
+		if constexpr (bLoading)
+		{
+			const uint64 Index = ReadVarUIntFromArchive(InnerArchive);
+			check(Index != 0);
+
+			Value = ObjectTracker.LoadValue(Index);
+		}
+		else
+		{
+			uint64 ObjectIndex = ObjectTracker.SaveValue(Value.GetUniqueID());
+			check(ObjectIndex != 0);
+
+			WriteVarUIntToArchive(InnerArchive, ObjectIndex);
+		}
+		
+		return *this;
+	}
+	else
+	{
+		return FPersistentStateProxyArchive::operator<<(Value);
+	}
+}
+
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+FArchive& FPersistentStateStateArchive<bLoading, DependencyMode>::operator<<(FSoftObjectPath& Value)
+{
+	if constexpr (DependencyMode & ESerializeObjectDependency::Soft)
+	{
+		if constexpr (bLoading)
+		{
+			const uint64 Index = ReadVarUIntFromArchive(InnerArchive);
+			check(Index != 0);
+			
+			Value = ObjectTracker.LoadValue(Index);
+		}
+		else
+		{
+			uint64 ObjectIndex = ObjectTracker.SaveValue(Value);
+			check(ObjectIndex != 0);
+
+			WriteVarUIntToArchive(InnerArchive, ObjectIndex);
+		}
+
+		return *this;
+	}
+	else
+	{
+		return FPersistentStateProxyArchive::operator<<(Value);
+	}
+}
+
+template struct FPersistentStateStateArchive<true, ESerializeObjectDependency::Soft>;
+template struct FPersistentStateStateArchive<true, ESerializeObjectDependency::Hard>;
+template struct FPersistentStateStateArchive<true, ESerializeObjectDependency::All>;
+template struct FPersistentStateStateArchive<false, ESerializeObjectDependency::Soft>;
+template struct FPersistentStateStateArchive<false, ESerializeObjectDependency::Hard>;
+template struct FPersistentStateStateArchive<false, ESerializeObjectDependency::All>;
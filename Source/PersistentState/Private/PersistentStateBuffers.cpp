@@ -0,0 +1,332 @@
+#include "PersistentStateBuffers.h"
+
+#include "PersistentStateCVars.h"
+#include "PersistentStateModule.h"
+#include "Hash/CityHash.h"
+#include "Managers/PersistentStateManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+FPersistentStateBufferPool FPersistentStateBufferPool::Instance;
+
+TArray<uint8> FPersistentStateBufferPool::Acquire(int32 MinCapacity)
+{
+	TArray<uint8> Result;
+	{
+		FScopeLock Lock{&CriticalSection};
+		if (!Buffers.IsEmpty())
+		{
+			// prefer the smallest buffer that fits requested capacity, otherwise take the largest one
+			int32 BestIndex = 0;
+			for (int32 Index = 1; Index < Buffers.Num(); ++Index)
+			{
+				const int32 Capacity = Buffers[Index].Max();
+				const int32 BestCapacity = Buffers[BestIndex].Max();
+				
+				const bool bFits = Capacity >= MinCapacity;
+				const bool bBestFits = BestCapacity >= MinCapacity;
+				if (bFits ? (!bBestFits || Capacity < BestCapacity) : (!bBestFits && Capacity > BestCapacity))
+				{
+					BestIndex = Index;
+				}
+			}
+
+			Result = MoveTemp(Buffers[BestIndex]);
+			Buffers.RemoveAtSwap(BestIndex, 1, false);
+			RetainedSize -= Result.Max();
+		}
+	}
+
+	Result.Reserve(MinCapacity);
+	return Result;
+}
+
+void FPersistentStateBufferPool::Release(TArray<uint8>&& Buffer)
+{
+	// drop slack left by buffer growth, so that pool retains only memory that was actually used. Empty buffers keep
+	// their capacity, as their used size is unknown
+	const int32 UsedSize = Buffer.Num();
+	const int32 TargetCapacity = UsedSize > 0 && Buffer.Max() - UsedSize > UsedSize / 4 ? UsedSize : Buffer.Max();
+	
+	const int64 MaxRetainedSize = static_cast<int64>(FMath::Max(UE::PersistentState::GPersistentState_BufferPoolMaxSize, 0)) * 1024;
+	if (TargetCapacity == 0 || TargetCapacity > MaxRetainedSize)
+	{
+		// buffer is not retained
+		return;
+	}
+
+	// buffer contents are stale, drop them before reallocating to the target capacity
+	Buffer.Reset();
+	if (TargetCapacity < Buffer.Max())
+	{
+		Buffer.Empty(TargetCapacity);
+	}
+	
+	const int64 Capacity = Buffer.Max();
+	
+	FScopeLock Lock{&CriticalSection};
+	if (Buffers.Num() < UE::PersistentState::GPersistentState_BufferPoolSize && RetainedSize + Capacity <= MaxRetainedSize)
+	{
+		RetainedSize += Capacity;
+		Buffers.Add(MoveTemp(Buffer));
+		return;
+	}
+
+	// pool is full, replace the smallest buffer as long as pool stays within its memory budget
+	int32 SmallestIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < Buffers.Num(); ++Index)
+	{
+		if (SmallestIndex == INDEX_NONE || Buffers[Index].Max() < Buffers[SmallestIndex].Max())
+		{
+			SmallestIndex = Index;
+		}
+	}
+
+	if (SmallestIndex != INDEX_NONE && Buffers[SmallestIndex].Max() < Capacity && RetainedSize - Buffers[SmallestIndex].Max() + Capacity <= MaxRetainedSize)
+	{
+		RetainedSize += Capacity - Buffers[SmallestIndex].Max();
+		Buffers[SmallestIndex] = MoveTemp(Buffer);
+	}
+}
+
+void FPersistentStateBufferPool::Reset()
+{
+	FScopeLock Lock{&CriticalSection};
+	Buffers.Empty();
+	RetainedSize = 0;
+}
+
+SIZE_T FPersistentStateBufferPool::GetAllocatedSize() const
+{
+	FScopeLock Lock{&CriticalSection};
+	
+	SIZE_T Result = Buffers.GetAllocatedSize();
+	for (const TArray<uint8>& Buffer: Buffers)
+	{
+		Result += Buffer.GetAllocatedSize();
+	}
+
+	return Result;
+}
+
+int32 FPersistentStateSizeEstimate::EstimateStateSize(FName State, TConstArrayView<UPersistentStateManager*> Managers) const
+{
+	if (const int32* Size = StateSizes.Find(State))
+	{
+		return *Size;
+	}
+
+	int32 Result = 0;
+	for (const UPersistentStateManager* Manager: Managers)
+	{
+		Result += ManagerSizes.FindRef(Manager->GetClass()->GetFName());
+	}
+
+	return Result;
+}
+
+void FPersistentStateSizeEstimate::AddStateSample(FName State, int32 Size)
+{
+	AddSample(StateSizes, State, Size);
+}
+
+void FPersistentStateSizeEstimate::AddManagerSample(const UPersistentStateManager* Manager, int32 Size)
+{
+	AddSample(ManagerSizes, Manager->GetClass()->GetFName(), Size);
+}
+
+void FPersistentStateSizeEstimate::AddSample(TMap<FName, int32>& Sizes, FName Key, int32 Size)
+{
+	int32& Estimate = Sizes.FindOrAdd(Key, 0);
+	// grow to the largest sample, decay by a quarter of the difference towards smaller samples
+	Estimate = Size >= Estimate ? Size : Estimate - (Estimate - Size) / 4;
+}
+
+namespace UE::PersistentState::Private
+{
+	/** content-defined chunk size limits */
+	constexpr int32 MinChunkSize = 64;
+	constexpr int32 MaxChunkSize = 4096;
+	/** chunk boundary mask, uses high bits so that boundary depends on a wider window of preceding bytes. Average chunk is ~256 bytes */
+	constexpr uint64 ChunkMask = 0xFFull << 48;
+
+	enum class EDeltaOp: uint8
+	{
+		/** copy data range from the base state */
+		Copy,
+		/** literal data stored in the delta */
+		Literal
+	};
+
+	/** gear table for a rolling hash, generated from a fixed seed so that chunking is stable between runs */
+	struct FGearTable
+	{
+		FGearTable()
+		{
+			uint64 Seed = 0;
+			for (uint64& Value: Values)
+			{
+				// splitmix64
+				Seed += 0x9E3779B97F4A7C15;
+				uint64 Mix = Seed;
+				Mix = (Mix ^ (Mix >> 30)) * 0xBF58476D1CE4E5B9;
+				Mix = (Mix ^ (Mix >> 27)) * 0x94D049BB133111EB;
+				Value = Mix ^ (Mix >> 31);
+			}
+		}
+		
+		uint64 Values[256];
+	};
+	static const FGearTable GearTable;
+
+	/** @return size of the content-defined chunk that starts at @Offset */
+	int32 GetChunkSize(TConstArrayView<uint8> Data, int32 Offset)
+	{
+		const int32 MaxSize = FMath::Min(MaxChunkSize, Data.Num() - Offset);
+		uint64 Hash = 0;
+		for (int32 Index = 0; Index < MaxSize; ++Index)
+		{
+			Hash = (Hash << 1) + GearTable.Values[Data[Offset + Index]];
+			if (Index >= MinChunkSize && (Hash & ChunkMask) == 0)
+			{
+				return Index + 1;
+			}
+		}
+
+		return MaxSize;
+	}
+
+	uint64 GetChunkHash(TConstArrayView<uint8> Data, int32 Offset, int32 Size)
+	{
+		return CityHash64(reinterpret_cast<const char*>(Data.GetData() + Offset), Size);
+	}
+}
+
+TArray<uint8> FPersistentStateDelta::Create(TConstArrayView<uint8> Base, TConstArrayView<uint8> State)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	using namespace UE::PersistentState::Private;
+
+	// index base chunks by content, first occurrence is used for copy operations
+	TMap<uint64, TPair<int32, int32>> BaseChunks;
+	BaseChunks.Reserve(Base.Num() / 256);
+	for (int32 Offset = 0; Offset < Base.Num();)
+	{
+		const int32 Size = GetChunkSize(Base, Offset);
+		BaseChunks.FindOrAdd(GetChunkHash(Base, Offset, Size), {Offset, Size});
+		Offset += Size;
+	}
+
+	TArray<uint8> Delta = FPersistentStateBufferPool::Get().Acquire(0);
+	FMemoryWriter Writer{Delta};
+
+	int32 StateSize = State.Num();
+	Writer << StateSize;
+
+	// adjacent chunks are merged into a single operation
+	int32 CopyStart = 0, CopySize = 0;
+	int32 LiteralStart = 0, LiteralSize = 0;
+	auto FlushCopy = [&]
+	{
+		if (CopySize > 0)
+		{
+			EDeltaOp Op = EDeltaOp::Copy;
+			Writer << Op << CopyStart << CopySize;
+			CopySize = 0;
+		}
+	};
+	auto FlushLiteral = [&]
+	{
+		if (LiteralSize > 0)
+		{
+			EDeltaOp Op = EDeltaOp::Literal;
+			Writer << Op << LiteralSize;
+			Writer.Serialize(const_cast<uint8*>(State.GetData() + LiteralStart), LiteralSize);
+			LiteralSize = 0;
+		}
+	};
+	
+	for (int32 Offset = 0; Offset < State.Num();)
+	{
+		const int32 Size = GetChunkSize(State, Offset);
+		const TPair<int32, int32>* Chunk = BaseChunks.Find(GetChunkHash(State, Offset, Size));
+		if (Chunk != nullptr && Chunk->Value == Size && FMemory::Memcmp(Base.GetData() + Chunk->Key, State.GetData() + Offset, Size) == 0)
+		{
+			FlushLiteral();
+			if (CopySize == 0 || CopyStart + CopySize != Chunk->Key)
+			{
+				FlushCopy();
+				CopyStart = Chunk->Key;
+			}
+			CopySize += Size;
+		}
+		else
+		{
+			FlushCopy();
+			if (LiteralSize == 0)
+			{
+				LiteralStart = Offset;
+			}
+			LiteralSize += Size;
+		}
+		
+		Offset += Size;
+	}
+	
+	FlushCopy();
+	FlushLiteral();
+
+	return Delta;
+}
+
+bool FPersistentStateDelta::Apply(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, TArray<uint8>& OutState)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	using namespace UE::PersistentState::Private;
+	
+	FMemoryReaderView Reader{Delta};
+	
+	int32 StateSize = 0;
+	Reader << StateSize;
+	if (Reader.IsError() || StateSize < 0)
+	{
+		return false;
+	}
+
+	OutState = FPersistentStateBufferPool::Get().Acquire(StateSize);
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		EDeltaOp Op;
+		Reader << Op;
+		
+		if (Op == EDeltaOp::Copy)
+		{
+			int32 CopyStart = 0, CopySize = 0;
+			Reader << CopyStart << CopySize;
+			if (CopyStart < 0 || CopySize < 0 || CopyStart > Base.Num() - CopySize)
+			{
+				return false;
+			}
+			
+			OutState.Append(Base.GetData() + CopyStart, CopySize);
+		}
+		else if (Op == EDeltaOp::Literal)
+		{
+			int32 LiteralSize = 0;
+			Reader << LiteralSize;
+			if (LiteralSize < 0 || LiteralSize > Reader.TotalSize() - Reader.Tell())
+			{
+				return false;
+			}
+
+			const int32 LiteralStart = OutState.AddUninitialized(LiteralSize);
+			Reader.Serialize(OutState.GetData() + LiteralStart, LiteralSize);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return !Reader.IsError() && OutState.Num() == StateSize;
+}
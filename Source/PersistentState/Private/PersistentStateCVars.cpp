@@ -62,6 +62,46 @@ namespace UE::PersistentState
 		ECVF_Default
 	);
 
+	bool GPersistentStateStorage_PrefetchLastSavedWorld = false;
+	FAutoConsoleVariableRef PersistentStateStorage_PrefetchLastSavedWorld(
+		TEXT("PersistentState.PrefetchLastSavedWorld"),
+		GPersistentStateStorage_PrefetchLastSavedWorld,
+		TEXT("Values true/false, false by default."),
+		ECVF_Default
+	);
+
+	bool GPersistentState_AutoPrefetch = false;
+	FAutoConsoleVariableRef PersistentState_AutoPrefetch(
+		TEXT("PersistentState.AutoPrefetch"),
+		GPersistentState_AutoPrefetch,
+		TEXT("Values true/false, false by default."),
+		ECVF_Default
+	);
+
+	bool GPersistentStateStorage_AsyncFileRead = true;
+	FAutoConsoleVariableRef PersistentStateStorage_AsyncFileRead(
+		TEXT("PersistentState.AsyncFileRead"),
+		GPersistentStateStorage_AsyncFileRead,
+		TEXT("Values true/false, true by default."),
+		ECVF_Default
+	);
+
+	bool GPersistentStateStorage_BlockStore = false;
+	FAutoConsoleVariableRef PersistentStateStorage_BlockStore(
+		TEXT("PersistentState.BlockStore"),
+		GPersistentStateStorage_BlockStore,
+		TEXT("Values true/false, false by default."),
+		ECVF_Default
+	);
+
+	bool GPersistentStateStorage_MemoryFlushOnShutdown = false;
+	FAutoConsoleVariableRef PersistentStateStorage_MemoryFlushOnShutdown(
+		TEXT("PersistentState.MemoryFlushOnShutdown"),
+		GPersistentStateStorage_MemoryFlushOnShutdown,
+		TEXT("Values true/false, false by default."),
+		ECVF_Default
+	);
+
 	bool GPersistentState_SanitizeObjectReferences = true;
 	FAutoConsoleVariableRef PersistentState_SanitizeObjectReferences(
 		TEXT("PersistentState.SanitizeObjectReferences"),
@@ -77,6 +117,70 @@ namespace UE::PersistentState
 		TEXT("0 - Binary Formatter, default; 1 - Json Formatter; 2 - Xml Formatter."),
 	ECVF_Default
 	);
+
+	bool GPersistentState_SchemaSerialization = true;
+	FAutoConsoleVariableRef PersistentState_SchemaSerialization(
+		TEXT("PersistentState.SchemaSerialization"),
+		GPersistentState_SchemaSerialization,
+		TEXT("Values true/false, true by default."),
+		ECVF_Default
+	);
+
+	bool GPersistentState_ColumnarLevelEncoding = true;
+	FAutoConsoleVariableRef PersistentState_ColumnarLevelEncoding(
+		TEXT("PersistentState.ColumnarLevelEncoding"),
+		GPersistentState_ColumnarLevelEncoding,
+		TEXT("Values true/false, true by default."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_BufferPoolSize = 4;
+	FAutoConsoleVariableRef PersistentState_BufferPoolSize(
+		TEXT("PersistentState.BufferPoolSize"),
+		GPersistentState_BufferPoolSize,
+		TEXT("Max number of state buffers kept for reuse, 4 by default. 0 disables buffer pooling."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_BufferPoolMaxSize = 32768;
+	FAutoConsoleVariableRef PersistentState_BufferPoolMaxSize(
+		TEXT("PersistentState.BufferPoolMaxSize"),
+		GPersistentState_BufferPoolMaxSize,
+		TEXT("Max memory in KB retained by pooled state buffers, 32768 by default. Buffers that don't fit are freed on release."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_SaveWindowSize = 4096;
+	FAutoConsoleVariableRef PersistentState_SaveWindowSize(
+		TEXT("PersistentState.SaveWindowSize"),
+		GPersistentState_SaveWindowSize,
+		TEXT("Max amount of state data in KB that is compressed or copied at once while writing a slot file, 4096 by default."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_DeltaSaveThreshold = 25;
+	FAutoConsoleVariableRef PersistentState_DeltaSaveThreshold(
+		TEXT("PersistentState.DeltaSaveThreshold"),
+		GPersistentState_DeltaSaveThreshold,
+		TEXT("Max world state delta size in percent of its base state, requires block store. Larger deltas are saved as a new base state, 0 disables delta saves. 25 by default."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_StateCacheSize = 65536;
+	FAutoConsoleVariableRef PersistentState_StateCacheSize(
+		TEXT("PersistentState.StateCacheSize"),
+		GPersistentState_StateCacheSize,
+		TEXT("Memory budget in KB for cached game and world states, 65536 by default. Most recently used states are always cached."),
+		ECVF_Default
+	);
+
+	int32 GPersistentState_BackgroundBandwidth = 0;
+	FAutoConsoleVariableRef PersistentState_BackgroundBandwidth(
+		TEXT("PersistentState.BackgroundBandwidth"),
+		GPersistentState_BackgroundBandwidth,
+		TEXT("Max disk bandwidth in KB per second used by background saves, 0 by default. 0 disables throttling."),
+		ECVF_Default
+	);
 	
 #if !UE_BUILD_SHIPPING
 	FAutoConsoleCommandWithWorldAndArgs SaveGameToSlotCmd(
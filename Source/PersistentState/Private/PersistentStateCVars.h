@@ -16,12 +16,38 @@ namespace UE::PersistentState
 	extern bool GPersistentState_CanCreateWorldState;
 	/** If true, save/load operations run synchronously on game thread by default. Otherwise, UE tasks system is used */
 	extern bool GPersistentStateStorage_ForceGameThread;
-	/** If true, most recent game state and world state are cached */
+	/** If true, recently used game states and world states are cached */
 	extern bool GPersistentStateStorage_CacheSlotState;
+	/** If true, slot storage prefetches last saved world state of the most recently loaded slot into the state cache */
+	extern bool GPersistentStateStorage_PrefetchLastSavedWorld;
+	/** If true, world state is prefetched from the active slot for pending and seamless travel destinations */
+	extern bool GPersistentState_AutoPrefetch;
+	/** If true, slot storage reads game and world state via async file reads */
+	extern bool GPersistentStateStorage_AsyncFileRead;
+	/** If true, slot storage writes state data to a content-addressed block store shared between slots, slot files only reference blocks */
+	extern bool GPersistentStateStorage_BlockStore;
+	/** If true, memory storage flushes modified slots to slot files on shutdown */
+	extern bool GPersistentStateStorage_MemoryFlushOnShutdown;
 	/** If true, sanitizes outputs invalid object references to the log during saves, editor only */
 	extern bool GPersistentState_SanitizeObjectReferences;
 	/** formatter type */
 	extern int32 GPersistentState_FormatterType;
+	/** If true, SaveGame property bunches are serialized using class schema instead of tagged properties */
+	extern bool GPersistentState_SchemaSerialization;
+	/** If true, level states are serialized in columnar layout, grouping each object state field for all objects together */
+	extern bool GPersistentState_ColumnarLevelEncoding;
+	/** Max number of state buffers kept for reuse between saves and loads */
+	extern int32 GPersistentState_BufferPoolSize;
+	/** Max memory in kilobytes retained by pooled state buffers */
+	extern int32 GPersistentState_BufferPoolMaxSize;
+	/** Max amount of state data in kilobytes that is compressed or copied at once while writing a slot file */
+	extern int32 GPersistentState_SaveWindowSize;
+	/** Max world state delta size in percent of its base state, larger deltas are saved as a new base state. 0 disables delta saves */
+	extern int32 GPersistentState_DeltaSaveThreshold;
+	/** Memory budget in kilobytes for game and world states cached by the slot storage */
+	extern int32 GPersistentState_StateCacheSize;
+	/** Max disk bandwidth in kilobytes per second used by background saves. 0 means unlimited */
+	extern int32 GPersistentState_BackgroundBandwidth;
 	
 #if !UE_BUILD_SHIPPING
 	extern FAutoConsoleCommandWithWorldAndArgs SaveGameToSlotCmd;
@@ -0,0 +1,165 @@
+#include "PersistentStateCache.h"
+
+#include "PersistentStateCVars.h"
+#include "PersistentStateModule.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Cache Hits"),	STAT_PersistentState_StateCacheHits,	STATGROUP_PersistentState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("State Cache Misses"),	STAT_PersistentState_StateCacheMisses,	STATGROUP_PersistentState);
+
+FGameStateSharedRef FPersistentStateCache::FindGameState(FName Slot)
+{
+	if (FEntry* Entry = FindEntry(Slot, NAME_None))
+	{
+		INC_DWORD_STAT(STAT_PersistentState_StateCacheHits);
+		Entry->LastAccess = ++AccessCounter;
+		return Entry->GameState;
+	}
+
+	INC_DWORD_STAT(STAT_PersistentState_StateCacheMisses);
+	return {};
+}
+
+FWorldStateSharedRef FPersistentStateCache::FindWorldState(FName Slot, FName World)
+{
+	check(World != NAME_None);
+	if (FEntry* Entry = FindEntry(Slot, World))
+	{
+		INC_DWORD_STAT(STAT_PersistentState_StateCacheHits);
+		Entry->LastAccess = ++AccessCounter;
+		return Entry->WorldState;
+	}
+
+	INC_DWORD_STAT(STAT_PersistentState_StateCacheMisses);
+	return {};
+}
+
+bool FPersistentStateCache::HasWorldState(FName Slot, FName World) const
+{
+	return Entries.ContainsByPredicate([Slot, World](const FEntry& Entry)
+	{
+		return Entry.Slot == Slot && Entry.World == World;
+	});
+}
+
+void FPersistentStateCache::AddGameState(FName Slot, const FGameStateSharedRef& GameState)
+{
+	check(GameState.IsValid());
+	FEntry& Entry = AddEntry(Slot, NAME_None, GameState->GetAllocatedSize());
+	Entry.GameState = GameState;
+
+	Trim();
+}
+
+void FPersistentStateCache::AddWorldState(FName Slot, const FWorldStateSharedRef& WorldState)
+{
+	check(WorldState.IsValid());
+	FEntry& Entry = AddEntry(Slot, WorldState->Header.GetWorld(), WorldState->GetAllocatedSize());
+	Entry.WorldState = WorldState;
+
+	Trim();
+}
+
+void FPersistentStateCache::RemoveSlot(FName Slot)
+{
+	RemoveSlots([Slot](FName EntrySlot) { return EntrySlot != Slot; });
+}
+
+void FPersistentStateCache::RemoveSlots(TFunctionRef<bool(FName)> Predicate)
+{
+	const int32 NumRemoved = Entries.RemoveAllSwap([this, &Predicate](const FEntry& Entry)
+	{
+		if (!Predicate(Entry.Slot))
+		{
+			TotalSize -= Entry.Size;
+			return true;
+		}
+
+		return false;
+	});
+
+	if (NumRemoved > 0)
+	{
+		++InvalidationCount;
+	}
+}
+
+void FPersistentStateCache::Reset()
+{
+	if (!Entries.IsEmpty())
+	{
+		++InvalidationCount;
+	}
+
+	Entries.Empty();
+	TotalSize = 0;
+}
+
+SIZE_T FPersistentStateCache::GetAllocatedSize() const
+{
+	return Entries.GetAllocatedSize() + TotalSize;
+}
+
+FPersistentStateCache::FEntry* FPersistentStateCache::FindEntry(FName Slot, FName World)
+{
+	return Entries.FindByPredicate([Slot, World](const FEntry& Entry)
+	{
+		return Entry.Slot == Slot && Entry.World == World;
+	});
+}
+
+FPersistentStateCache::FEntry& FPersistentStateCache::AddEntry(FName Slot, FName World, SIZE_T Size)
+{
+	FEntry* Entry = FindEntry(Slot, World);
+	if (Entry == nullptr)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Slot = Slot;
+		Entry->World = World;
+	}
+
+	TotalSize = TotalSize - Entry->Size + Size;
+	Entry->Size = Size;
+	Entry->LastAccess = ++AccessCounter;
+
+	return *Entry;
+}
+
+void FPersistentStateCache::Trim()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+
+	const SIZE_T Budget = static_cast<SIZE_T>(FMath::Max(UE::PersistentState::GPersistentState_StateCacheSize, 0)) * 1024;
+	while (TotalSize > Budget)
+	{
+		// most recently used game state and world state are never evicted
+		int32 RecentGameState = INDEX_NONE, RecentWorldState = INDEX_NONE;
+		for (int32 Index = 0; Index < Entries.Num(); ++Index)
+		{
+			int32& Recent = Entries[Index].World == NAME_None ? RecentGameState : RecentWorldState;
+			if (Recent == INDEX_NONE || Entries[Index].LastAccess > Entries[Recent].LastAccess)
+			{
+				Recent = Index;
+			}
+		}
+
+		int32 EvictIndex = INDEX_NONE;
+		for (int32 Index = 0; Index < Entries.Num(); ++Index)
+		{
+			if (Index != RecentGameState && Index != RecentWorldState &&
+				(EvictIndex == INDEX_NONE || Entries[Index].LastAccess < Entries[EvictIndex].LastAccess))
+			{
+				EvictIndex = Index;
+			}
+		}
+
+		if (EvictIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		UE_LOG(LogPersistentState, Verbose, TEXT("%s: evicted state %s from slot %s."), *FString(__FUNCTION__),
+			*Entries[EvictIndex].World.ToString(), *Entries[EvictIndex].Slot.ToString());
+		TotalSize -= Entries[EvictIndex].Size;
+		Entries.RemoveAtSwap(EvictIndex);
+	}
+}
@@ -0,0 +1,612 @@
+#include "PersistentStateMemoryStorage.h"
+
+#include "PersistentStateCVars.h"
+#include "PersistentStateModule.h"
+#include "PersistentStateSettings.h"
+#include "PersistentStateSlotDescriptor.h"
+#include "PersistentStateStorageScheduler.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+using FMemoryFileRef = TSharedRef<TArray<uint8>, ESPMode::ThreadSafe>;
+using FMemoryFilePtr = TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe>;
+
+/**
+ * Memory files, indexed by file path. File contents are never modified after being written,
+ * so readers can keep reading a file that is being overwritten by a new save.
+ */
+struct FPersistentStateMemoryFiles
+{
+	FMemoryFilePtr Find(const FString& FilePath) const
+	{
+		FScopeLock Lock{&CriticalSection};
+		return Files.FindRef(FilePath);
+	}
+
+	bool Contains(const FString& FilePath) const
+	{
+		FScopeLock Lock{&CriticalSection};
+		return Files.Contains(FilePath);
+	}
+
+	void Write(const FString& FilePath, const FMemoryFileRef& File)
+	{
+		FScopeLock Lock{&CriticalSection};
+		Files.Add(FilePath, File);
+		DirtyFiles.Add(FilePath);
+		RemovedFiles.Remove(FilePath);
+	}
+
+	void Remove(const FString& FilePath)
+	{
+		FScopeLock Lock{&CriticalSection};
+		Files.Remove(FilePath);
+		DirtyFiles.Remove(FilePath);
+		RemovedFiles.Add(FilePath);
+	}
+
+	/** move out files modified and removed since the last call */
+	void PopChanges(TArray<TPair<FString, FMemoryFilePtr>>& OutDirtyFiles, TArray<FString>& OutRemovedFiles)
+	{
+		FScopeLock Lock{&CriticalSection};
+		for (const FString& FilePath: DirtyFiles)
+		{
+			OutDirtyFiles.Emplace(FilePath, Files.FindRef(FilePath));
+		}
+		OutRemovedFiles = RemovedFiles.Array();
+
+		DirtyFiles.Reset();
+		RemovedFiles.Reset();
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		FScopeLock Lock{&CriticalSection};
+		SIZE_T TotalSize = Files.GetAllocatedSize() + DirtyFiles.GetAllocatedSize() + RemovedFiles.GetAllocatedSize();
+		for (const auto& [FilePath, File]: Files)
+		{
+			TotalSize += FilePath.GetAllocatedSize() + File->GetAllocatedSize();
+		}
+
+		return TotalSize;
+	}
+
+private:
+	mutable FCriticalSection CriticalSection;
+	TMap<FString, FMemoryFilePtr> Files;
+	/** files modified since the last flush */
+	TSet<FString> DirtyFiles;
+	/** files removed since the last flush */
+	TSet<FString> RemovedFiles;
+};
+
+/** memory reader that keeps file contents alive */
+class FMemoryStorageReader: public FMemoryReader
+{
+public:
+	explicit FMemoryStorageReader(const FMemoryFileRef& InFile)
+		: FMemoryReader(*InFile, true)
+		, File(InFile)
+	{}
+
+private:
+	FMemoryFileRef File;
+};
+
+/** memory writer that writes to a new file and replaces old file contents when archive is closed */
+class FMemoryStorageWriter: public FMemoryWriter
+{
+public:
+	FMemoryStorageWriter(const TSharedRef<FPersistentStateMemoryFiles, ESPMode::ThreadSafe>& InFiles, const FString& InFilePath, const FMemoryFileRef& InFile)
+		: FMemoryWriter(*InFile, true)
+		, Files(InFiles)
+		, FilePath(InFilePath)
+		, File(InFile)
+	{}
+
+	virtual ~FMemoryStorageWriter() override
+	{
+		Files->Write(FilePath, File);
+	}
+
+private:
+	TSharedRef<FPersistentStateMemoryFiles, ESPMode::ThreadSafe> Files;
+	FString FilePath;
+	FMemoryFileRef File;
+};
+
+namespace UE::PersistentState::Private
+{
+	FArchiveFactory CreateMemoryReaderFactory(const TSharedRef<FPersistentStateMemoryFiles, ESPMode::ThreadSafe>& Files)
+	{
+		return [Files](const FString& FilePath) -> TUniquePtr<FArchive>
+		{
+			if (FMemoryFilePtr File = Files->Find(FilePath))
+			{
+				return MakeUnique<FMemoryStorageReader>(File.ToSharedRef());
+			}
+
+			return {};
+		};
+	}
+
+	FArchiveFactory CreateMemoryWriterFactory(const TSharedRef<FPersistentStateMemoryFiles, ESPMode::ThreadSafe>& Files)
+	{
+		return [Files](const FString& FilePath) -> TUniquePtr<FArchive>
+		{
+			FMemoryFileRef File = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+			if (FMemoryFilePtr OldFile = Files->Find(FilePath))
+			{
+				// new file size is likely to match the old one
+				File->Reserve(OldFile->Num());
+			}
+
+			return MakeUnique<FMemoryStorageWriter>(Files, FilePath, File);
+		};
+	}
+}
+
+UPersistentStateMemoryStorage::UPersistentStateMemoryStorage(const FObjectInitializer& Initializer)
+	: Super(Initializer)
+{
+
+}
+
+UPersistentStateMemoryStorage::UPersistentStateMemoryStorage(FVTableHelper& Helper)
+	: Super(Helper)
+{
+
+}
+
+void UPersistentStateMemoryStorage::Init()
+{
+	check(IsInGameThread());
+	check(NamedSlots.IsEmpty() && RuntimeSlots.IsEmpty());
+
+	const UPersistentStateSettings* Settings = UPersistentStateSettings::Get();
+	DefaultDescriptor = Settings->DefaultSlotDescriptor;
+	Files = MakeShared<FPersistentStateMemoryFiles, ESPMode::ThreadSafe>();
+
+	for (const FPersistentStateDefaultNamedSlot& Entry: Settings->DefaultNamedSlots)
+	{
+		NamedSlots.Add(MakeShared<FPersistentStateSlot>(Entry.SlotName, Entry.Title, Entry.Descriptor));
+	}
+}
+
+void UPersistentStateMemoryStorage::Shutdown()
+{
+	if (UE::PersistentState::GPersistentStateStorage_MemoryFlushOnShutdown)
+	{
+		FlushToFiles();
+	}
+
+	EnsureTaskCompletion();
+}
+
+uint32 UPersistentStateMemoryStorage::GetAllocatedSize() const
+{
+	uint32 TotalMemory = 0;
+#if STATS
+	TotalMemory += GetClass()->GetStructureSize();
+	TotalMemory += NamedSlots.GetAllocatedSize();
+	TotalMemory += RuntimeSlots.GetAllocatedSize();
+	TotalMemory += sizeof(FPersistentStateSlot) * (NamedSlots.Num() + RuntimeSlots.Num());
+
+	for (const FPersistentStateSlotSharedRef& StateSlot: NamedSlots)
+	{
+		TotalMemory += StateSlot->GetAllocatedSize();
+	}
+
+	for (const FPersistentStateSlotSharedRef& StateSlot: RuntimeSlots)
+	{
+		TotalMemory += StateSlot->GetAllocatedSize();
+	}
+
+	if (Files.IsValid())
+	{
+		TotalMemory += Files->GetAllocatedSize();
+	}
+#endif
+
+	return TotalMemory;
+}
+
+void UPersistentStateMemoryStorage::WaitUntilTasksComplete() const
+{
+	EnsureTaskCompletion();
+}
+
+void UPersistentStateMemoryStorage::EnsureTaskCompletion() const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// wait for ALL tasks to complete. last launched task requires all previous tasks to complete
+	FTaskGraphInterface::Get().WaitUntilTaskCompletes(LastQueuedEvent, ENamedThreads::GameThread);
+}
+
+FGraphEventArray UPersistentStateMemoryStorage::GetPrerequisites() const
+{
+	FGraphEventArray Prerequisites;
+	if (LastQueuedEvent.IsValid())
+	{
+		Prerequisites.Add(LastQueuedEvent);
+	}
+
+	return Prerequisites;
+}
+
+FGraphEventRef UPersistentStateMemoryStorage::SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority)
+{
+	check(IsInGameThread());
+	if (!GameState.IsValid() && !WorldState.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: both GameState and WorldState are invalid for %s: slot save request call."), *FString(__FUNCTION__), *TargetSlotHandle.ToString());
+		return {};
+	}
+
+	FPersistentStateSlotSharedRef SourceSlot = FindSlot(SourceSlotHandle.GetSlotName());
+	if (!SourceSlot.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: Source slot %s is no longer valid."), *FString(__FUNCTION__), *SourceSlotHandle.ToString());
+		return {};
+	}
+
+	FPersistentStateSlotSharedRef TargetSlot = FindSlot(TargetSlotHandle.GetSlotName());
+	if (!TargetSlot.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: Target slot %s is no longer valid."), *FString(__FUNCTION__), *TargetSlotHandle.ToString());
+		return {};
+	}
+
+	if (!TargetSlot->HasFilePath())
+	{
+		CreateStateSlotFile(TargetSlot, UPersistentStateSettings::Get()->GetSaveGameFilePath(TargetSlot->GetSlotName()));
+	}
+
+	// create save request with descriptor data
+	FPersistentStateSlotSaveRequest Request = FPersistentStateSlot::CreateSaveRequest(GetWorld(), *TargetSlot, TargetSlotHandle, GameState, WorldState);
+
+	// save is dispatched via storage scheduler with its priority class, same as slot storage saves
+	const FGraphEventArray Prerequisites = GetPrerequisites();
+	LastQueuedEvent = FPersistentStateStorageScheduler::Get().Dispatch(Priority, [Request, SourceSlot, TargetSlot, Files=Files.ToSharedRef()](const FGraphEventRef&)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UPersistentStateMemoryStorage_SaveState, PersistentStateChannel);
+
+		// memory files are replaced only after writer is closed, so target file can be written in place
+		constexpr bool bCanWriteToSourceFile = true;
+		TargetSlot->SaveState(
+			*SourceSlot, Request,
+			UE::PersistentState::Private::CreateMemoryReaderFactory(Files),
+			UE::PersistentState::Private::CreateMemoryWriterFactory(Files),
+			bCanWriteToSourceFile
+		);
+	}, Prerequisites);
+
+	if (CompletedDelegate.IsBound())
+	{
+		LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([CompletedDelegate]
+		{
+			CompletedDelegate.Execute();
+		}, TStatId{}, LastQueuedEvent, ENamedThreads::GameThread);
+	}
+
+	if (UPersistentStateSettings::Get()->UseGameThread())
+	{
+		EnsureTaskCompletion();
+	}
+
+	return LastQueuedEvent;
+}
+
+FGraphEventRef UPersistentStateMemoryStorage::LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad, FLoadCompletedDelegate CompletedDelegate)
+{
+	check(IsInGameThread());
+
+	FPersistentStateSlotSharedRef TargetSlot = FindSlot(TargetSlotHandle.GetSlotName());
+	if (!TargetSlot.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: Target slot %s is no longer valid."), *FString(__FUNCTION__), *TargetSlotHandle.ToString());
+		return {};
+	}
+
+	if (TargetSlot->HasFilePath() == false)
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: Trying to load world state %s from a slot %s that doesn't have associated file path."),
+			*FString(__FUNCTION__), *WorldToLoad.ToString(), *TargetSlotHandle.GetSlotName().ToString());
+		return {};
+	}
+
+	if (!TargetSlot->HasWorldState(WorldToLoad))
+	{
+		UE_LOG(LogPersistentState, Log, TEXT("%s: Failed to find world state for world %s, state slot %s"),
+			*FString(__FUNCTION__), *WorldToLoad.ToString(), *TargetSlotHandle.GetSlotName().ToString());
+		return {};
+	}
+
+	struct FLoadStateTaskData
+	{
+		FGameStateSharedRef GameState;
+		FWorldStateSharedRef WorldState;
+	};
+
+	TSharedRef<FLoadStateTaskData, ESPMode::ThreadSafe> TaskData = MakeShared<FLoadStateTaskData, ESPMode::ThreadSafe>();
+	const FGraphEventArray Prerequisites = GetPrerequisites();
+	LastQueuedEvent = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::InteractiveLoad, [TaskData, TargetSlot, WorldToLoad, Files=Files.ToSharedRef()](const FGraphEventRef&)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UPersistentStateMemoryStorage_LoadState, PersistentStateChannel);
+
+		constexpr bool bLoadGameState = true;
+		TargetSlot->LoadState(bLoadGameState, WorldToLoad, UE::PersistentState::Private::CreateMemoryReaderFactory(Files), TaskData->GameState, TaskData->WorldState);
+	}, Prerequisites);
+
+	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([TaskData, CompletedDelegate]
+	{
+		check(IsInGameThread());
+		if (CompletedDelegate.IsBound())
+		{
+			CompletedDelegate.Execute(TaskData->GameState, TaskData->WorldState);
+		}
+	}, TStatId{}, LastQueuedEvent, ENamedThreads::GameThread);
+
+	if (UPersistentStateSettings::Get()->UseGameThread())
+	{
+		EnsureTaskCompletion();
+	}
+
+	return LastQueuedEvent;
+}
+
+FGraphEventRef UPersistentStateMemoryStorage::UpdateAvailableStateSlots(FSlotUpdateCompletedDelegate CompletedDelegate)
+{
+	check(IsInGameThread());
+
+	// memory storage is the only source of state slots, there's nothing to discover
+	const FGraphEventArray Prerequisites = GetPrerequisites();
+	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, CompletedDelegate]
+	{
+		UPersistentStateMemoryStorage* Storage = WeakThis.Get();
+		if (Storage && CompletedDelegate.IsBound())
+		{
+			TArray<FPersistentStateSlotHandle> OutSlots;
+			Storage->GetAvailableStateSlots(OutSlots, false);
+
+			CompletedDelegate.Execute(OutSlots);
+		}
+	}, TStatId{}, &Prerequisites, ENamedThreads::GameThread);
+
+	if (UPersistentStateSettings::Get()->UseGameThread())
+	{
+		EnsureTaskCompletion();
+	}
+
+	return LastQueuedEvent;
+}
+
+FPersistentStateSlotHandle UPersistentStateMemoryStorage::CreateStateSlot(const FName& SlotName, const FText& Title, TSubclassOf<UPersistentStateSlotDescriptor> DescriptorClass)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	if (FPersistentStateSlotSharedRef Slot = FindSlot(SlotName); Slot.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: trying to create slot with name %s that already exists."), *FString(__FUNCTION__), *SlotName.ToString());
+		return FPersistentStateSlotHandle{*this, SlotName};
+	}
+
+	if (DescriptorClass == nullptr)
+	{
+		DescriptorClass = DefaultDescriptor;
+	}
+
+	FPersistentStateSlotSharedRef Slot = MakeShared<FPersistentStateSlot>(SlotName, Title, DescriptorClass);
+	RuntimeSlots.Add(Slot);
+
+	CreateStateSlotFile(Slot, UPersistentStateSettings::Get()->GetSaveGameFilePath(Slot->GetSlotName()));
+
+	return FPersistentStateSlotHandle{*this, SlotName};
+}
+
+void UPersistentStateMemoryStorage::GetAvailableStateSlots(TArray<FPersistentStateSlotHandle>& OutStates, bool bOnDiskOnly)
+{
+	OutStates.Reset(NamedSlots.Num() + RuntimeSlots.Num());
+	for (const FPersistentStateSlotSharedRef& Slot: NamedSlots)
+	{
+		if (!bOnDiskOnly || Slot->HasFilePath())
+		{
+			OutStates.Add(FPersistentStateSlotHandle{*this, Slot->GetSlotName()});
+		}
+	}
+
+	for (const FPersistentStateSlotSharedRef& Slot: RuntimeSlots)
+	{
+		OutStates.Add(FPersistentStateSlotHandle{*this, Slot->GetSlotName()});
+	}
+}
+
+UPersistentStateSlotDescriptor* UPersistentStateMemoryStorage::GetStateSlotDescriptor(const FPersistentStateSlotHandle& SlotHandle) const
+{
+	FPersistentStateSlotSharedRef StateSlot = FindSlot(SlotHandle.GetSlotName());
+	if (!StateSlot.IsValid())
+	{
+		return nullptr;
+	}
+
+	return StateSlot->CreateSerializedDescriptor(GetWorld(), *StateSlot, SlotHandle);
+}
+
+FPersistentStateSlotHandle UPersistentStateMemoryStorage::GetStateSlotByName(FName SlotName) const
+{
+	FPersistentStateSlotSharedRef Slot = FindSlot(SlotName);
+	if (Slot.IsValid())
+	{
+		return FPersistentStateSlotHandle{*this, Slot->GetSlotName()};
+	}
+
+	return FPersistentStateSlotHandle::InvalidHandle;
+}
+
+bool UPersistentStateMemoryStorage::CanLoadFromStateSlot(const FPersistentStateSlotHandle& SlotHandle, FName World) const
+{
+	FPersistentStateSlotSharedRef StateSlot = FindSlot(SlotHandle.GetSlotName());
+	if (!StateSlot.IsValid() || !HasStateSlotFile(StateSlot))
+	{
+		return false;
+	}
+
+	return World == NAME_None || StateSlot->HasWorldState(World);
+}
+
+bool UPersistentStateMemoryStorage::CanSaveToStateSlot(const FPersistentStateSlotHandle& SlotHandle, FName World) const
+{
+	bool bNamedSlot = false;
+	FPersistentStateSlotSharedRef StateSlot = FindSlot(SlotHandle.GetSlotName(), &bNamedSlot);
+	if (!StateSlot.IsValid())
+	{
+		return false;
+	}
+
+	// any world can be saved to any slot by default
+	return bNamedSlot || HasStateSlotFile(StateSlot);
+}
+
+FPersistentStateSlotHandle UPersistentStateMemoryStorage::DuplicateStateSlot(const FPersistentStateSlotHandle& SourceSlotHandle, FName SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// ensure that source slot is not modified by in progress saves
+	EnsureTaskCompletion();
+
+	FPersistentStateSlotSharedRef SourceSlot = FindSlot(SourceSlotHandle.GetSlotName());
+	if (!SourceSlot.IsValid() || !HasStateSlotFile(SourceSlot))
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: source slot %s doesn't have saved state."), *FString(__FUNCTION__), *SourceSlotHandle.ToString());
+		return {};
+	}
+
+	if (FindSlot(SlotName).IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: trying to create slot with name %s that already exists."), *FString(__FUNCTION__), *SlotName.ToString());
+		return {};
+	}
+
+	const FString FilePath = UPersistentStateSettings::Get()->GetSaveGameFilePath(SlotName);
+	RuntimeSlots.Add(MakeShared<FPersistentStateSlot>(SourceSlot->CreateDuplicate(SlotName, FilePath)));
+	// memory files are never modified after being written, so both slots share the same file contents until the next save
+	Files->Write(FilePath, Files->Find(SourceSlot->GetFilePath()).ToSharedRef());
+
+	return FPersistentStateSlotHandle{*this, SlotName};
+}
+
+void UPersistentStateMemoryStorage::RemoveStateSlot(const FPersistentStateSlotHandle& SlotHandle)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// ensure that save/load ops for the slot are completed before removing its memory file
+	EnsureTaskCompletion();
+
+	bool bNamedSlot = false;
+	FPersistentStateSlotSharedRef StateSlot = FindSlot(SlotHandle.GetSlotName(), &bNamedSlot);
+	if (!StateSlot.IsValid())
+	{
+		return;
+	}
+
+	if (StateSlot->HasFilePath())
+	{
+		Files->Remove(StateSlot->GetFilePath());
+	}
+
+	if (bNamedSlot)
+	{
+		// reset file data for named slots
+		StateSlot->ResetFileState();
+	}
+	else
+	{
+		// remove runtime slots entirely
+		RuntimeSlots.RemoveSwap(StateSlot);
+	}
+}
+
+FGraphEventRef UPersistentStateMemoryStorage::FlushToFiles()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	const FGraphEventArray Prerequisites = GetPrerequisites();
+	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Files=Files.ToSharedRef()]
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UPersistentStateMemoryStorage_FlushToFiles, PersistentStateChannel);
+
+		TArray<TPair<FString, FMemoryFilePtr>> DirtyFiles;
+		TArray<FString> RemovedFiles;
+		Files->PopChanges(DirtyFiles, RemovedFiles);
+
+		for (const auto& [FilePath, File]: DirtyFiles)
+		{
+			UE_LOG(LogPersistentState, Verbose, TEXT("StateSlot memory file flushed: %s"), *FilePath);
+			if (!FFileHelper::SaveArrayToFile(*File, *FilePath))
+			{
+				UE_LOG(LogPersistentState, Error, TEXT("%s: failed to flush memory file to %s."), *FString(__FUNCTION__), *FilePath);
+			}
+		}
+
+		for (const FString& FilePath: RemovedFiles)
+		{
+			UE_LOG(LogPersistentState, Verbose, TEXT("StateSlot file removed: %s"), *FilePath);
+			IFileManager::Get().Delete(*FilePath, false, false, true);
+		}
+	}, TStatId{}, &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+
+	return LastQueuedEvent;
+}
+
+FPersistentStateSlotSharedRef UPersistentStateMemoryStorage::FindSlot(FName SlotName, bool* OutNamedSlot) const
+{
+	bool bIsNamedSlot = false;
+	ON_SCOPE_EXIT
+	{
+		if (OutNamedSlot)
+		{
+			*OutNamedSlot = bIsNamedSlot;
+		}
+	};
+
+	for (const FPersistentStateSlotSharedRef& Slot: NamedSlots)
+	{
+		if (Slot->GetSlotName() == SlotName)
+		{
+			bIsNamedSlot = true;
+			return Slot;
+		}
+	}
+
+	for (const FPersistentStateSlotSharedRef& Slot: RuntimeSlots)
+	{
+		if (Slot->GetSlotName() == SlotName)
+		{
+			return Slot;
+		}
+	}
+
+	return {};
+}
+
+bool UPersistentStateMemoryStorage::HasStateSlotFile(const FPersistentStateSlotSharedRef& Slot) const
+{
+	return Slot->HasFilePath() && Files->Contains(Slot->GetFilePath());
+}
+
+void UPersistentStateMemoryStorage::CreateStateSlotFile(const FPersistentStateSlotSharedRef& Slot, const FString& FilePath)
+{
+	check(Slot.IsValid() && !Slot->HasFilePath());
+	// create empty memory file and associate it with a slot
+	Slot->SetFilePath(FilePath);
+	Files->Write(FilePath, MakeShared<TArray<uint8>, ESPMode::ThreadSafe>());
+
+	UE_LOG(LogPersistentState, Verbose, TEXT("StateSlot memory file is created: %s"), *FilePath);
+}
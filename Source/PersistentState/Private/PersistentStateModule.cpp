@@ -1,7 +1,10 @@
 ﻿
 #include "PersistentStateModule.h"
 
+#include "PersistentStateSchema.h"
+#include "PersistentStateStorageScheduler.h"
 #include "SaveGameSystem.h"
+#include "Managers/PersistentStateDefaultStateStore.h"
 #include "Modules/ModuleManager.h"
 
 DEFINE_STAT(STAT_PersistentState_NumObjects);
@@ -13,9 +16,25 @@ UE_TRACE_CHANNEL_DEFINE(PersistentStateChannel);
 class FPersistentStateModule: public IPersistentStateModule
 {
 public:
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
 	virtual ISaveGameSystem* GetSaveGameSystem() override;
 };
 
+void FPersistentStateModule::StartupModule()
+{
+	FPersistentStateSchemaRegistry::Get().Initialize();
+	UE::PersistentState::Private::FDefaultStateStore::Get().Initialize();
+	FPersistentStateStorageScheduler::Get().Initialize();
+}
+
+void FPersistentStateModule::ShutdownModule()
+{
+	FPersistentStateStorageScheduler::Get().Shutdown();
+	UE::PersistentState::Private::FDefaultStateStore::Get().Shutdown();
+	FPersistentStateSchemaRegistry::Get().Shutdown();
+}
+
 ISaveGameSystem* FPersistentStateModule::GetSaveGameSystem()
 {
 	static FGenericSaveGameSystem SaveGameSystem{};
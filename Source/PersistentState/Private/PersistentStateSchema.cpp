@@ -0,0 +1,588 @@
+#include "PersistentStateSchema.h"
+
+#include "PersistentStateModule.h"
+#include "Hash/CityHash.h"
+#include "Serialization/StructuredArchiveAdapters.h"
+#include "UObject/UObjectGlobals.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Schema Cache Hits"),	STAT_PersistentState_SchemaCacheHits,	STATGROUP_PersistentState);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Schema Cache Misses"),	STAT_PersistentState_SchemaCacheMisses,	STATGROUP_PersistentState);
+
+FPersistentStateSchemaRegistry FPersistentStateSchemaRegistry::Instance;
+static thread_local FPersistentStateSchemaReferenceScope* GActiveReferenceScope = nullptr;
+
+namespace UE::PersistentState::Private
+{
+	/** @return true if property should be included in class schema. Mirrors FProperty::ShouldSerializeValue for SaveGame archives */
+	FORCEINLINE bool ShouldSerializeSchemaProperty(const FProperty* Property)
+	{
+		return Property->HasAnyPropertyFlags(CPF_SaveGame) && !Property->HasAnyPropertyFlags(CPF_Transient | CPF_Deprecated);
+	}
+
+	FORCEINLINE uint64 HashString(const FString& Value, uint64 Seed)
+	{
+		return CityHash64WithSeed(reinterpret_cast<const char*>(*Value), Value.Len() * sizeof(TCHAR), Seed);
+	}
+}
+
+uint64 FPersistentStateClassSchema::CalculateHash() const
+{
+	using namespace UE::PersistentState::Private;
+	
+	uint64 Result = HashString(ClassPath, 0);
+	for (const FPersistentStateSchemaProperty& Property: Properties)
+	{
+		Result = HashString(Property.Name, Result);
+		Result = HashString(Property.Type, Result);
+		Result = CityHash64WithSeed(reinterpret_cast<const char*>(&Property.ArrayIndex), sizeof(Property.ArrayIndex), Result);
+	}
+
+	// zero hash is reserved for invalid schemas
+	return Result != 0 ? Result : 1;
+}
+
+SIZE_T FPersistentStateClassSchema::GetAllocatedSize() const
+{
+	SIZE_T TotalSize = ClassPath.GetAllocatedSize() + Properties.GetAllocatedSize();
+	for (const FPersistentStateSchemaProperty& Property: Properties)
+	{
+		TotalSize += Property.Name.GetAllocatedSize() + Property.Type.GetAllocatedSize();
+	}
+
+	return TotalSize;
+}
+
+const FPersistentStateRuntimeSchema& FPersistentStateSchemaRegistry::GetRuntimeSchema(const UClass* Class)
+{
+	check(Class && IsInGameThread());
+	if (const FPersistentStateRuntimeSchema* RuntimeSchema = RuntimeSchemas.Find(Class))
+	{
+		INC_DWORD_STAT(STAT_PersistentState_SchemaCacheHits);
+		return *RuntimeSchema;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	INC_DWORD_STAT(STAT_PersistentState_SchemaCacheMisses);
+
+	FPersistentStateRuntimeSchema& RuntimeSchema = RuntimeSchemas.Add(Class);
+
+	FPersistentStateClassSchema Schema{};
+	Schema.ClassPath = Class->GetPathName();
+
+	for (TFieldIterator<FProperty> It(Class); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (!UE::PersistentState::Private::ShouldSerializeSchemaProperty(Property))
+		{
+			continue;
+		}
+
+		FString ExtendedType{};
+		FString Type = Property->GetCPPType(&ExtendedType, 0);
+		Type += ExtendedType;
+
+		for (int32 ArrayIndex = 0; ArrayIndex < Property->ArrayDim; ++ArrayIndex)
+		{
+			Schema.Properties.Add(FPersistentStateSchemaProperty{Property->GetName(), Type, ArrayIndex});
+			RuntimeSchema.Properties.Emplace(Property, ArrayIndex);
+		}
+	}
+
+	Schema.Hash = Schema.CalculateHash();
+	const uint64 SchemaHash = Schema.Hash;
+	
+	// runtime schema is left invalid on hash collision, so that class falls back to tagged serialization
+	if (AddSchema(MoveTemp(Schema)))
+	{
+		RuntimeSchema.Hash = SchemaHash;
+	}
+
+	return RuntimeSchema;
+}
+
+bool FPersistentStateSchemaRegistry::AddSchema(FPersistentStateClassSchema&& Schema)
+{
+	if (const FPersistentStateClassSchema* ExistingSchema = Schemas.Find(Schema.Hash))
+	{
+		if (*ExistingSchema == Schema)
+		{
+			return true;
+		}
+
+		// registered schema keeps its hash, as property bunches may already reference it. Colliding schema is rejected
+		// before any bunch is written with it, its class falls back to tagged serialization
+		UE_LOG(LogPersistentState, Error, TEXT("%s: schema hash collision between %s and %s. Schema %llu is kept for %s."),
+			*FString(__FUNCTION__), *ExistingSchema->ClassPath, *Schema.ClassPath, Schema.Hash, *ExistingSchema->ClassPath);
+		
+		return false;
+	}
+
+	Schemas.Add(Schema.Hash, MoveTemp(Schema));
+	return true;
+}
+
+const FPersistentStateClassSchema* FPersistentStateSchemaRegistry::FindSchema(uint64 Hash) const
+{
+	return Schemas.Find(Hash);
+}
+
+const TArray<int32>& FPersistentStateSchemaRegistry::GetSchemaRemap(const FPersistentStateClassSchema& SavedSchema, const FPersistentStateClassSchema& CurrentSchema)
+{
+	const TPair<uint64, uint64> Key{SavedSchema.Hash, CurrentSchema.Hash};
+	if (const TArray<int32>* Remap = SchemaRemaps.Find(Key))
+	{
+		return *Remap;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	
+	TMap<FPersistentStateSchemaProperty, int32> CurrentIndices;
+	CurrentIndices.Reserve(CurrentSchema.Properties.Num());
+	for (int32 Index = 0; Index < CurrentSchema.Properties.Num(); ++Index)
+	{
+		CurrentIndices.Add(CurrentSchema.Properties[Index], Index);
+	}
+
+	// schemas are immutable, so remap table is valid for the lifetime of the registry
+	TArray<int32>& Remap = SchemaRemaps.Add(Key);
+	Remap.Reserve(SavedSchema.Properties.Num());
+	for (const FPersistentStateSchemaProperty& SavedProperty: SavedSchema.Properties)
+	{
+		// properties that were removed or changed their type are skipped
+		const int32* CurrentIndex = CurrentIndices.Find(SavedProperty);
+		Remap.Add(CurrentIndex != nullptr ? *CurrentIndex : INDEX_NONE);
+	}
+
+	return Remap;
+}
+
+void FPersistentStateSchemaRegistry::WriteSchemaTable(FArchive& Ar, const TSet<uint64>& SchemaHashes)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// schemas are referenced by the state bunches, which can be created by other game sessions
+	TArray<FPersistentStateClassSchema*, TInlineAllocator<64>> TableSchemas;
+	TableSchemas.Reserve(SchemaHashes.Num());
+	for (const uint64 Hash: SchemaHashes)
+	{
+		if (FPersistentStateClassSchema* Schema = Schemas.Find(Hash))
+		{
+			TableSchemas.Add(Schema);
+		}
+		else
+		{
+			UE_LOG(LogPersistentState, Error, TEXT("%s: property bunch references unknown schema %llu."), *FString(__FUNCTION__), Hash);
+		}
+	}
+	
+	int32 NumSchemas = TableSchemas.Num();
+	Ar << NumSchemas;
+
+	for (FPersistentStateClassSchema* Schema: TableSchemas)
+	{
+		Ar << *Schema;
+	}
+}
+
+void FPersistentStateSchemaRegistry::ReadSchemaTable(FArchive& Ar, int32 StartPosition)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	const int64 CurrentPosition = Ar.Tell();
+	Ar.Seek(StartPosition);
+
+	int32 NumSchemas = 0;
+	Ar << NumSchemas;
+
+	for (int32 Index = 0; Index < NumSchemas; ++Index)
+	{
+		FPersistentStateClassSchema Schema{};
+		Ar << Schema;
+
+		// saved schema that collides with a registered schema is rejected, registered schema keeps its hash
+		AddSchema(MoveTemp(Schema));
+	}
+
+	Ar.Seek(CurrentPosition);
+}
+
+void FPersistentStateSchemaRegistry::Initialize()
+{
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddRaw(this, &ThisClass::OnReloadComplete);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &ThisClass::OnPostGarbageCollect);
+#if WITH_EDITOR
+	ObjectsReinstancedHandle = FCoreUObjectDelegates::OnObjectsReinstanced.AddRaw(this, &ThisClass::OnObjectsReinstanced);
+#endif
+}
+
+void FPersistentStateSchemaRegistry::Shutdown()
+{
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReinstanced.Remove(ObjectsReinstancedHandle);
+#endif
+	ReloadCompleteHandle.Reset();
+	PostGarbageCollectHandle.Reset();
+	ObjectsReinstancedHandle.Reset();
+	
+	ResetRuntimeSchemas();
+}
+
+void FPersistentStateSchemaRegistry::OnReloadComplete(EReloadCompleteReason Reason)
+{
+	// hot reload and live coding can change class layout for any native class
+	ResetRuntimeSchemas();
+}
+
+void FPersistentStateSchemaRegistry::OnObjectsReinstanced(const TMap<UObject*, UObject*>& ReplacedObjects)
+{
+	// regenerated classes can reuse the same class object with a different property layout
+	for (auto& [OldObject, NewObject]: ReplacedObjects)
+	{
+		if (const UClass* OldClass = Cast<UClass>(OldObject))
+		{
+			RuntimeSchemas.Remove(OldClass);
+		}
+		if (const UClass* NewClass = Cast<UClass>(NewObject))
+		{
+			RuntimeSchemas.Remove(NewClass);
+		}
+	}
+}
+
+void FPersistentStateSchemaRegistry::OnPostGarbageCollect()
+{
+	// remove runtime schemas for garbage collected classes
+	for (auto It = RuntimeSchemas.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+SIZE_T FPersistentStateSchemaRegistry::GetAllocatedSize() const
+{
+	SIZE_T TotalSize = RuntimeSchemas.GetAllocatedSize() + Schemas.GetAllocatedSize();
+	TotalSize += SchemaRemaps.GetAllocatedSize();
+	for (auto& [Class, RuntimeSchema]: RuntimeSchemas)
+	{
+		TotalSize += RuntimeSchema.Properties.GetAllocatedSize();
+	}
+	for (auto& [Hash, Schema]: Schemas)
+	{
+		TotalSize += Schema.GetAllocatedSize();
+	}
+	for (auto& [Key, Remap]: SchemaRemaps)
+	{
+		TotalSize += Remap.GetAllocatedSize();
+	}
+
+	return TotalSize;
+}
+
+FPersistentStateSchemaReferenceScope::FPersistentStateSchemaReferenceScope()
+	: OuterScope(GActiveReferenceScope)
+{
+	GActiveReferenceScope = this;
+}
+
+FPersistentStateSchemaReferenceScope::~FPersistentStateSchemaReferenceScope()
+{
+	check(GActiveReferenceScope == this);
+	GActiveReferenceScope = OuterScope;
+}
+
+void FPersistentStateSchemaReferenceScope::AddBunchReference(TConstArrayView<uint8> PropertyBunch)
+{
+	if (GActiveReferenceScope != nullptr)
+	{
+		if (const uint64 SchemaHash = UE::PersistentState::GetBunchSchemaHash(PropertyBunch); SchemaHash != 0)
+		{
+			GActiveReferenceScope->Schemas.Add(SchemaHash);
+		}
+	}
+}
+
+namespace UE::PersistentState
+{
+
+uint64 GetBunchSchemaHash(TConstArrayView<uint8> PropertyBunch)
+{
+	if (PropertyBunch.IsEmpty())
+	{
+		return 0;
+	}
+	
+	const EPersistentStateBunchFormat Format = static_cast<EPersistentStateBunchFormat>(PropertyBunch[0]);
+	const int64 NumBytes = PropertyBunch.Num();
+	int64 Position = sizeof(uint8);
+	
+	if (EnumHasAnyFlags(Format, EPersistentStateBunchFormat::FastState))
+	{
+		uint32 FastStateSize = 0;
+		if (Position + static_cast<int64>(sizeof(uint32)) > NumBytes)
+		{
+			return 0;
+		}
+		FMemory::Memcpy(&FastStateSize, PropertyBunch.GetData() + Position, sizeof(uint32));
+		Position += sizeof(uint32) + FastStateSize;
+	}
+
+	uint64 SchemaHash = 0;
+	// schema bunch without properties doesn't store schema hash
+	if ((Format & ~EPersistentStateBunchFormat::FastState) == EPersistentStateBunchFormat::Schema && Position + static_cast<int64>(sizeof(uint64)) <= NumBytes)
+	{
+		FMemory::Memcpy(&SchemaHash, PropertyBunch.GetData() + Position, sizeof(uint64));
+	}
+
+	return SchemaHash;
+}
+
+namespace Private
+{
+	/** default property values decoded from a baseline bunch */
+	struct FSchemaBaseline
+	{
+		UE_NONCOPYABLE(FSchemaBaseline);
+		
+		FSchemaBaseline(const FPersistentStateRuntimeSchema& InSchema, FArchive& Ar)
+			: Schema(InSchema)
+		{
+			Values.SetNumZeroed(Schema.Properties.Num());
+			if (Ar.AtEnd())
+			{
+				// baseline properties match archetype
+				return;
+			}
+			
+			uint64 SchemaHash = 0;
+			Ar << SchemaHash;
+			if (SchemaHash != Schema.Hash)
+			{
+				// baseline has been saved with a different class layout, compare against archetype
+				return;
+			}
+
+			TArray<uint8, TInlineAllocator<16>> PresenceMask;
+			PresenceMask.SetNumUninitialized(FMath::DivideAndRoundUp(Schema.Properties.Num(), 8));
+			Ar.Serialize(PresenceMask.GetData(), PresenceMask.Num());
+
+			FStructuredArchiveFromArchive Adapter{Ar};
+			FStructuredArchive::FStream Stream = Adapter.GetSlot().EnterStream();
+			
+			for (int32 Index = 0; Index < Schema.Properties.Num(); ++Index)
+			{
+				if ((PresenceMask[Index >> 3] & (1 << (Index & 7))) == 0)
+				{
+					continue;
+				}
+
+				uint32 ValueSize = 0;
+				Ar << ValueSize;
+				const int64 EndPosition = Ar.Tell() + ValueSize;
+				
+				// decode property value into a separate value, so that it can be compared by value and not by serialized bytes
+				// e.g. soft object references are compared by object path
+				const FProperty* Property = Schema.Properties[Index].Key;
+				void* Value = FMemory::Malloc(Property->ElementSize, Property->GetMinAlignment());
+				Property->InitializeValue(Value);
+				Property->SerializeItem(Stream.EnterElement(), Value, nullptr);
+				Values[Index] = Value;
+
+				ensureAlwaysMsgf(Ar.Tell() == EndPosition, TEXT("%s: property %s serialized unexpected number of bytes."),
+					*FString(__FUNCTION__), *Property->GetName());
+				Ar.Seek(EndPosition);
+			}
+		}
+
+		~FSchemaBaseline()
+		{
+			for (int32 Index = 0; Index < Values.Num(); ++Index)
+			{
+				if (void* Value = Values[Index])
+				{
+					Schema.Properties[Index].Key->DestroyValue(Value);
+					FMemory::Free(Value);
+				}
+			}
+		}
+
+		/** @return baseline value for a schema property, nullptr if baseline property matches archetype */
+		FORCEINLINE const void* GetValue(int32 Index) const { return Values[Index]; }
+
+		const FPersistentStateRuntimeSchema& Schema;
+		TArray<void*, TInlineAllocator<16>> Values;
+	};
+}
+
+bool SaveObjectSchema(FArchive& Ar, UObject& Object, FArchive* BaselineAr)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(Ar.IsSaving());
+
+	const FPersistentStateRuntimeSchema& Schema = FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Object.GetClass());
+	const UObject* Archetype = Object.GetArchetype();
+
+	TOptional<Private::FSchemaBaseline> Baseline;
+	if (BaselineAr != nullptr)
+	{
+		check(BaselineAr->IsLoading());
+		Baseline.Emplace(Schema, *BaselineAr);
+	}
+
+	// property is present in the bunch if its value differs from baseline value, or from archetype value
+	// if baseline doesn't store the property
+	const int32 NumProperties = Schema.Properties.Num();
+	TArray<uint8, TInlineAllocator<16>> PresenceMask;
+	PresenceMask.SetNumZeroed(FMath::DivideAndRoundUp(NumProperties, 8));
+
+	bool bHasProperties = false;
+	for (int32 Index = 0; Index < NumProperties; ++Index)
+	{
+		const auto& [Property, ArrayIndex] = Schema.Properties[Index];
+		
+		bool bIdentical = false;
+		if (const void* BaselineValue = Baseline.IsSet() ? Baseline->GetValue(Index) : nullptr)
+		{
+			bIdentical = Property->Identical(Property->ContainerPtrToValuePtr<void>(&Object, ArrayIndex), BaselineValue, Ar.GetPortFlags());
+		}
+		else
+		{
+			bIdentical = Property->Identical_InContainer(&Object, Archetype, ArrayIndex, Ar.GetPortFlags());
+		}
+		
+		if (!bIdentical)
+		{
+			PresenceMask[Index >> 3] |= 1 << (Index & 7);
+			bHasProperties = true;
+		}
+	}
+
+	if (!bHasProperties)
+	{
+		// all properties match baseline or archetype, leave bunch empty
+		return false;
+	}
+
+	uint64 SchemaHash = Schema.Hash;
+	Ar << SchemaHash;
+	Ar.Serialize(PresenceMask.GetData(), PresenceMask.Num());
+
+	FStructuredArchiveFromArchive Adapter{Ar};
+	FStructuredArchive::FStream Stream = Adapter.GetSlot().EnterStream();
+
+	for (int32 Index = 0; Index < NumProperties; ++Index)
+	{
+		if ((PresenceMask[Index >> 3] & (1 << (Index & 7))) == 0)
+		{
+			continue;
+		}
+
+		const auto& [Property, ArrayIndex] = Schema.Properties[Index];
+
+		// value size is stored to skip values during schema mismatch
+		const int64 SizePosition = Ar.Tell();
+		uint32 ValueSize = 0;
+		Ar << ValueSize;
+
+		Property->SerializeItem(Stream.EnterElement(), Property->ContainerPtrToValuePtr<void>(&Object, ArrayIndex), nullptr);
+
+		const int64 EndPosition = Ar.Tell();
+		ValueSize = static_cast<uint32>(EndPosition - SizePosition - sizeof(uint32));
+
+		Ar.Seek(SizePosition);
+		Ar << ValueSize;
+		Ar.Seek(EndPosition);
+	}
+
+	return true;
+}
+
+void LoadObjectSchema(FArchive& Ar, UObject& Object)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(Ar.IsLoading());
+
+	if (Ar.AtEnd())
+	{
+		// all properties match archetype
+		return;
+	}
+
+	FPersistentStateSchemaRegistry& Registry = FPersistentStateSchemaRegistry::Get();
+	const FPersistentStateRuntimeSchema& RuntimeSchema = Registry.GetRuntimeSchema(Object.GetClass());
+
+	uint64 SchemaHash = 0;
+	Ar << SchemaHash;
+
+	const FPersistentStateClassSchema* SavedSchema = Registry.FindSchema(SchemaHash);
+	if (SavedSchema == nullptr)
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: failed to find schema %llu for object %s. Object state is not restored."),
+			*FString(__FUNCTION__), SchemaHash, *Object.GetName());
+		return;
+	}
+
+	const int32 NumProperties = SavedSchema->Properties.Num();
+	TArray<uint8, TInlineAllocator<16>> PresenceMask;
+	PresenceMask.SetNumUninitialized(SavedSchema->GetMaskSize());
+	Ar.Serialize(PresenceMask.GetData(), PresenceMask.Num());
+
+	// map saved schema layout to the current class layout
+	TArray<TPair<FProperty*, int32>, TInlineAllocator<16>> SchemaMismatchProperties;
+	TConstArrayView<TPair<FProperty*, int32>> Properties = RuntimeSchema.Properties;
+
+	if (SchemaHash != RuntimeSchema.Hash)
+	{
+		UE_LOG(LogPersistentState, Verbose, TEXT("%s: schema mismatch for object %s, saved class %s"),
+			*FString(__FUNCTION__), *Object.GetName(), *SavedSchema->ClassPath);
+
+		const FPersistentStateClassSchema* CurrentSchema = Registry.FindSchema(RuntimeSchema.Hash);
+		if (CurrentSchema == nullptr)
+		{
+			UE_LOG(LogPersistentState, Error, TEXT("%s: class %s doesn't have a valid schema. Object state is not restored."),
+				*FString(__FUNCTION__), *Object.GetClass()->GetName());
+			return;
+		}
+
+		// properties that were removed or changed their type are skipped
+		SchemaMismatchProperties.Reserve(NumProperties);
+		for (const int32 CurrentIndex: Registry.GetSchemaRemap(*SavedSchema, *CurrentSchema))
+		{
+			SchemaMismatchProperties.Add(CurrentIndex != INDEX_NONE ? RuntimeSchema.Properties[CurrentIndex] : TPair<FProperty*, int32>{nullptr, 0});
+		}
+
+		Properties = SchemaMismatchProperties;
+	}
+
+	FStructuredArchiveFromArchive Adapter{Ar};
+	FStructuredArchive::FStream Stream = Adapter.GetSlot().EnterStream();
+
+	for (int32 Index = 0; Index < NumProperties; ++Index)
+	{
+		if ((PresenceMask[Index >> 3] & (1 << (Index & 7))) == 0)
+		{
+			continue;
+		}
+
+		uint32 ValueSize = 0;
+		Ar << ValueSize;
+
+		const int64 EndPosition = Ar.Tell() + ValueSize;
+		if (const auto& [Property, ArrayIndex] = Properties[Index]; Property != nullptr)
+		{
+			Property->SerializeItem(Stream.EnterElement(), Property->ContainerPtrToValuePtr<void>(&Object, ArrayIndex), nullptr);
+			ensureAlwaysMsgf(Ar.Tell() == EndPosition, TEXT("%s: property %s serialized unexpected number of bytes."),
+				*FString(__FUNCTION__), *Property->GetName());
+		}
+
+		Ar.Seek(EndPosition);
+	}
+}
+
+} // UE::PersistentState
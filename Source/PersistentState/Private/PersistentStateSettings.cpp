@@ -24,10 +24,17 @@ void UPersistentStateSettings::PostLoad()
 	}
 }
 
+void UPersistentStateSettings::PostReloadConfig(FProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+	QuantizedTransformCache.Reset();
+}
+
 #if WITH_EDITOR
 void UPersistentStateSettings::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
 {
 	Super::PostEditChangeProperty(PropertyChangedEvent);
+	QuantizedTransformCache.Reset();
 	
 	for (FPersistentStateDefaultNamedSlot& NamedSlot: DefaultNamedSlots)
 	{
@@ -120,3 +127,26 @@ bool UPersistentStateSettings::ShouldCacheSlotState() const
 {
 	return bCacheSlotState && UE::PersistentState::GPersistentStateStorage_CacheSlotState;
 }
+
+bool UPersistentStateSettings::ShouldQuantizeTransform(const UClass* ObjectClass) const
+{
+	check(ObjectClass && IsInGameThread());
+	if (const bool* bCachedResult = QuantizedTransformCache.Find(ObjectClass))
+	{
+		return *bCachedResult;
+	}
+
+	// configured class is always loaded if object of its child class exists, so negative result is cached as well
+	bool bResult = false;
+	for (const TSoftClassPtr<UObject>& QuantizedClass: QuantizedTransformClasses)
+	{
+		if (const UClass* Class = QuantizedClass.Get(); Class && ObjectClass->IsChildOf(Class))
+		{
+			bResult = true;
+			break;
+		}
+	}
+
+	QuantizedTransformCache.Add(ObjectClass, bResult);
+	return bResult;
+}
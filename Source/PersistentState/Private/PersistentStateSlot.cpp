@@ -1,11 +1,16 @@
 #include "PersistentStateSlot.h"
 
+#include "PersistentStateCVars.h"
 #include "PersistentStateModule.h"
 #include "PersistentStateSerialization.h"
 #include "PersistentStateSlotDescriptor.h"
 #include "PersistentStateStatics.h"
 #include "Algo/AllOf.h"
+#include "Algo/AnyOf.h"
 #include "Compression/OodleDataCompressionUtil.h"
+#include "Hash/Blake3.h"
+#include "Misc/Compression.h"
+#include "Tasks/Task.h"
 
 FArchive& operator<<(FArchive& Ar, FPersistentStateFixedInteger& Value)
 {
@@ -25,8 +30,12 @@ void operator<<(FStructuredArchive::FSlot Slot, FStateDataHeader& Value)
 	Record << SA_VALUE(TEXT("ChunkCount"), Value.ChunkCount);
 	Record << SA_VALUE(TEXT("ObjectTablePosition"), Value.ObjectTablePosition);
 	Record << SA_VALUE(TEXT("StringTablePosition"), Value.StringTablePosition);
+	Record << SA_VALUE(TEXT("SchemaTablePosition"), Value.SchemaTablePosition);
 	Record << SA_VALUE(TEXT("DataStart"), Value.DataStart);
 	Record << SA_VALUE(TEXT("DataSize"), Value.DataSize);
+	Record << SA_VALUE(TEXT("BlockHash"), Value.BlockHash);
+	Record << SA_VALUE(TEXT("BaseBlockHash"), Value.BaseBlockHash);
+	Record << SA_VALUE(TEXT("FormatVersion"), Value.FormatVersion);
 }
 
 bool operator==(const FStateDataHeader& A, const FStateDataHeader& B)
@@ -34,7 +43,10 @@ bool operator==(const FStateDataHeader& A, const FStateDataHeader& B)
 	return	A.HeaderTag == B.HeaderTag && A.ChunkCount == B.ChunkCount &&
 			A.ObjectTablePosition == B.ObjectTablePosition &&
 			A.StringTablePosition == B.StringTablePosition &&
-			A.DataStart == B.DataStart && A.DataSize == B.DataSize;
+			A.SchemaTablePosition == B.SchemaTablePosition &&
+			A.DataStart == B.DataStart && A.DataSize == B.DataSize &&
+			A.BlockHash == B.BlockHash && A.BaseBlockHash == B.BaseBlockHash &&
+			A.FormatVersion == B.FormatVersion;
 }
 
 void operator<<(FStructuredArchive::FSlot Slot, FWorldStateDataHeader& Value)
@@ -44,8 +56,12 @@ void operator<<(FStructuredArchive::FSlot Slot, FWorldStateDataHeader& Value)
 	Record << SA_VALUE(TEXT("ChunkCount"), Value.ChunkCount);
 	Record << SA_VALUE(TEXT("ObjectTablePosition"), Value.ObjectTablePosition);
 	Record << SA_VALUE(TEXT("StringTablePosition"), Value.StringTablePosition);
+	Record << SA_VALUE(TEXT("SchemaTablePosition"), Value.SchemaTablePosition);
 	Record << SA_VALUE(TEXT("DataStart"), Value.DataStart);
 	Record << SA_VALUE(TEXT("DataSize"), Value.DataSize);
+	Record << SA_VALUE(TEXT("BlockHash"), Value.BlockHash);
+	Record << SA_VALUE(TEXT("BaseBlockHash"), Value.BaseBlockHash);
+	Record << SA_VALUE(TEXT("FormatVersion"), Value.FormatVersion);
 	Record << SA_VALUE(TEXT("World"), Value.World);
 	Record << SA_VALUE(TEXT("WorldPackage"), Value.WorldPackage);
 }
@@ -103,19 +119,17 @@ bool FPersistentStateSlot::TrySetFilePath(FArchive& Ar, const FString& InFilePat
 	check(Ar.IsLoading() && Ar.Tell() == 0);
 
 	FPersistentStateSaveGameArchive SaveGameArchive{Ar};
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateLoadFormatter(SaveGameArchive);
-	FStructuredArchive StructuredArchive{*Formatter};
-	FStructuredArchive::FRecord RootRecord = StructuredArchive.Open().EnterRecord();
+	FPersistentStateRecord RootRecord{SaveGameArchive};
 
 	FPersistentStateFixedInteger HeaderTag{INVALID_HEADER_TAG};
-	RootRecord << SA_VALUE(TEXT("FileHeaderTag"), HeaderTag);
+	RootRecord.Serialize(TEXT("FileHeaderTag"), HeaderTag);
 	if (HeaderTag != SLOT_HEADER_TAG)
 	{
 		return false;
 	}
 	
 	FPersistentStateSlot TempSlot{};
-	StaticStruct()->SerializeItem(RootRecord.EnterField(TEXT("StateSlot")), &TempSlot, nullptr);
+	RootRecord.SerializeStruct(TEXT("StateSlot"), StaticStruct(), &TempSlot);
 
 	if (!TempSlot.IsPhysical())
 	{
@@ -143,6 +157,17 @@ void FPersistentStateSlot::ResetFileState()
 	bValidSlot = true;
 }
 
+FPersistentStateSlot FPersistentStateSlot::CreateDuplicate(FName InSlotName, const FString& InFilePath) const
+{
+	check(HasFilePath());
+	
+	FPersistentStateSlot Result = *this;
+	Result.SlotName = InSlotName.ToString();
+	Result.FilePath = InFilePath;
+
+	return Result;
+}
+
 UClass* FPersistentStateSlot::ResolveDescriptorClass() const
 {
 	UClass* DescriptorClass = DescriptorHeader.ChunkType.ResolveClass();
@@ -219,6 +244,12 @@ bool FPersistentStateSlot::HasGameState() const
 	return GameHeader.HasData();
 }
 
+const FWorldStateDataHeader* FPersistentStateSlot::FindWorldHeader(FName WorldName) const
+{
+	const int32 HeaderIndex = GetWorldHeaderIndex(WorldName);
+	return WorldHeaders.IsValidIndex(HeaderIndex) ? &WorldHeaders[HeaderIndex] : nullptr;
+}
+
 FGameStateSharedRef FPersistentStateSlot::LoadGameState(FArchiveFactory CreateReadArchive) const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
@@ -227,13 +258,17 @@ FGameStateSharedRef FPersistentStateSlot::LoadGameState(FArchiveFactory CreateRe
 
 	FGameStateSharedRef Result = MakeShared<FGameState>(FGameState::CreateLoadState(GameHeader));
 	
-	if (GameHeader.DataStart > 0)
+	if (GameHeader.HasData())
 	{
-		TUniquePtr<FArchive> Reader = CreateReadArchive(FilePath);
-		check(Reader && Reader->IsLoading());
-
-		FPersistentStateSaveGameArchive SaveGameArchive{*Reader};
-		ReadCompressed(SaveGameArchive, GameHeader.DataStart, GameHeader.DataSize, Result->Buffer);
+		TUniquePtr<FArchive> Reader;
+		TArray<uint8> Data = ReadStateData(GameHeader, CreateReadArchive, Reader);
+		if (Data.IsEmpty())
+		{
+			// state data is missing, game state without its data is not a valid load result
+			return {};
+		}
+		
+		DecompressStateData(MoveTemp(Data), Result->Buffer);
 	}
 	
 	return Result;
@@ -249,10 +284,10 @@ void FPersistentStateSlot::SaveStateDirect(const FPersistentStateSlotSaveRequest
 	// reset world header information
 	WorldHeaders.Empty();
 
-	SaveStateToArchive(Request, CreateWriteArchive, nullptr);
+	SaveStateToArchive(Request, CreateWriteArchive, FilePath);
 }
 
-void FPersistentStateSlot::SaveState(const FPersistentStateSlot& SourceSlot, const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateReadArchive, FArchiveFactory CreateWriteArchive)
+bool FPersistentStateSlot::SaveState(const FPersistentStateSlot& SourceSlot, const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateReadArchive, FArchiveFactory CreateWriteArchive, bool bCanWriteToSourceFile, bool bUseBlockStore)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	
@@ -260,6 +295,14 @@ void FPersistentStateSlot::SaveState(const FPersistentStateSlot& SourceSlot, con
 	check(bValidSlot && HasFilePath());
 	check(Request.IsValid());
 
+	// slot may be saved through a temporary file. Keep current slot data, so that it can be restored if slot file
+	// is not replaced and still stores the previous state
+	TOptional<FPersistentStateSlot> PrevSlot;
+	if (!bCanWriteToSourceFile && SourceSlot.FilePath == FilePath)
+	{
+		PrevSlot = *this;
+	}
+
 	// copy world header data from the source slot
 	WorldHeaders = SourceSlot.WorldHeaders;
 	if (Request.WorldState.IsValid())
@@ -271,40 +314,218 @@ void FPersistentStateSlot::SaveState(const FPersistentStateSlot& SourceSlot, con
 		}
 	}
 	
-	// read world data that not going to change during the save operation
-	TArray<uint8> PersistentData;
-	if (!WorldHeaders.IsEmpty())
+	// write new states to the block store before the slot file, so that slot file never references a missing block
+	FStateBlockRefs BlockRefs;
+	if (bUseBlockStore)
+	{
+		UE::Tasks::FTask WriteGameBlockTask;
+		if (Request.GameState.IsValid() && Request.GameState->Buffer.Num() > 0)
+		{
+			WriteGameBlockTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, &Request, &BlockRefs, &CreateReadArchive, &CreateWriteArchive]
+			{
+				BlockRefs.GameState = WriteStateBlock(Request.GameState->Buffer, CreateReadArchive, CreateWriteArchive);
+			});
+		}
+		// world state is saved as a delta against its base state, until delta grows too large and a new base state is written
+		if (Request.WorldState.IsValid() && Request.WorldState->Buffer.Num() > 0 && !CreateWorldStateDelta(SourceSlot, *Request.WorldState, CreateReadArchive, BlockRefs))
+		{
+			BlockRefs.WorldState = WriteStateBlock(Request.WorldState->Buffer, CreateReadArchive, CreateWriteArchive);
+		}
+
+		WriteGameBlockTask.Wait();
+	}
+	
+	// world data that is not going to change during the save operation is streamed from the source slot.
+	// Worlds stored in the block store are referenced by the new slot file as is
+	TUniquePtr<FArchive> Reader;
+	if (Algo::AnyOf(WorldHeaders, [](const FWorldStateDataHeader& Header) { return !Header.IsBlockData(); }))
 	{
 		// sort world headers by DataStart, so that access to data reader is mostly sequential
 		Algo::Sort(WorldHeaders, [](const FWorldStateDataHeader& A, const FWorldStateDataHeader& B)
 		{
 			return A.DataStart < B.DataStart;
 		});
-
-		int32 PersistentDataSize = 0;
-		for (const FWorldStateDataHeader& WorldHeader: WorldHeaders)
-		{
-			PersistentDataSize += WorldHeader.DataSize;
-		}
 		
-		PersistentData.AddZeroed(PersistentDataSize);
-		// read data for other worlds from the source slot
-		TUniquePtr<FArchive> Reader = CreateReadArchive(SourceSlot.FilePath);
+		Reader = CreateReadArchive(SourceSlot.FilePath);
 		check(Reader.IsValid() && Reader->IsLoading());
-		FPersistentStateSaveGameArchive SaveGameArchive{*Reader};
+	}
+
+	// source file can't be overwritten while world data is streamed from it.
+	// Write to a temporary file instead and replace the slot file after save is complete
+	const bool bReplaceSourceFile = !bCanWriteToSourceFile && Reader.IsValid() && SourceSlot.FilePath == FilePath;
+	const FString WritePath = bReplaceSourceFile ? FilePath + TEXT(".tmp") : FilePath;
+	
+	SaveStateToArchive(Request, CreateWriteArchive, WritePath, Reader.Get(), BlockRefs);
+	Reader.Reset();
+	FPersistentStateBufferPool::Get().Release(MoveTemp(BlockRefs.WorldDelta));
+
+	if (bReplaceSourceFile && !IFileManager::Get().Move(*FilePath, *WritePath, true))
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: failed to replace slot file %s with %s."), *FString(__FUNCTION__), *FilePath, *WritePath);
+		IFileManager::Get().Delete(*WritePath, false, false, true);
+		
+		// slot file is not changed, restore headers that match its contents
+		check(PrevSlot.IsSet());
+		*this = MoveTemp(PrevSlot.GetValue());
+		return false;
+	}
+
+	return true;
+}
 
-		uint8* PersistentDataPtr = PersistentData.GetData();
-		for (const FWorldStateDataHeader& Header: WorldHeaders)
+FString FPersistentStateSlot::GetStateDataPath(const FStateDataHeader& Header) const
+{
+	if (Header.IsBlockData())
+	{
+		return GetBlockStorePath(FPaths::GetPath(FilePath)) / Header.BlockHash + TEXT(".blk");
+	}
+
+	return FilePath;
+}
+
+void FPersistentStateSlot::AddBlockReferences(TMap<FString, int32>& OutRefCounts) const
+{
+	if (GameHeader.IsBlockData())
+	{
+		++OutRefCounts.FindOrAdd(GameHeader.BlockHash);
+	}
+	
+	for (const FWorldStateDataHeader& Header: WorldHeaders)
+	{
+		if (Header.IsBlockData())
 		{
-			check(Header.IsValid());
-			
-			SaveGameArchive.Seek(Header.DataStart);
-			SaveGameArchive.Serialize(PersistentDataPtr, Header.DataSize);
-			PersistentDataPtr += Header.DataSize;
+			++OutRefCounts.FindOrAdd(Header.BlockHash);
+		}
+		if (Header.IsDeltaData())
+		{
+			++OutRefCounts.FindOrAdd(Header.BaseBlockHash);
 		}
 	}
+}
+
+bool FPersistentStateSlot::ResolveStateDelta(const FStateDataHeader& Header, TArray<uint8>& InOutBuffer, FArchiveFactory& CreateReadArchive) const
+{
+	if (!Header.IsDeltaData())
+	{
+		return true;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_ResolveStateDelta, PersistentStateChannel);
+	FPersistentStateBufferPool& BufferPool = FPersistentStateBufferPool::Get();
+	
+	TArray<uint8> Base = ReadStateBlock(Header.BaseBlockHash, CreateReadArchive);
+	TArray<uint8> State;
+	const bool bResult = !Base.IsEmpty() && FPersistentStateDelta::Apply(Base, InOutBuffer, State);
+	if (!bResult)
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: failed to apply state delta to base block %s, state slot %s."), *FString(__FUNCTION__), *Header.BaseBlockHash, *SlotName);
+		BufferPool.Release(MoveTemp(State));
+	}
+
+	BufferPool.Release(MoveTemp(Base));
+	BufferPool.Release(MoveTemp(InOutBuffer));
+	InOutBuffer = MoveTemp(State);
+	
+	return bResult;
+}
+
+FString FPersistentStateSlot::GetBlockStorePath(const FString& SaveGamePath)
+{
+	return SaveGamePath / TEXT("Blocks");
+}
+
+FString FPersistentStateSlot::WriteStateBlock(const TArray<uint8>& Buffer, FArchiveFactory& CreateReadArchive, FArchiveFactory& CreateWriteArchive) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_WriteStateBlock, PersistentStateChannel);
+	
+	// block is identified by uncompressed data, so that existing block is found without compressing state data
+	FStateDataHeader BlockHeader;
+	BlockHeader.BlockHash = LexToString(FBlake3::HashBuffer(Buffer.GetData(), Buffer.Num()));
+	
+	const FString BlockPath = GetStateDataPath(BlockHeader);
+	if (CreateReadArchive(BlockPath).IsValid())
+	{
+		// block is shared with other slots or with a previous save of the same slot
+		return BlockHeader.BlockHash;
+	}
+
+	// write to a temporary file first, so that a partially written block is never referenced
+	const FString WritePath = FString::Printf(TEXT("%s.%s.tmp"), *BlockPath, *FGuid::NewGuid().ToString());
+	{
+		TUniquePtr<FArchive> Writer = CreateWriteArchive(WritePath);
+		check(Writer.IsValid());
+
+		FPersistentStateFixedInteger DataStart;
+		const TPair<const TArray<uint8>*, FPersistentStateFixedInteger*> BlockBuffer{&Buffer, &DataStart};
+		WriteCompressed(*Writer, MakeArrayView(&BlockBuffer, 1));
+	}
 
-	SaveStateToArchive(Request, CreateWriteArchive, &PersistentData);
+	// saves of different slots may write the same block concurrently, block content is the same
+	if (!IFileManager::Get().Move(*BlockPath, *WritePath, true))
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: failed to write block file %s."), *FString(__FUNCTION__), *BlockPath);
+		return {};
+	}
+	
+	return BlockHeader.BlockHash;
+}
+
+TArray<uint8> FPersistentStateSlot::ReadStateBlock(const FString& BlockHash, FArchiveFactory& CreateReadArchive) const
+{
+	FStateDataHeader BlockHeader;
+	BlockHeader.BlockHash = BlockHash;
+
+	TUniquePtr<FArchive> Reader = CreateReadArchive(GetStateDataPath(BlockHeader));
+	if (!Reader.IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: block %s is missing from the block store."), *FString(__FUNCTION__), *BlockHash);
+		return {};
+	}
+	
+	TArray<uint8> Result;
+	DecompressStateData(ReadStateData(*Reader, 0, static_cast<int32>(Reader->TotalSize())), Result);
+
+	return Result;
+}
+
+bool FPersistentStateSlot::CreateWorldStateDelta(const FPersistentStateSlot& SourceSlot, const FWorldState& WorldState, FArchiveFactory& CreateReadArchive, FStateBlockRefs& OutBlockRefs) const
+{
+	const int32 DeltaThreshold = UE::PersistentState::GPersistentState_DeltaSaveThreshold;
+	const FWorldStateDataHeader* SourceHeader = SourceSlot.FindWorldHeader(WorldState.Header.GetWorld());
+	if (DeltaThreshold <= 0 || SourceHeader == nullptr)
+	{
+		return false;
+	}
+
+	// previous world state is either a base state or a delta against it
+	const FString& BaseBlockHash = SourceHeader->IsDeltaData() ? SourceHeader->BaseBlockHash : SourceHeader->BlockHash;
+	if (BaseBlockHash.IsEmpty())
+	{
+		return false;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_CreateWorldStateDelta, PersistentStateChannel);
+	FPersistentStateBufferPool& BufferPool = FPersistentStateBufferPool::Get();
+	
+	TArray<uint8> Base = ReadStateBlock(BaseBlockHash, CreateReadArchive);
+	if (Base.IsEmpty())
+	{
+		return false;
+	}
+	
+	TArray<uint8> Delta = FPersistentStateDelta::Create(Base, WorldState.Buffer);
+	const bool bUseDelta = static_cast<int64>(Delta.Num()) * 100 <= static_cast<int64>(Base.Num()) * DeltaThreshold;
+	BufferPool.Release(MoveTemp(Base));
+	
+	if (!bUseDelta)
+	{
+		BufferPool.Release(MoveTemp(Delta));
+		return false;
+	}
+
+	OutBlockRefs.WorldBase = BaseBlockHash;
+	OutBlockRefs.WorldDelta = MoveTemp(Delta);
+	return true;
 }
 
 uint32 FPersistentStateSlot::GetAllocatedSize() const
@@ -316,7 +537,7 @@ uint32 FPersistentStateSlot::GetAllocatedSize() const
 	return TotalSize;
 }
 
-void FPersistentStateSlot::SaveStateToArchive(const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateWriteArchive, TArray<uint8>* PersistentData)
+void FPersistentStateSlot::SaveStateToArchive(const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateWriteArchive, const FString& WritePath, FArchive* SourceReader, const FStateBlockRefs& BlockRefs)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 
@@ -332,70 +553,95 @@ void FPersistentStateSlot::SaveStateToArchive(const FPersistentStateSlotSaveRequ
 	if (Request.GameState.IsValid())
 	{
 		GameHeader = Request.GameState->Header;
+		GameHeader.BlockHash = BlockRefs.GameState;
 	}
 	
 	if (Request.WorldState.IsValid())
 	{
 		WorldHeaders.Insert(Request.WorldState->Header, 0);
+		WorldHeaders[0].BlockHash = BlockRefs.WorldState;
+		WorldHeaders[0].BaseBlockHash = BlockRefs.WorldBase;
+		if (WorldHeaders[0].IsDeltaData())
+		{
+			// slot file stores world state delta
+			WorldHeaders[0].DataSize = BlockRefs.WorldDelta.Num();
+		}
 		// update last saved world
 		LastSavedWorld = Request.WorldState->Header.GetWorld().ToString();
 	}
 	
-	TUniquePtr<FArchive> Writer = CreateWriteArchive(FilePath);
+	TUniquePtr<FArchive> Writer = CreateWriteArchive(WritePath);
 	check(Writer.IsValid());
 		
 	FPersistentStateSaveGameArchive SaveGameArchive{*Writer};
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateSaveFormatter(SaveGameArchive);
-	FStructuredArchive StructuredArchive{*Formatter};
-	FStructuredArchive::FRecord RootRecord = StructuredArchive.Open().EnterRecord();
+	FPersistentStateRecord RootRecord{SaveGameArchive};
 	
 	const int32 SlotHeaderTagStart = SaveGameArchive.Tell();
 	{
 		FPersistentStateFixedInteger HeaderTag{INVALID_HEADER_TAG};
 		// write invalid header tag to identify corrupted save file in case game crashes mid save
-		RootRecord << SA_VALUE(TEXT("FileHeaderTag"), HeaderTag);
+		RootRecord.Serialize(TEXT("FileHeaderTag"), HeaderTag);
 	}
 	const int32 SlotHeaderTagEnd = SaveGameArchive.Tell();
 
 	// save state slot
 	const int32 StateSlotDataStart = SaveGameArchive.Tell();
-	StaticStruct()->SerializeItem(RootRecord.EnterField(TEXT("StateSlot")), this, nullptr);
+	RootRecord.SerializeStruct(TEXT("StateSlot"), StaticStruct(), this);
 	const int32 StateSlotDataEnd = SaveGameArchive.Tell();
 
 	// mark a descriptor data start
 	DescriptorDataStart = StateSlotDataEnd;
 
-	// save new game state
-	GameHeader.DataStart = SaveGameArchive.Tell();
+	// save new game state and new world state, stored as a first world header
+	// state data that is already written to the block store starts at the beginning of a block file
+	GameHeader.DataStart = GameHeader.IsBlockData() ? 0 : SaveGameArchive.Tell();
+	TArray<TPair<const TArray<uint8>*, FPersistentStateFixedInteger*>, TInlineAllocator<2>> StateBuffers;
 	if (Request.GameState.IsValid())
 	{
 		check(GameHeader.DataSize == Request.GameState->Buffer.Num());
-		WriteCompressed(SaveGameArchive, Request.GameState->Buffer);
+		if (!GameHeader.IsBlockData())
+		{
+			StateBuffers.Emplace(&Request.GameState->Buffer, &GameHeader.DataStart);
+		}
 	}
-
-	// save new world state, stored as a first world header
 	if (Request.WorldState.IsValid())
 	{
-		// save new world state
-		WorldHeaders[0].DataStart = SaveGameArchive.Tell();
-		check(WorldHeaders[0].DataSize == Request.WorldState->Buffer.Num());
-		WriteCompressed(SaveGameArchive, Request.WorldState->Buffer);
+		const TArray<uint8>& WorldBuffer = WorldHeaders[0].IsDeltaData() ? BlockRefs.WorldDelta : Request.WorldState->Buffer;
+		check(WorldHeaders[0].DataSize == WorldBuffer.Num());
+		if (WorldHeaders[0].IsBlockData())
+		{
+			WorldHeaders[0].DataStart = 0;
+		}
+		else
+		{
+			StateBuffers.Emplace(&WorldBuffer, &WorldHeaders[0].DataStart);
+		}
 	}
+	WriteCompressed(SaveGameArchive, StateBuffers);
 	
-	if (PersistentData != nullptr)
+	if (SourceReader != nullptr)
 	{
 		const int32 StartIndex = Request.WorldState.IsValid() ? 1 : 0;
-		// Save rest of the worlds. Write old world data, in the same order as it was read.
+		TArray<uint8> Window = FPersistentStateBufferPool::Get().Acquire(0);
+		// Save rest of the worlds. Copy old world data in the same order as it is stored in the source slot.
 		// DataSize is the same, DataStart is different.
-		uint8* PersistentDataPtr = PersistentData->GetData();
 		for (int32 Index = StartIndex; Index < WorldHeaders.Num(); ++Index)
 		{
-			WorldHeaders[Index].DataStart = SaveGameArchive.Tell();
-			// serialize directly, as data that was read from a source state slot is already in a final state (compressed or not)
-			SaveGameArchive.Serialize(PersistentDataPtr, WorldHeaders[Index].DataSize);
-
-			PersistentDataPtr += WorldHeaders[Index].DataSize;
+			FWorldStateDataHeader& Header = WorldHeaders[Index];
+			check(Header.IsValid());
+			if (Header.IsBlockData())
+			{
+				// world data is shared via the block store, slot file only keeps the reference
+				continue;
+			}
+			
+			const int32 SourceDataStart = Header.DataStart;
+			Header.DataStart = SaveGameArchive.Tell();
+			// copy directly, as data stored in a source state slot is already in a final state (compressed or not)
+			CopyStateData(*SourceReader, SaveGameArchive, SourceDataStart, Header.DataSize, Window);
 		}
+		
+		FPersistentStateBufferPool::Get().Release(MoveTemp(Window));
 	}
 
 	// do not re-write header tag if saving with a debug formatter, because we can't safely backtrack with json/xml formatters
@@ -405,14 +651,14 @@ void FPersistentStateSlot::SaveStateToArchive(const FPersistentStateSlotSaveRequ
 	{
 		// seek to the header start and re-write game and world headers
 		SaveGameArchive.Seek(StateSlotDataStart);
-		StaticStruct()->SerializeItem(RootRecord.EnterField(TEXT("StateSlot")), this, nullptr);
+		RootRecord.SerializeStruct(TEXT("StateSlot"), StaticStruct(), this);
 		check(SaveGameArchive.Tell() == StateSlotDataEnd);
 		
 		// seek to the start and re-write slot header tag
 		SaveGameArchive.Seek(SlotHeaderTagStart);
 		{
 			FPersistentStateFixedInteger HeaderTag{SLOT_HEADER_TAG};
-			RootRecord << SA_VALUE(TEXT("FileHeaderTag"), HeaderTag);
+			RootRecord.Serialize(TEXT("FileHeaderTag"), HeaderTag);
 		}
 		check(SaveGameArchive.Tell() == SlotHeaderTagEnd);
 	}
@@ -436,55 +682,225 @@ FWorldStateSharedRef FPersistentStateSlot::LoadWorldState(FName World, FArchiveF
 	FWorldStateSharedRef Result = MakeShared<FWorldState>(FWorldState::CreateLoadState(WorldHeaders[HeaderIndex]));
 	if (const FWorldStateDataHeader& Header = WorldHeaders[HeaderIndex]; Header.DataSize > 0)
 	{
-		TUniquePtr<FArchive> Reader = CreateReadArchive(FilePath);
-		check(Reader && Reader->IsLoading());
-
-		FPersistentStateSaveGameArchive SaveGameArchive{*Reader};
-		ReadCompressed(SaveGameArchive, Header.DataStart, Header.DataSize, Result->Buffer);
+		TUniquePtr<FArchive> Reader;
+		TArray<uint8> Data = ReadStateData(Header, CreateReadArchive, Reader);
+		if (Data.IsEmpty())
+		{
+			// state data is missing, world state without its data is not a valid load result
+			return {};
+		}
+		
+		DecompressStateData(MoveTemp(Data), Result->Buffer);
+		if (!ResolveStateDelta(Header, Result->Buffer, CreateReadArchive))
+		{
+			return {};
+		}
 	}
 	
 	return Result;
 }
 
-void FPersistentStateSlot::ReadCompressed(FArchive& Ar, int32 DataStart, int32 DataSize, TArray<uint8>& OutBuffer)
+void FPersistentStateSlot::LoadState(bool bLoadGameState, FName World, FArchiveFactory CreateReadArchive, FGameStateSharedRef& OutGameState, FWorldStateSharedRef& OutWorldState) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	// verify that slot is associated with file path
+	check(HasFilePath());
+
+	FGameStateSharedRef GameState;
+	if (bLoadGameState)
+	{
+		GameState = MakeShared<FGameState>(FGameState::CreateLoadState(GameHeader));
+	}
+
+	FWorldStateSharedRef WorldState;
+	if (const int32 HeaderIndex = World != NAME_None ? GetWorldHeaderIndex(World) : INDEX_NONE; WorldHeaders.IsValidIndex(HeaderIndex))
+	{
+		WorldState = MakeShared<FWorldState>(FWorldState::CreateLoadState(WorldHeaders[HeaderIndex]));
+	}
+
+	const bool bReadGameState = GameState.IsValid() && GameHeader.HasData();
+	const bool bReadWorldState = WorldState.IsValid() && WorldState->Header.DataSize > 0;
+	if (bReadGameState || bReadWorldState)
+	{
+		// slot file is opened once for both game and world state
+		TUniquePtr<FArchive> Reader;
+		
+		UE::Tasks::FTask DecompressGameStateTask;
+		if (bReadGameState)
+		{
+			TArray<uint8> Data = ReadStateData(GameHeader, CreateReadArchive, Reader);
+			if (Data.IsEmpty())
+			{
+				// state data is missing, game state without its data is not a valid load result
+				GameState.Reset();
+			}
+			else
+			{
+				// decompress game state concurrently, while world state is being read and decompressed
+				DecompressGameStateTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [GameState, Data = MoveTemp(Data)]() mutable
+				{
+					DecompressStateData(MoveTemp(Data), GameState->Buffer);
+				});
+			}
+		}
+
+		if (bReadWorldState)
+		{
+			TArray<uint8> Data = ReadStateData(WorldState->Header, CreateReadArchive, Reader);
+			if (Data.IsEmpty())
+			{
+				WorldState.Reset();
+			}
+			else
+			{
+				DecompressStateData(MoveTemp(Data), WorldState->Buffer);
+				if (!ResolveStateDelta(WorldState->Header, WorldState->Buffer, CreateReadArchive))
+				{
+					WorldState.Reset();
+				}
+			}
+		}
+
+		// join game state decompression
+		DecompressGameStateTask.Wait();
+	}
+
+	OutGameState = MoveTemp(GameState);
+	OutWorldState = MoveTemp(WorldState);
+}
+
+TArray<uint8> FPersistentStateSlot::ReadStateData(const FStateDataHeader& Header, FArchiveFactory& CreateReadArchive, TUniquePtr<FArchive>& SlotReader) const
+{
+	if (Header.IsBlockData())
+	{
+		TUniquePtr<FArchive> BlockReader = CreateReadArchive(GetStateDataPath(Header));
+		if (!BlockReader.IsValid())
+		{
+			UE_LOG(LogPersistentState, Error, TEXT("%s: block %s referenced by state slot %s is missing from the block store."), *FString(__FUNCTION__), *Header.BlockHash, *SlotName);
+			return {};
+		}
+
+		return ReadStateData(*BlockReader, Header.DataStart, Header.DataSize);
+	}
+
+	if (!SlotReader.IsValid())
+	{
+		SlotReader = CreateReadArchive(FilePath);
+		check(SlotReader && SlotReader->IsLoading());
+	}
+
+	return ReadStateData(*SlotReader, Header.DataStart, Header.DataSize);
+}
+
+TArray<uint8> FPersistentStateSlot::ReadStateData(FArchive& Ar, int32 DataStart, int32 DataSize)
 {
 	check(Ar.IsLoading());
-	check(OutBuffer.IsEmpty());
+	
+	TArray<uint8> Data = FPersistentStateBufferPool::Get().Acquire(DataSize);
+	Data.SetNumUninitialized(DataSize);
 	
 	Ar.Seek(DataStart);
-	if (WITH_STATE_DATA_COMPRESSION)
-	{
-		TArray<uint8> CompressedData;
-		CompressedData.SetNumZeroed(DataSize);
-		
-		Ar.Serialize(CompressedData.GetData(), DataSize);
+	Ar.Serialize(Data.GetData(), DataSize);
+
+	return Data;
+}
 
+void FPersistentStateSlot::DecompressStateData(TArray<uint8>&& Data, TArray<uint8>& OutBuffer)
+{
+	check(OutBuffer.IsEmpty());
+	
+	if (WITH_STATE_DATA_COMPRESSION && !Data.IsEmpty())
+	{
+		FPersistentStateBufferPool& BufferPool = FPersistentStateBufferPool::Get();
 		{
 			TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_ReadCompressed, PersistentStateChannel);
-			FOodleCompressedArray::DecompressToTArray(OutBuffer, CompressedData);
+			// reserve uncompressed state size stored in the compressed data header
+			int32 CompressedSize = 0, DecompressedSize = 0;
+			FOodleCompressedArray::PeekSizes(Data, CompressedSize, DecompressedSize);
+			
+			OutBuffer = BufferPool.Acquire(DecompressedSize);
+			FOodleCompressedArray::DecompressToTArray(OutBuffer, Data);
 		}
+
+		BufferPool.Release(MoveTemp(Data));
 	}
 	else
 	{
-		OutBuffer.SetNumZeroed(DataSize);
-		Ar.Serialize(OutBuffer.GetData(), DataSize);
+		OutBuffer = MoveTemp(Data);
 	}
 }
 
-void FPersistentStateSlot::WriteCompressed(FArchive& Ar, TArray<uint8>& Buffer)
+void FPersistentStateSlot::WriteCompressed(FArchive& Ar, TConstArrayView<TPair<const TArray<uint8>*, FPersistentStateFixedInteger*>> Buffers)
 {
 	check(Ar.IsSaving());
 	if (WITH_STATE_DATA_COMPRESSION)
 	{
-		TArray<uint8> CompressedData;
+		// compress buffers in parallel, as long as total size of in flight buffers fits into a save window
+		const int64 WindowSize = static_cast<int64>(FMath::Max(UE::PersistentState::GPersistentState_SaveWindowSize, 1)) * 1024;
+		TArray<UE::Tasks::TTask<TArray<uint8>>, TInlineAllocator<2>> CompressTasks;
+		int64 InFlightSize = 0;
+
+		for (int32 Index = 0; Index < Buffers.Num(); ++Index)
 		{
-			TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_CompressState, PersistentStateChannel);
-			FOodleCompressedArray::CompressTArray(CompressedData, Buffer, FOodleDataCompression::ECompressor::Kraken, FOodleDataCompression::ECompressionLevel::HyperFast1);
+			// always launch at least one compression task, even if buffer is larger than a save window
+			while (CompressTasks.Num() < Buffers.Num() && (CompressTasks.Num() == Index || InFlightSize + Buffers[CompressTasks.Num()].Key->Num() <= WindowSize))
+			{
+				const TArray<uint8>* Buffer = Buffers[CompressTasks.Num()].Key;
+				InFlightSize += Buffer->Num();
+				CompressTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [Buffer]
+				{
+					return CompressStateData(*Buffer);
+				}));
+			}
+
+			const TArray<uint8>& Buffer = *Buffers[Index].Key;
+			TArray<uint8> CompressedData = MoveTemp(CompressTasks[Index].GetResult());
+			
+			*Buffers[Index].Value = Ar.Tell();
+			Ar.Serialize(CompressedData.GetData(), Buffer.Num());
+			
+			InFlightSize -= Buffer.Num();
+			FPersistentStateBufferPool::Get().Release(MoveTemp(CompressedData));
 		}
-		Ar.Serialize(CompressedData.GetData(), Buffer.Num());
 	}
 	else
 	{
-		Ar.Serialize(Buffer.GetData(), Buffer.Num());
+		for (const TPair<const TArray<uint8>*, FPersistentStateFixedInteger*>& Buffer: Buffers)
+		{
+			*Buffer.Value = Ar.Tell();
+			Ar.Serialize(const_cast<uint8*>(Buffer.Key->GetData()), Buffer.Key->Num());
+		}
+	}
+}
+
+TArray<uint8> FPersistentStateSlot::CompressStateData(const TArray<uint8>& Buffer)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateSlot_CompressState, PersistentStateChannel);
+	
+	// preallocate compression bound, so that compressor doesn't reallocate. Extra bytes are reserved for compressed array header
+	const int32 CompressionBound = FCompression::GetMaximumCompressedSize(NAME_Oodle, Buffer.Num()) + 2 * sizeof(int64);
+	TArray<uint8> CompressedData = FPersistentStateBufferPool::Get().Acquire(FMath::Max(CompressionBound, Buffer.Num()));
+	FOodleCompressedArray::CompressTArray(CompressedData, Buffer, FOodleDataCompression::ECompressor::Kraken, FOodleDataCompression::ECompressionLevel::HyperFast1);
+
+	return CompressedData;
+}
+
+void FPersistentStateSlot::CopyStateData(FArchive& SourceAr, FArchive& Ar, int32 DataStart, int32 DataSize, TArray<uint8>& Window)
+{
+	check(SourceAr.IsLoading() && Ar.IsSaving());
+	
+	const int32 WindowSize = FMath::Max(UE::PersistentState::GPersistentState_SaveWindowSize, 1) * 1024;
+	// window buffer only grows, it is shared between copies of all worlds
+	if (const int32 RequiredSize = FMath::Min(WindowSize, DataSize); Window.Num() < RequiredSize)
+	{
+		Window.SetNumUninitialized(RequiredSize);
+	}
+
+	SourceAr.Seek(DataStart);
+	for (int32 Offset = 0; Offset < DataSize; Offset += Window.Num())
+	{
+		const int32 ChunkSize = FMath::Min(Window.Num(), DataSize - Offset);
+		SourceAr.Serialize(Window.GetData(), ChunkSize);
+		Ar.Serialize(Window.GetData(), ChunkSize);
 	}
 }
@@ -1,12 +1,62 @@
 #include "PersistentStateSlotStorage.h"
 
 #include "ImageUtils.h"
+#include "PersistentStateCVars.h"
 #include "PersistentStateModule.h"
 #include "PersistentStateSerialization.h"
 #include "PersistentStateSettings.h"
 #include "PersistentStateSlotDescriptor.h"
 #include "PersistentStateStatics.h"
+#include "PersistentStateStorageScheduler.h"
+#include "Algo/AnyOf.h"
+#include "Async/AsyncFileHandle.h"
 #include "Engine/Texture2DDynamic.h"
+#include "Serialization/ArchiveProxy.h"
+#include "HAL/PlatformFileManager.h"
+#include "Tasks/Task.h"
+
+/**
+ * Archive proxy for background saves. Serializes data in blocks and yields to interactive storage tasks between them
+ */
+class FBackgroundStorageArchive: public FArchiveProxy
+{
+public:
+	/** block size between background task yields */
+	static constexpr int64 BlockSize = 64 * 1024;
+	
+	explicit FBackgroundStorageArchive(TUniquePtr<FArchive>&& InArchive)
+		: FArchiveProxy(*InArchive)
+		, Archive(MoveTemp(InArchive))
+	{}
+
+	/** @return background archive wrapping @InArchive, or nullptr if archive is not valid */
+	static TUniquePtr<FArchive> Create(TUniquePtr<FArchive>&& InArchive)
+	{
+		if (!InArchive.IsValid())
+		{
+			return {};
+		}
+		
+		return MakeUnique<FBackgroundStorageArchive>(MoveTemp(InArchive));
+	}
+
+	virtual void Serialize(void* Data, int64 Length) override
+	{
+		uint8* DataPtr = static_cast<uint8*>(Data);
+		while (Length > 0)
+		{
+			const int64 Size = FMath::Min(Length, BlockSize);
+			InnerArchive.Serialize(DataPtr, Size);
+			FPersistentStateStorageScheduler::Get().YieldBackgroundTask(Size);
+			
+			DataPtr += Size;
+			Length -= Size;
+		}
+	}
+
+private:
+	TUniquePtr<FArchive> Archive;
+};
 
 class FUpdateAvailableSlotsAsyncTask: public TSharedFromThis<FUpdateAvailableSlotsAsyncTask>
 {
@@ -114,26 +164,257 @@ public:
 		bLoadWorldState = !WorldState.IsValid() || WorldState->Header.GetWorld() != WorldToLoad;
 	}
 
-	void Run()
+	/**
+	 * Load game and world state. If async file read is enabled, state data is requested via async file handle and
+	 * decompressed from read completion callback, so that worker thread doesn't wait on disk.
+	 * @param CompletionEvent task completion event, not completed until both states are loaded
+	 */
+	void Run(const FGraphEventRef& CompletionEvent)
 	{
 		check(TargetSlot.IsValid());
+
+		if (PrefetchTask.IsValid() && !TakePrefetchedState(CompletionEvent))
+		{
+			// load continues after prefetch task is completed
+			return;
+		}
+
+		LoadState(CompletionEvent);
+	}
+
+	/** @return true if prefetch task should run, false if prefetch was taken over by a load before it started */
+	bool BeginPrefetch()
+	{
+		EPrefetchState Expected = EPrefetchState::Pending;
+		return PrefetchState.compare_exchange_strong(Expected, EPrefetchState::Running);
+	}
+
+private:
+	enum class EPrefetchState: uint8
+	{
+		Pending,
+		Running,
+		Cancelled
+	};
+
+	/** load game and world state that are not cached or prefetched */
+	void LoadState(const FGraphEventRef& CompletionEvent)
+	{
+		const bool bReadWorldState = bLoadWorldState && TargetSlot->HasWorldState(WorldToLoad);
+		if (!bLoadGameState && !bReadWorldState)
+		{
+			return;
+		}
+
+		if (UE::PersistentState::GPersistentStateStorage_AsyncFileRead && RunAsync(bReadWorldState, CompletionEvent))
+		{
+			return;
+		}
+
+		// load both states via a single reader, game and world state are decompressed concurrently
+		// @todo: opening a reader may fail if file was deleted
+		FGameStateSharedRef LoadedGameState;
+		FWorldStateSharedRef LoadedWorldState;
+		TargetSlot->LoadState(bLoadGameState, bReadWorldState ? WorldToLoad : NAME_None,
+			[](const FString& FilePath) { return UPersistentStateSlotStorage::CreateStateSlotReader(FilePath); },
+			LoadedGameState, LoadedWorldState
+		);
+
 		if (bLoadGameState)
 		{
-			GameState = TargetSlot->LoadGameState([](const FString& FilePath) { return UPersistentStateSlotStorage::CreateStateSlotReader(FilePath); });
+			GameState = MoveTemp(LoadedGameState);
 		}
-		if (bLoadWorldState && TargetSlot->HasWorldState(WorldToLoad))
+		if (bReadWorldState)
 		{
-			// @todo: opening a reader may fail if file was deleted
-			WorldState = TargetSlot->LoadWorldState(WorldToLoad, [](const FString& FilePath) { return UPersistentStateSlotStorage::CreateStateSlotReader(FilePath); });
+			WorldState = MoveTemp(LoadedWorldState);
 		}
 	}
+
+	/**
+	 * take world state from a prefetch task for the same world, or cancel prefetch if it hasn't started yet
+	 * @return false if prefetch is running, load is continued by a task chained to the prefetch event instead
+	 */
+	bool TakePrefetchedState(const FGraphEventRef& CompletionEvent)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FLoadStateAsyncTask_TakePrefetchedState, PersistentStateChannel);
+		
+		EPrefetchState Expected = EPrefetchState::Pending;
+		if (bLoadWorldState && !PrefetchTask->PrefetchState.compare_exchange_strong(Expected, EPrefetchState::Cancelled))
+		{
+			// prefetch is already reading world state, continue after it instead of reading the same data twice.
+			// Worker thread is not blocked while prefetch is in flight
+			FGraphEventRef ContinueEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Self = AsShared()](ENamedThreads::Type CurrentThread, const FGraphEventRef& ContinueCompletionEvent)
+			{
+				if (Self->PrefetchTask->WorldState.IsValid())
+				{
+					Self->WorldState = Self->PrefetchTask->WorldState;
+					Self->bLoadWorldState = false;
+				}
+				
+				Self->PrefetchTask.Reset();
+				Self->PrefetchEvent.SafeRelease();
+				Self->LoadState(ContinueCompletionEvent);
+			}, TStatId{}, PrefetchEvent, ENamedThreads::AnyHiPriThreadHiPriTask);
+			
+			CompletionEvent->DontCompleteUntil(ContinueEvent);
+			return false;
+		}
+
+		PrefetchTask.Reset();
+		PrefetchEvent.SafeRelease();
+		return true;
+	}
 	
+	/** pending state data reads, shared between read completion callbacks */
+	struct FAsyncReadContext
+	{
+		/** slot file and block files that store state data */
+		TArray<TUniquePtr<IAsyncReadFileHandle>, TInlineAllocator<2>> FileHandles;
+		/** read buffers, owned by the context while read requests are in flight */
+		TArray<TArray<uint8>, TInlineAllocator<2>> Buffers;
+		FGraphEventRef ReadsCompletedEvent;
+		std::atomic<int32> NumPendingReads{0};
+	};
+
+	/** @return false if file handles can't be opened, state should be loaded synchronously instead */
+	bool RunAsync(bool bReadWorldState, const FGraphEventRef& CompletionEvent)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FLoadStateAsyncTask_RunAsync, PersistentStateChannel);
+		
+		// create state shells, state buffers are filled by read callbacks. Second value is true for a game state read
+		TArray<TPair<FStateDataHeader, bool>, TInlineAllocator<2>> Reads;
+		if (bLoadGameState)
+		{
+			const FGameStateDataHeader& Header = TargetSlot->GetGameHeader();
+			GameState = MakeShared<FGameState>(FGameState::CreateLoadState(Header));
+			if (Header.HasData())
+			{
+				Reads.Emplace(Header, true);
+			}
+		}
+		if (bReadWorldState)
+		{
+			const FWorldStateDataHeader* Header = TargetSlot->FindWorldHeader(WorldToLoad);
+			check(Header);
+			
+			WorldState = MakeShared<FWorldState>(FWorldState::CreateLoadState(*Header));
+			if (Header->HasData())
+			{
+				Reads.Emplace(*Header, false);
+			}
+		}
+
+		if (Reads.IsEmpty())
+		{
+			return true;
+		}
+
+		// open a file handle per file, state data may be stored in the slot file or in the block store
+		TSharedRef<FAsyncReadContext> Context = MakeShared<FAsyncReadContext>();
+		TArray<FString, TInlineAllocator<2>> FilePaths;
+		TArray<IAsyncReadFileHandle*, TInlineAllocator<2>> ReadHandles;
+		for (const auto& [Header, bGameState]: Reads)
+		{
+			const FString FilePath = TargetSlot->GetStateDataPath(Header);
+			int32 HandleIndex = FilePaths.Find(FilePath);
+			if (HandleIndex == INDEX_NONE)
+			{
+				TUniquePtr<IAsyncReadFileHandle> FileHandle = UPersistentStateSlotStorage::CreateStateSlotAsyncReader(FilePath);
+				if (!FileHandle.IsValid())
+				{
+					return false;
+				}
+				
+				HandleIndex = FilePaths.Add(FilePath);
+				Context->FileHandles.Add(MoveTemp(FileHandle));
+			}
+			
+			ReadHandles.Add(Context->FileHandles[HandleIndex].Get());
+		}
+
+		// allocate all read buffers before the first request is issued, buffer array is not resized after that
+		for (const auto& [Header, bGameState]: Reads)
+		{
+			TArray<uint8>& Data = Context->Buffers.Add_GetRef(FPersistentStateBufferPool::Get().Acquire(Header.DataSize));
+			Data.SetNumUninitialized(Header.DataSize);
+		}
+		
+		Context->ReadsCompletedEvent = FGraphEvent::CreateGraphEvent();
+		Context->NumPendingReads = Reads.Num();
+		// load task is not completed until all reads are decompressed
+		CompletionEvent->DontCompleteUntil(Context->ReadsCompletedEvent);
+
+		for (int32 Index = 0; Index < Reads.Num(); ++Index)
+		{
+			const auto& [Header, bGameState] = Reads[Index];
+			FAsyncFileCallBack ReadCallback = [Context, Index, Header, bGameState, Self = AsShared()](bool bWasCancelled, IAsyncReadRequest* Request)
+			{
+				// request can't be deleted from its own callback, and decompression shouldn't run on IO thread
+				UE::Tasks::Launch(UE_SOURCE_LOCATION, [Context, Index, Header, bGameState, Request, bWasCancelled, Self]
+				{
+					Request->WaitCompletion();
+					delete Request;
+
+					TArray<uint8> Data = MoveTemp(Context->Buffers[Index]);
+					bool bResult = !bWasCancelled;
+					if (bResult)
+					{
+						TArray<uint8>& OutBuffer = bGameState ? Self->GameState->Buffer : Self->WorldState->Buffer;
+						FPersistentStateSlot::DecompressStateData(MoveTemp(Data), OutBuffer);
+						// delta is applied to a base state, which is read synchronously from the block store
+						FArchiveFactory CreateReadArchive = [](const FString& FilePath) { return UPersistentStateSlotStorage::CreateStateSlotReader(FilePath); };
+						bResult = Self->TargetSlot->ResolveStateDelta(Header, OutBuffer, CreateReadArchive);
+					}
+					else
+					{
+						UE_LOG(LogPersistentState, Error, TEXT("%s: failed to read state data from slot file %s."), *FString(__FUNCTION__), *Self->TargetSlot->GetFilePath());
+						FPersistentStateBufferPool::Get().Release(MoveTemp(Data));
+					}
+
+					if (!bResult)
+					{
+						// state without its data is not a valid load result
+						if (bGameState)
+						{
+							Self->GameState.Reset();
+						}
+						else
+						{
+							Self->WorldState.Reset();
+						}
+					}
+
+					if (--Context->NumPendingReads == 0)
+					{
+						// all requests are deleted, file handles can be closed
+						Context->FileHandles.Reset();
+						Context->ReadsCompletedEvent->DispatchSubsequents();
+					}
+				});
+			};
+
+			ReadHandles[Index]->ReadRequest(Header.DataStart, Header.DataSize, AIOP_Normal, &ReadCallback, Context->Buffers[Index].GetData());
+		}
+
+		return true;
+	}
+
+public:
 	FPersistentStateSlotSharedRef TargetSlot;
 	FGameStateSharedRef GameState;
 	FWorldStateSharedRef WorldState;
 	FName WorldToLoad = NAME_None;
 	bool bLoadGameState = false;
 	bool bLoadWorldState = false;
+
+	/** prefetch task for the same world that may already be in flight */
+	TSharedPtr<FLoadStateAsyncTask, ESPMode::ThreadSafe> PrefetchTask;
+	/** prefetch task event */
+	FGraphEventRef PrefetchEvent;
+	
+private:
+	/** prefetch state, prefetch task can be cancelled by a load before it starts */
+	std::atomic<EPrefetchState> PrefetchState{EPrefetchState::Pending};
 };
 
 UPersistentStateSlotStorage::UPersistentStateSlotStorage(const FObjectInitializer& Initializer)
@@ -180,14 +461,7 @@ uint32 UPersistentStateSlotStorage::GetAllocatedSize() const
 		TotalMemory += StateSlot->GetAllocatedSize();
 	}
 
-	if (CurrentGameState.IsValid())
-	{
-		TotalMemory += CurrentGameState->GetAllocatedSize();
-	}
-	if (CurrentWorldState.IsValid())
-	{
-		TotalMemory += CurrentWorldState->GetAllocatedSize();
-	}
+	TotalMemory += StateCache.GetAllocatedSize();
 #endif
 	
 	return TotalMemory;
@@ -203,22 +477,74 @@ void UPersistentStateSlotStorage::EnsureTaskCompletion() const
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	check(IsInGameThread());
 
-	// wait for ALL tasks to complete. last launched task requires all previous tasks to complete
-	FTaskGraphInterface::Get().WaitUntilTaskCompletes(LastQueuedEvent, ENamedThreads::GameThread);
+	// wait for ALL tasks to complete. last launched background task requires all previous tasks to complete,
+	// last launched interactive task requires all previous interactive tasks to complete
+	FGraphEventArray Events;
+	for (const FGraphEventRef& Event: {LastInteractiveEvent, LastBackgroundEvent})
+	{
+		if (Event.IsValid())
+		{
+			Events.Add(Event);
+		}
+	}
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(Events, ENamedThreads::GameThread);
 }
 
-FGraphEventArray UPersistentStateSlotStorage::GetPrerequisites() const
+FGraphEventArray UPersistentStateSlotStorage::GetPrerequisites(EPersistentStateTaskPriority Priority, TConstArrayView<FName> Slots)
 {
+	BackgroundTasks.RemoveAll([](const FBackgroundTask& Task)
+	{
+		return Task.Event->IsComplete();
+	});
+	
 	FGraphEventArray Prerequisites;
-	if (LastQueuedEvent.IsValid())
+	if (LastInteractiveEvent.IsValid())
 	{
-		Prerequisites.Add(LastQueuedEvent);
+		Prerequisites.Add(LastInteractiveEvent);
+	}
+
+	if (FPersistentStateStorageScheduler::IsBackground(Priority))
+	{
+		if (LastBackgroundEvent.IsValid())
+		{
+			Prerequisites.Add(LastBackgroundEvent);
+		}
+	}
+	else
+	{
+		// interactive tasks preempt background tasks that don't access the same slots. Loads don't wait for background loads,
+		// as concurrent reads from the same slot are safe
+		for (const FBackgroundTask& Task: BackgroundTasks)
+		{
+			if (Priority == EPersistentStateTaskPriority::InteractiveLoad && Task.Priority == EPersistentStateTaskPriority::BackgroundLoad)
+			{
+				continue;
+			}
+			
+			if (Slots.IsEmpty() || Task.Slots.IsEmpty() || Algo::AnyOf(Slots, [&Task](FName Slot) { return Task.Slots.Contains(Slot); }))
+			{
+				Prerequisites.Add(Task.Event);
+			}
+		}
 	}
 
 	return Prerequisites;
 }
 
-FGraphEventRef UPersistentStateSlotStorage::SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate)
+void UPersistentStateSlotStorage::AddQueuedTask(EPersistentStateTaskPriority Priority, TConstArrayView<FName> Slots, const FGraphEventRef& Event)
+{
+	if (FPersistentStateStorageScheduler::IsBackground(Priority))
+	{
+		LastBackgroundEvent = Event;
+		BackgroundTasks.Add(FBackgroundTask{Event, TArray<FName, TInlineAllocator<2>>{Slots}, Priority});
+	}
+	else
+	{
+		LastInteractiveEvent = Event;
+	}
+}
+
+FGraphEventRef UPersistentStateSlotStorage::SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority)
 {
 	check(IsInGameThread());
 	if (!GameState.IsValid() && !WorldState.IsValid())
@@ -247,37 +573,56 @@ FGraphEventRef UPersistentStateSlotStorage::SaveState(FGameStateSharedRef GameSt
 	CurrentSlot = TargetSlotHandle;
 	if (UPersistentStateSettings::Get()->ShouldCacheSlotState())
 	{
-		CurrentGameState = GameState;
-		CurrentWorldState = WorldState;
+		if (SourceSlot != TargetSlot)
+		{
+			// target slot receives source slot contents, states cached for the target slot are outdated
+			StateCache.RemoveSlot(TargetSlot->GetSlotName());
+		}
+		if (GameState.IsValid())
+		{
+			StateCache.AddGameState(TargetSlot->GetSlotName(), GameState);
+		}
+		if (WorldState.IsValid())
+		{
+			StateCache.AddWorldState(TargetSlot->GetSlotName(), WorldState);
+		}
+	}
+	else
+	{
+		StateCache.Reset();
 	}
 
 	// create save request with descriptor data
 	FPersistentStateSlotSaveRequest Request = FPersistentStateSlot::CreateSaveRequest(GetWorld(), *TargetSlot, TargetSlotHandle, GameState, WorldState);
 	
-	const FGraphEventArray Prerequisites = GetPrerequisites();
+	const FName Slots[] = {SourceSlot->GetSlotName(), TargetSlot->GetSlotName()};
+	const FGraphEventArray Prerequisites = GetPrerequisites(Priority, Slots);
 	const FString FilePath = UPersistentStateSettings::Get()->GetSaveGameFilePath(TargetSlot->GetSlotName());
-	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Request, SourceSlot, TargetSlot, FilePath, Descriptor=DefaultDescriptor]
+	const bool bBackgroundSave = FPersistentStateStorageScheduler::IsBackground(Priority);
+	const bool bUseBlockStore = UE::PersistentState::GPersistentStateStorage_BlockStore;
+	FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(Priority, [Request, SourceSlot, TargetSlot, FilePath, Descriptor=DefaultDescriptor, bBackgroundSave, bUseBlockStore](const FGraphEventRef&)
 	{
 		// @note: @SourceSlot is never modified for save operation!
 		// @todo: read and write to @TargetSlot are not synchronized. If save operation is in progress and @TargetSlot contents are being updated,
 		// descriptor may be corrupted if created during save op
-		AsyncSaveState(Request, SourceSlot, TargetSlot, FilePath, Descriptor);
-	}, TStatId{}, &Prerequisites, ENamedThreads::AnyHiPriThreadNormalTask);
+		AsyncSaveState(Request, SourceSlot, TargetSlot, FilePath, Descriptor, bBackgroundSave, bUseBlockStore);
+	}, Prerequisites);
 	
 	if (CompletedDelegate.IsBound())
 	{
-		LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([CompletedDelegate]
+		Event = FFunctionGraphTask::CreateAndDispatchWhenReady([CompletedDelegate]
 		{
 			CompletedDelegate.Execute();
-		}, TStatId{}, LastQueuedEvent, ENamedThreads::GameThread);
+		}, TStatId{}, Event, ENamedThreads::GameThread);
 	}
+	AddQueuedTask(Priority, Slots, Event);
 
 	if (UPersistentStateSettings::Get()->UseGameThread())
 	{
 		EnsureTaskCompletion();
 	}
 
-	return LastQueuedEvent;
+	return Event;
 }
 
 FGraphEventRef UPersistentStateSlotStorage::LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad, FLoadCompletedDelegate CompletedDelegate)
@@ -305,35 +650,51 @@ FGraphEventRef UPersistentStateSlotStorage::LoadState(const FPersistentStateSlot
 		return {};
 	}
 
-	if (TargetSlotHandle != CurrentSlot)
+	FGameStateSharedRef CachedGameState;
+	FWorldStateSharedRef CachedWorldState;
+	if (UPersistentStateSettings::Get()->ShouldCacheSlotState())
 	{
-		// reset cached game and world state if slot changes
-		CurrentGameState.Reset();
-		CurrentWorldState.Reset();
+		// states found in cache are not loaded from the slot file
+		CachedGameState = StateCache.FindGameState(TargetSlot->GetSlotName());
+		CachedWorldState = StateCache.FindWorldState(TargetSlot->GetSlotName(), WorldToLoad);
 	}
-	if (CurrentWorldState.IsValid() && CurrentWorldState->Header.GetWorld() != WorldToLoad)
+	else
 	{
-		// reset world state if loading a different world
-		CurrentWorldState.Reset();
+		StateCache.Reset();
 	}
 	CurrentSlot = TargetSlotHandle;
 	
-	TSharedPtr<FLoadStateAsyncTask, ESPMode::ThreadSafe> Task = MakeShared<FLoadStateAsyncTask>(TargetSlot, CurrentGameState, CurrentWorldState, WorldToLoad);
-	FGraphEventArray Prerequisites = GetPrerequisites();
-	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Task]
+	TSharedPtr<FLoadStateAsyncTask, ESPMode::ThreadSafe> Task = MakeShared<FLoadStateAsyncTask>(TargetSlot, CachedGameState, CachedWorldState, WorldToLoad);
+	if (!CachedWorldState.IsValid())
+	{
+		// take over world state prefetch that is still in flight
+		if (const FPrefetchRequest* Prefetch = PrefetchRequests.FindByPredicate([&TargetSlot, WorldToLoad](const FPrefetchRequest& Request)
+		{
+			return Request.Slot == TargetSlot->GetSlotName() && Request.World == WorldToLoad;
+		}); Prefetch && Prefetch->InvalidationCount == StateCache.GetInvalidationCount())
+		{
+			Task->PrefetchTask = Prefetch->Task;
+			Task->PrefetchEvent = Prefetch->Event;
+		}
+	}
+	
+	const FName Slots[] = {TargetSlot->GetSlotName()};
+	const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::InteractiveLoad, Slots);
+	FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::InteractiveLoad, [Task](const FGraphEventRef& CompletionEvent)
 	{
 		check(Task.IsValid());
-		Task->Run();
-	}, TStatId{}, &Prerequisites, ENamedThreads::AnyHiPriThreadNormalTask);
+		Task->Run(CompletionEvent);
+	}, Prerequisites);
 	
-	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Task, CompletedDelegate]
+	Event = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Task, CompletedDelegate]
 	{
 		check(IsInGameThread());
 		if (UPersistentStateSlotStorage* Storage = WeakThis.Get())
 		{
 			Storage->CompleteLoadState_GameThread(Task->TargetSlot, Task->GameState, Task->WorldState, CompletedDelegate);
 		}
-	}, TStatId{}, LastQueuedEvent, ENamedThreads::GameThread);
+	}, TStatId{}, Event, ENamedThreads::GameThread);
+	AddQueuedTask(EPersistentStateTaskPriority::InteractiveLoad, Slots, Event);
 	
 	if (UPersistentStateSettings::Get()->UseGameThread())
 	{
@@ -341,7 +702,7 @@ FGraphEventRef UPersistentStateSlotStorage::LoadState(const FPersistentStateSlot
 		EnsureTaskCompletion();
 	}
 
-	return LastQueuedEvent;
+	return Event;
 }
 
 void UPersistentStateSlotStorage::SaveStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle)
@@ -441,8 +802,24 @@ void UPersistentStateSlotStorage::CompleteLoadState_GameThread(FPersistentStateS
 	CurrentSlot = FPersistentStateSlotHandle{*this, TargetSlot->GetSlotName()};
 	if (UPersistentStateSettings::Get()->ShouldCacheSlotState())
 	{
-		CurrentGameState = LoadedGameState;
-		CurrentWorldState = LoadedWorldState;
+		if (LoadedGameState.IsValid())
+		{
+			StateCache.AddGameState(TargetSlot->GetSlotName(), LoadedGameState);
+		}
+		if (LoadedWorldState.IsValid())
+		{
+			StateCache.AddWorldState(TargetSlot->GetSlotName(), LoadedWorldState);
+		}
+
+		if (UE::PersistentState::GPersistentStateStorage_PrefetchLastSavedWorld)
+		{
+			// player is likely to return to the last saved world of the active slot
+			const FName LastSavedWorld{TargetSlot->GetLastSavedWorld()};
+			if (LastSavedWorld != NAME_None && (!LoadedWorldState.IsValid() || LoadedWorldState->Header.GetWorld() != LastSavedWorld))
+			{
+				PrefetchWorldState(TargetSlot, LastSavedWorld);
+			}
+		}
 	}
 			
 	if (CompletedDelegate.IsBound())
@@ -451,6 +828,86 @@ void UPersistentStateSlotStorage::CompleteLoadState_GameThread(FPersistentStateS
 	}
 }
 
+FGraphEventRef UPersistentStateSlotStorage::PrefetchState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad)
+{
+	check(IsInGameThread());
+	
+	FPersistentStateSlotSharedRef TargetSlot = FindSlot(TargetSlotHandle);
+	if (!TargetSlot.IsValid() || !UPersistentStateSettings::Get()->ShouldCacheSlotState())
+	{
+		// prefetched states are delivered via state cache
+		return {};
+	}
+
+	return PrefetchWorldState(TargetSlot, WorldToLoad);
+}
+
+FGraphEventRef UPersistentStateSlotStorage::PrefetchWorldState(const FPersistentStateSlotSharedRef& TargetSlot, FName World)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	const FName SlotName = TargetSlot->GetSlotName();
+	if (!TargetSlot->HasFilePath() || !TargetSlot->HasWorldState(World) || StateCache.HasWorldState(SlotName, World))
+	{
+		return {};
+	}
+
+	const uint32 InvalidationCount = StateCache.GetInvalidationCount();
+	if (PrefetchRequests.ContainsByPredicate([SlotName, World, InvalidationCount](const FPrefetchRequest& Request)
+	{
+		return Request.Slot == SlotName && Request.World == World && Request.InvalidationCount == InvalidationCount;
+	}))
+	{
+		// world state is already being prefetched
+		return {};
+	}
+
+	// only world state is loaded, game state is not required for prefetch
+	TSharedPtr<FLoadStateAsyncTask, ESPMode::ThreadSafe> Task = MakeShared<FLoadStateAsyncTask>(TargetSlot, nullptr, nullptr, World);
+	Task->bLoadGameState = false;
+	
+	const FName Slots[] = {SlotName};
+	const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::BackgroundLoad, Slots);
+	FGraphEventRef PrefetchEvent = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::BackgroundLoad, [Task](const FGraphEventRef& CompletionEvent)
+	{
+		check(Task.IsValid());
+		if (Task->BeginPrefetch())
+		{
+			Task->Run(CompletionEvent);
+		}
+	}, Prerequisites);
+	PrefetchRequests.Add(FPrefetchRequest{SlotName, World, Task, PrefetchEvent, InvalidationCount});
+
+	FGraphEventRef Event = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Task, InvalidationCount]
+	{
+		check(IsInGameThread());
+		UPersistentStateSlotStorage* Storage = WeakThis.Get();
+		if (Storage == nullptr)
+		{
+			return;
+		}
+		
+		Storage->PrefetchRequests.RemoveAllSwap([&Task](const FPrefetchRequest& Request) { return Request.Task == Task; });
+		if (!Task->WorldState.IsValid())
+		{
+			// prefetch was taken over by a load
+			return;
+		}
+
+		// discard prefetched state if slot was removed or modified, or world state was already cached by save or load
+		const FName SlotName = Task->TargetSlot->GetSlotName();
+		if (Storage->FindSlot(SlotName) == Task->TargetSlot && Storage->StateCache.GetInvalidationCount() == InvalidationCount &&
+			!Storage->StateCache.HasWorldState(SlotName, Task->WorldToLoad) && UPersistentStateSettings::Get()->ShouldCacheSlotState())
+		{
+			Storage->StateCache.AddWorldState(SlotName, Task->WorldState);
+		}
+	}, TStatId{}, PrefetchEvent, ENamedThreads::GameThread);
+	AddQueuedTask(EPersistentStateTaskPriority::BackgroundLoad, Slots, Event);
+
+	return Event;
+}
+
 FGraphEventRef UPersistentStateSlotStorage::UpdateAvailableStateSlots(FSlotUpdateCompletedDelegate CompletedDelegate)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
@@ -467,26 +924,28 @@ FGraphEventRef UPersistentStateSlotStorage::UpdateAvailableStateSlots(FSlotUpdat
 		Task->NamedSlots.Add(Slot);
 	}
 
-	FGraphEventArray Prerequisites = GetPrerequisites();
-	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([Task]
+	// slot scan may access any slot
+	const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::SlotScan, {});
+	FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::SlotScan, [Task](const FGraphEventRef&)
 	{
 		Task->Run();
-	}, TStatId{}, &Prerequisites, ENamedThreads::AnyHiPriThreadNormalTask);
+	}, Prerequisites);
 	
-	LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Task, CompletedDelegate]
+	Event = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Task, CompletedDelegate]
 	{
 		if (UPersistentStateSlotStorage* Storage = WeakThis.Get())
 		{
 			Storage->CompleteSlotUpdate_GameThread(*Task, CompletedDelegate);
 		}
-	}, TStatId{}, LastQueuedEvent, ENamedThreads::GameThread);
+	}, TStatId{}, Event, ENamedThreads::GameThread);
+	AddQueuedTask(EPersistentStateTaskPriority::SlotScan, {}, Event);
 
 	if (UPersistentStateSettings::Get()->UseGameThread())
 	{
 		EnsureTaskCompletion();
 	}
 
-	return LastQueuedEvent;
+	return Event;
 }
 
 void UPersistentStateSlotStorage::CompleteSlotUpdate_GameThread(const FUpdateAvailableSlotsAsyncTask& Task, FSlotUpdateCompletedDelegate CompletedDelegate)
@@ -494,15 +953,33 @@ void UPersistentStateSlotStorage::CompleteSlotUpdate_GameThread(const FUpdateAva
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	check(IsInGameThread());
 
-	NamedSlots = Task.NamedSlots;
-	RuntimeSlots = Task.RuntimeSlots;
-	
-	if (!CurrentSlot.IsValid())
+	TArray<FPersistentStateSlotSharedRef> ScannedNamedSlots = Task.NamedSlots;
+	TArray<FPersistentStateSlotSharedRef> ScannedRuntimeSlots = Task.RuntimeSlots;
+	for (TArray<FPersistentStateSlotSharedRef>* SlotList: {&ScannedNamedSlots, &ScannedRuntimeSlots})
 	{
-		// reset game data for slot that no more exists
-		CurrentGameState.Reset();
-		CurrentWorldState.Reset();
+		for (FPersistentStateSlotSharedRef& Slot: *SlotList)
+		{
+			// keep slots associated with the same slot file. Saves queued after the scan hold existing slot and
+			// update its headers, scanned slot headers would be stale after that
+			FPersistentStateSlotSharedRef ExistingSlot = FindSlot(Slot->GetSlotName());
+			if (ExistingSlot.IsValid() && ExistingSlot->HasFilePath() && ExistingSlot->GetFilePath() == Slot->GetFilePath())
+			{
+				Slot = ExistingSlot;
+			}
+		}
 	}
+	
+	NamedSlots = MoveTemp(ScannedNamedSlots);
+	RuntimeSlots = MoveTemp(ScannedRuntimeSlots);
+	
+	// remove cached states for slots that no more exist
+	StateCache.RemoveSlots([this](FName SlotName)
+	{
+		return FindSlot(SlotName).IsValid();
+	});
+
+	// blocks may be left unreferenced by slots overwritten or removed outside of the storage
+	CollectUnreferencedBlocks();
 
 	if (CompletedDelegate.IsBound())
 	{
@@ -547,6 +1024,93 @@ FPersistentStateSlotHandle UPersistentStateSlotStorage::CreateStateSlot(const FN
 	return SlotHandle;
 }
 
+FPersistentStateSlotHandle UPersistentStateSlotStorage::DuplicateStateSlot(const FPersistentStateSlotHandle& SourceSlotHandle, FName SlotName)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// ensure that any update tasks are completed, for the same reasons as in CreateStateSlot.
+	// Also ensures that source slot headers are not modified by in progress saves
+	EnsureTaskCompletion();
+
+	FPersistentStateSlotSharedRef SourceSlot = FindSlot(SourceSlotHandle);
+	if (!SourceSlot.IsValid() || !SourceSlot->HasFilePath())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: source slot %s doesn't have saved state."), *FString(__FUNCTION__), *SourceSlotHandle.ToString());
+		return {};
+	}
+	
+	if (FindSlot(SlotName).IsValid())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: trying to create slot with name %s that already exists."), *FString(__FUNCTION__), *SlotName.ToString());
+		return {};
+	}
+
+	const UPersistentStateSettings* Settings = UPersistentStateSettings::Get();
+	const FString FilePath = Settings->GetSaveGameFilePath(SlotName);
+	
+	FPersistentStateSlotSharedRef Slot = MakeShared<FPersistentStateSlot>(SourceSlot->CreateDuplicate(SlotName, FilePath));
+	RuntimeSlots.Add(Slot);
+
+	FString ScreenshotFilePath, SourceScreenshotFilePath;
+	if (HasStateSlotScreenshotFile(SourceSlot))
+	{
+		ScreenshotFilePath = Settings->GetScreenshotFilePath(SlotName);
+		SourceScreenshotFilePath = Settings->GetScreenshotFilePath(SourceSlot->GetSlotName());
+	}
+
+	// copy slot file as is. With block store enabled, slot file only holds headers and world deltas,
+	// state data is shared via block references and slots diverge on the next save
+	const FName Slots[] = {SourceSlot->GetSlotName(), Slot->GetSlotName()};
+	const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::InteractiveSave, Slots);
+	TSharedRef<bool, ESPMode::ThreadSafe> bCopied = MakeShared<bool, ESPMode::ThreadSafe>(false);
+	FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::InteractiveSave,
+	[FilePath, SourceFilePath=SourceSlot->GetFilePath(), ScreenshotFilePath, SourceScreenshotFilePath, bCopied](const FGraphEventRef&)
+	{
+		IFileManager& FileManager = IFileManager::Get();
+		*bCopied = FileManager.Copy(*FilePath, *SourceFilePath, true, true) == COPY_OK;
+		if (!*bCopied)
+		{
+			UE_LOG(LogPersistentState, Error, TEXT("%s: failed to copy slot file %s to %s."), *FString(__FUNCTION__), *SourceFilePath, *FilePath);
+			// remove partially copied file, so that it is not discovered as a slot later
+			RemoveStateSlotFile(FilePath);
+			return;
+		}
+
+		if (!ScreenshotFilePath.IsEmpty() && FileManager.Copy(*ScreenshotFilePath, *SourceScreenshotFilePath, true, true) != COPY_OK)
+		{
+			// slot is still valid without a screenshot
+			UE_LOG(LogPersistentState, Warning, TEXT("%s: failed to copy screenshot file %s to %s."), *FString(__FUNCTION__), *SourceScreenshotFilePath, *ScreenshotFilePath);
+		}
+	}, Prerequisites);
+
+	Event = FFunctionGraphTask::CreateAndDispatchWhenReady([WeakThis=TWeakObjectPtr<ThisClass>{this}, Slot, bCopied]
+	{
+		check(IsInGameThread());
+		UPersistentStateSlotStorage* Storage = WeakThis.Get();
+		if (Storage == nullptr || *bCopied)
+		{
+			return;
+		}
+
+		// slot was registered before its file was copied, remove it so that slot handle is no longer valid
+		if (Storage->CurrentSlot.GetSlotName() == Slot->GetSlotName())
+		{
+			Storage->CurrentSlot = {};
+		}
+		Storage->StateCache.RemoveSlot(Slot->GetSlotName());
+		Storage->RuntimeSlots.RemoveSwap(Slot);
+	}, TStatId{}, Event, ENamedThreads::GameThread);
+	AddQueuedTask(EPersistentStateTaskPriority::InteractiveSave, Slots, Event);
+
+	if (Settings->UseGameThread())
+	{
+		EnsureTaskCompletion();
+	}
+	
+	return FPersistentStateSlotHandle{*this, SlotName};
+}
+
 void UPersistentStateSlotStorage::GetAvailableStateSlots(TArray<FPersistentStateSlotHandle>& OutStates, bool bOnDiskOnly)
 {
 	OutStates.Reset(NamedSlots.Num() + RuntimeSlots.Num());
@@ -637,9 +1201,8 @@ void UPersistentStateSlotStorage::RemoveStateSlot(const FPersistentStateSlotHand
 	{
 		// remove cached game data if slot is being removed
 		CurrentSlot = {};
-		CurrentGameState.Reset();
-		CurrentWorldState.Reset();
 	}
+	StateCache.RemoveSlot(StateSlot->GetSlotName());
 	
 	if (HasStateSlotScreenshotFile(StateSlot))
 	{
@@ -652,14 +1215,16 @@ void UPersistentStateSlotStorage::RemoveStateSlot(const FPersistentStateSlotHand
 	{
 		// launch async task to remove file associated with a slot
 		// we can't remove a storage file right away, as they're may be already launched save/load ops
-		FGraphEventArray Prerequisites = GetPrerequisites();
-		LastQueuedEvent = FFunctionGraphTask::CreateAndDispatchWhenReady([FilePath=StateSlot->GetFilePath()]
+		const FName Slots[] = {StateSlot->GetSlotName()};
+		const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::InteractiveSave, Slots);
+		FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::InteractiveSave, [FilePath=StateSlot->GetFilePath()](const FGraphEventRef&)
 		{
 			if (!FilePath.IsEmpty())
 			{
 				RemoveStateSlotFile(FilePath);
 			}
-		}, TStatId{}, &Prerequisites, ENamedThreads::AnyHiPriThreadNormalTask);
+		}, Prerequisites);
+		AddQueuedTask(EPersistentStateTaskPriority::InteractiveSave, Slots, Event);
 	}
 
 	if (bNamedSlot)
@@ -675,13 +1240,76 @@ void UPersistentStateSlotStorage::RemoveStateSlot(const FPersistentStateSlotHand
 
 	// remove from queued slots for screenshot capture
 	SlotsForScreenshotCapture.Remove(SlotHandle);
+
+	// remove blocks that were referenced only by the removed slot
+	CollectUnreferencedBlocks();
+}
+
+void UPersistentStateSlotStorage::CollectUnreferencedBlocks()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(IsInGameThread());
+
+	// block collection may access any slot. Block references are read from slot files on disk after all previously
+	// queued saves are complete, as in-memory slot headers may be stale (e.g. replaced by a slot scan while a save was in flight)
+	const UPersistentStateSettings* Settings = UPersistentStateSettings::Get();
+	const FString SaveGamePath = Settings->GetSaveGamePath();
+	const FString BlockStorePath = FPersistentStateSlot::GetBlockStorePath(SaveGamePath);
+	const FGraphEventArray Prerequisites = GetPrerequisites(EPersistentStateTaskPriority::BackgroundSave, {});
+	FGraphEventRef Event = FPersistentStateStorageScheduler::Get().Dispatch(EPersistentStateTaskPriority::BackgroundSave,
+	[SaveGamePath, BlockStorePath, Extension=Settings->GetSaveGameExtension()](const FGraphEventRef&)
+	{
+		IFileManager& FileManager = IFileManager::Get();
+		if (!FileManager.DirectoryExists(*BlockStorePath))
+		{
+			return;
+		}
+
+		TArray<FString> SaveGameFiles;
+		FileManager.FindFiles(SaveGameFiles, *SaveGamePath, *Extension);
+		
+		TMap<FString, int32> RefCounts;
+		for (const FString& SaveGameFile: SaveGameFiles)
+		{
+			const FString FilePath = FPaths::ConvertRelativePathToFull(SaveGamePath / SaveGameFile);
+			TUniquePtr<FArchive> ReadArchive = CreateStateSlotReader(FilePath);
+			if (!ReadArchive.IsValid())
+			{
+				// slot file can't be read, don't remove blocks it may reference
+				UE_LOG(LogPersistentState, Warning, TEXT("%s: failed to read slot file %s, unreferenced blocks are not removed."), *FString(__FUNCTION__), *FilePath);
+				return;
+			}
+
+			const FPersistentStateSlot Slot{*ReadArchive, FilePath};
+			if (Slot.IsValidSlot())
+			{
+				Slot.AddBlockReferences(RefCounts);
+			}
+		}
+
+		// no other storage task runs at this point, so temporary files are left over from interrupted block writes
+		TArray<FString> Files;
+		FileManager.FindFiles(Files, *(BlockStorePath / TEXT("*")), true, false);
+		for (const FString& File: Files)
+		{
+			const FString BlockHash = FPaths::GetBaseFilename(File);
+			if (!File.EndsWith(TEXT(".blk")) || !RefCounts.Contains(BlockHash))
+			{
+				UE_LOG(LogPersistentState, Verbose, TEXT("%s: removed unreferenced block %s."), *FString(__FUNCTION__), *File);
+				FileManager.Delete(*(BlockStorePath / File), false, false, true);
+			}
+		}
+	}, Prerequisites);
+	AddQueuedTask(EPersistentStateTaskPriority::BackgroundSave, {}, Event);
 }
 
 void UPersistentStateSlotStorage::AsyncSaveState(
 	const FPersistentStateSlotSaveRequest& Request,
 	FPersistentStateSlotSharedRef SourceSlot, FPersistentStateSlotSharedRef TargetSlot,
 	const FString& FilePath,
-	TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor
+	TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor,
+	bool bBackgroundSave,
+	bool bUseBlockStore
 )
 {
 	check(Request.IsValid());
@@ -708,11 +1336,31 @@ void UPersistentStateSlotStorage::AsyncSaveState(
 			CreateStateSlotFile(Slot, FilePath);
 		}
 		
-		Slot->SaveState(
-			*SourceSlot, Request,
-			[](const FString& FilePath) { return CreateStateSlotReader(FilePath); },
-			[](const FString& FilePath) { return CreateStateSlotWriter(FilePath); }
-		);
+		bool bSaved = false;
+		if (bBackgroundSave)
+		{
+			// background save is read and written in blocks, yielding to interactive tasks between them
+			bSaved = Slot->SaveState(
+				*SourceSlot, Request,
+				[](const FString& FilePath) { return FBackgroundStorageArchive::Create(CreateStateSlotReader(FilePath)); },
+				[](const FString& FilePath) { return FBackgroundStorageArchive::Create(CreateStateSlotWriter(FilePath)); },
+				false, bUseBlockStore
+			);
+		}
+		else
+		{
+			bSaved = Slot->SaveState(
+				*SourceSlot, Request,
+				[](const FString& FilePath) { return CreateStateSlotReader(FilePath); },
+				[](const FString& FilePath) { return CreateStateSlotWriter(FilePath); },
+				false, bUseBlockStore
+			);
+		}
+
+		if (!bSaved)
+		{
+			UE_LOG(LogPersistentState, Error, TEXT("%s: failed to save state slot %s, slot keeps its previous state."), *FString(__FUNCTION__), *Slot->GetSlotName().ToString());
+		}
 	}
 }
 
@@ -784,6 +1432,15 @@ TUniquePtr<FArchive> UPersistentStateSlotStorage::CreateStateSlotReader(const FS
 	return TUniquePtr<FArchive>{FileManager.CreateFileReader(*FilePath, FILEREAD_Silent)};
 }
 
+TUniquePtr<IAsyncReadFileHandle> UPersistentStateSlotStorage::CreateStateSlotAsyncReader(const FString& FilePath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	UE_LOG(LogPersistentState, Verbose, TEXT("StateSlot async file reader: %s"), *FilePath);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	return TUniquePtr<IAsyncReadFileHandle>{PlatformFile.OpenAsyncRead(*FilePath)};
+}
+
 TUniquePtr<FArchive> UPersistentStateSlotStorage::CreateStateSlotWriter(const FString& FilePath)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
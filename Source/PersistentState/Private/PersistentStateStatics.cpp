@@ -7,7 +7,9 @@
 #include "PersistentStateObjectId.h"
 #include "PersistentStateSlot.h"
 #include "PersistentStateModule.h"
+#include "PersistentStateSchema.h"
 #include "PersistentStateSerialization.h"
+#include "PersistentStateTraits.h"
 
 #include "Managers/PersistentStateManager.h"
 #include "HAL/ThreadHeartBeat.h"
@@ -16,6 +18,19 @@ namespace UE::PersistentState
 {
 static FName StaticActorTag{TEXT("PersistentState_Static")};
 static FName DynamicActorTag{TEXT("PersistentState_Dynamic")};
+static FName GameStateSizeKey{TEXT("PersistentState_GameState")};
+
+/** @return state buffer size to reserve for estimated state size, with extra headroom for state growth */
+static int32 GetReserveSize(FName State, TConstArrayView<UPersistentStateManager*> Managers, const FPersistentStateSizeEstimate* SizeEstimate)
+{
+	if (SizeEstimate == nullptr)
+	{
+		return 0;
+	}
+
+	const int32 Estimate = SizeEstimate->EstimateStateSize(State, Managers);
+	return Estimate + Estimate / 8;
+}
 
 void WaitForTask(UE::Tasks::FTask Task)
 {
@@ -97,6 +112,8 @@ void ResetSaveGames(const FString& Path, const FString& Extension)
 			PlatformFile.DeleteFile(*FileName);
 		}
 
+		// block store is shared between slots and is stored in a subdirectory
+		PlatformFile.DeleteDirectoryRecursively(*FPersistentStateSlot::GetBlockStorePath(Path));
 		PlatformFile.DeleteDirectory(Directory);
 	}
 }
@@ -235,14 +252,19 @@ void LoadWorldState(TConstArrayView<UPersistentStateManager*> Managers, const FW
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	UE_LOG(LogPersistentState, Verbose, TEXT("%s: world %s, chunk count %d"), *FString(__FUNCTION__), *WorldState->Header.World, WorldState->Header.ChunkCount);
 	
+	check(WorldState->Header.IsValid());
+	if (!WorldState->Header.IsSupportedVersion())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: world %s is saved with unsupported format version %u. World state is not loaded."),
+			*FString(__FUNCTION__), *WorldState->Header.World, WorldState->Header.FormatVersion);
+		return;
+	}
+	
 	FPersistentStateMemoryReader StateReader{WorldState->Buffer, true};
 	StateReader.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-	FPersistentStateProxyArchive StateArchive{StateReader};
-
-	check(StateArchive.Tell() == 0);
-	check(WorldState->Header.IsValid());
+	check(StateReader.Tell() == 0);
 	
-	Private::LoadManagerState(StateArchive, Managers, WorldState->Header.ChunkCount, WorldState->Header.ObjectTablePosition, WorldState->Header.StringTablePosition);
+	Private::LoadManagerState(StateReader, Managers, WorldState->Header.ChunkCount, WorldState->Header.ObjectTablePosition, WorldState->Header.StringTablePosition, WorldState->Header.SchemaTablePosition);
 }
 
 void LoadGameState(TConstArrayView<UPersistentStateManager*> Managers, const FGameStateSharedRef& GameState)
@@ -256,22 +278,29 @@ void LoadGameState(TConstArrayView<UPersistentStateManager*> Managers, const FGa
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	UE_LOG(LogPersistentState, Verbose, TEXT("%s: chunk count %d"), *FString(__FUNCTION__), GameState->Header.ChunkCount);
 	
+	check(GameState->Header.IsValid());
+	if (!GameState->Header.IsSupportedVersion())
+	{
+		UE_LOG(LogPersistentState, Error, TEXT("%s: game state is saved with unsupported format version %u. Game state is not loaded."),
+			*FString(__FUNCTION__), GameState->Header.FormatVersion);
+		return;
+	}
+	
 	FPersistentStateMemoryReader StateReader{GameState->Buffer, true};
 	StateReader.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-	FPersistentStateProxyArchive StateArchive{StateReader};
-	check(StateArchive.Tell() == 0);
-	check(GameState->Header.IsValid());
+	check(StateReader.Tell() == 0);
 
-	Private::LoadManagerState(StateArchive, Managers, GameState->Header.ChunkCount, GameState->Header.ObjectTablePosition, GameState->Header.StringTablePosition);
+	Private::LoadManagerState(StateReader, Managers, GameState->Header.ChunkCount, GameState->Header.ObjectTablePosition, GameState->Header.StringTablePosition, GameState->Header.SchemaTablePosition);
 }
 	
-FWorldStateSharedRef CreateWorldState(const FString& World, const FString& WorldPackage, TConstArrayView<UPersistentStateManager*> Managers)
+FWorldStateSharedRef CreateWorldState(const FString& World, const FString& WorldPackage, TConstArrayView<UPersistentStateManager*> Managers, FPersistentStateSizeEstimate* SizeEstimate)
 {
 	check(!World.IsEmpty() && !WorldPackage.IsEmpty());
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	UE_LOG(LogPersistentState, Verbose, TEXT("%s: world %s, chunk count %d"), *FString(__FUNCTION__), *World, Managers.Num());
 	
-	FWorldStateSharedRef WorldState = MakeShared<FWorldState>(FWorldState::CreateSaveState());
+	const FName WorldName{World};
+	FWorldStateSharedRef WorldState = MakeShared<FWorldState>(FWorldState::CreateSaveState(GetReserveSize(WorldName, Managers, SizeEstimate)));
 	WorldState->Header.ChunkCount = Managers.Num();
 	// will be deduced later
 	WorldState->Header.DataSize = 0;
@@ -282,42 +311,50 @@ FWorldStateSharedRef CreateWorldState(const FString& World, const FString& World
 	{
 		FPersistentStateMemoryWriter StateWriter{WorldState->GetData(), true};
 		StateWriter.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-		FPersistentStateProxyArchive StateArchive{StateWriter};
 	
-		const int32 DataStart = StateArchive.Tell();
-		Private::SaveManagerState(StateArchive, Managers, WorldState->Header.ObjectTablePosition, WorldState->Header.StringTablePosition);
-		const int32 DataEnd = StateArchive.Tell();
+		const int32 DataStart = StateWriter.Tell();
+		Private::SaveManagerState(StateWriter, Managers, WorldState->Header.ObjectTablePosition, WorldState->Header.StringTablePosition, WorldState->Header.SchemaTablePosition, SizeEstimate);
+		const int32 DataEnd = StateWriter.Tell();
 		
 		WorldState->Header.DataSize = DataEnd - DataStart;
 	}
+
+	if (SizeEstimate != nullptr)
+	{
+		SizeEstimate->AddStateSample(WorldName, WorldState->Header.DataSize);
+	}
 	
 	check(WorldState->Header.IsValid());
 	
 	return WorldState;
 }
 
-FGameStateSharedRef CreateGameState(TConstArrayView<UPersistentStateManager*> Managers)
+FGameStateSharedRef CreateGameState(TConstArrayView<UPersistentStateManager*> Managers, FPersistentStateSizeEstimate* SizeEstimate)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	UE_LOG(LogPersistentState, Verbose, TEXT("%s: chunk count %d"), *FString(__FUNCTION__), Managers.Num());
 
-	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState(GetReserveSize(GameStateSizeKey, Managers, SizeEstimate)));
 	GameState->Header.ChunkCount = Managers.Num();
 	// will be deduced later
 	GameState->Header.DataSize = 0;
 	
 	FPersistentStateMemoryWriter StateWriter{GameState->GetData(), true};
 	StateWriter.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-	FPersistentStateProxyArchive StateArchive{StateWriter};
 
 	if (Managers.Num() > 0)
 	{
-		const int32 DataStart = StateArchive.Tell();
-		Private::SaveManagerState(StateArchive, Managers, GameState->Header.ObjectTablePosition, GameState->Header.StringTablePosition);
-		const int32 DataEnd = StateArchive.Tell();
+		const int32 DataStart = StateWriter.Tell();
+		Private::SaveManagerState(StateWriter, Managers, GameState->Header.ObjectTablePosition, GameState->Header.StringTablePosition, GameState->Header.SchemaTablePosition, SizeEstimate);
+		const int32 DataEnd = StateWriter.Tell();
 
 		GameState->Header.DataSize = DataEnd - DataStart;
 		check(GameState->Header.IsValid());
+
+		if (SizeEstimate != nullptr)
+		{
+			SizeEstimate->AddStateSample(GameStateSizeKey, GameState->Header.DataSize);
+		}
 	}
 	
 	return GameState;
@@ -326,27 +363,25 @@ FGameStateSharedRef CreateGameState(TConstArrayView<UPersistentStateManager*> Ma
 namespace Private
 {
 	
-void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32 ChunkCount, uint32 ObjectTablePosition, uint32 StringTablePosition)
+void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32 ChunkCount, uint32 ObjectTablePosition, uint32 StringTablePosition, uint32 SchemaTablePosition)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 
-	constexpr bool bLoading = true;
+	// register class schemas before any property bunch is loaded
+	FPersistentStateSchemaRegistry::Get().ReadSchemaTable(Ar, SchemaTablePosition);
 
-	FPersistentStateStringTrackerProxy<bLoading> StringProxy{Ar};
-	StringProxy.ReadFromArchive(Ar, StringTablePosition);
+	constexpr bool bLoading = true;
 
 	FPersistentStateObjectTracker ObjectTracker{};
-	FPersistentStateObjectTrackerProxy<bLoading, ESerializeObjectDependency::All> ObjectProxy{StringProxy, ObjectTracker};
-	ObjectProxy.ReadFromArchive(StringProxy, ObjectTablePosition);
+	FPersistentStateStateArchive<bLoading, ESerializeObjectDependency::All> StateArchive{Ar, ObjectTracker};
+	StateArchive.ReadTables(ObjectTablePosition, StringTablePosition);
 
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateLoadFormatter(ObjectProxy);
-	FStructuredArchive StructuredArchive{*Formatter};
-	FStructuredArchive::FRecord RootRecord = StructuredArchive.Open().EnterRecord();
+	FPersistentStateRecord RootRecord{StateArchive};
 
 	for (uint32 Count = 0; Count < ChunkCount; ++Count)
 	{
 		FPersistentStateDataChunkHeader ChunkHeader{};
-		RootRecord << SA_VALUE(TEXT("ChunkHeader"), ChunkHeader);
+		RootRecord.Serialize(TEXT("ChunkHeader"), ChunkHeader);
 		check(!ChunkHeader.IsEmpty());
 
 		UClass* ChunkClass = ChunkHeader.ChunkType.ResolveClass();
@@ -354,7 +389,7 @@ void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Ma
 		{
 			UE_LOG(LogPersistentState, Error, TEXT("%s: failed to find state manager CLASS %s required by a chunk header."), *FString(__FUNCTION__), *ChunkHeader.ChunkType.ToString());
 			// skip chunk data
-			ObjectProxy.Seek(ObjectProxy.Tell() + ChunkHeader.ChunkSize);
+			StateArchive.Seek(StateArchive.Tell() + ChunkHeader.ChunkSize);
 			continue;
 		}
 	
@@ -366,7 +401,7 @@ void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Ma
 		{
 			UE_LOG(LogPersistentState, Error, TEXT("%s: failed to find state manager INSTANCE %s required by a chunk header."), *FString(__FUNCTION__), *ChunkHeader.ChunkType.ToString());
 			// skip chunk data
-			ObjectProxy.Seek(ObjectProxy.Tell() + ChunkHeader.ChunkSize);
+			StateArchive.Seek(StateArchive.Tell() + ChunkHeader.ChunkSize);
 			continue;
 		}
 
@@ -376,25 +411,23 @@ void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Ma
 		StateManager->PreLoadState();
 		{
 			FScopeCycleCounterUObject Scope{StateManager};
-			StateManager->Serialize(RootRecord);
+			RootRecord.SerializeObject(*StateManager);
 		}
 		StateManager->PostLoadState();
 	}
 }
 
-void SaveManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32& OutObjectTablePosition, uint32& OutStringTablePosition)
+void SaveManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32& OutObjectTablePosition, uint32& OutStringTablePosition, uint32& OutSchemaTablePosition, FPersistentStateSizeEstimate* SizeEstimate)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 
 	constexpr bool bLoading = false;
-	FPersistentStateStringTrackerProxy<bLoading> StringProxy{Ar};
+	FPersistentStateObjectTracker ObjectTracker{};
+	FPersistentStateStateArchive<bLoading, ESerializeObjectDependency::All> StateArchive{Ar, ObjectTracker};
+	// collect schemas referenced by property bunches stored in the state
+	FPersistentStateSchemaReferenceScope SchemaReferences{};
 	{
-		FPersistentStateObjectTracker ObjectTracker{};
-		FPersistentStateObjectTrackerProxy<bLoading, ESerializeObjectDependency::All> ObjectProxy{StringProxy, ObjectTracker};
-
-		TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateSaveFormatter(ObjectProxy);
-		FStructuredArchive StructuredArchive{*Formatter};
-		FStructuredArchive::FRecord RootRecord = StructuredArchive.Open().EnterRecord();
+		FPersistentStateRecord RootRecord{StateArchive};
 	
 		for (UPersistentStateManager* StateManager : Managers)
 		{
@@ -402,47 +435,241 @@ void SaveManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Ma
 			FPersistentStateDataChunkHeader ChunkHeader{StateManager->GetClass(), 0};
 			UE_LOG(LogPersistentState, Verbose, TEXT("%s: serialized state manager %s"), *FString(__FUNCTION__), *ChunkHeader.ChunkType.ToString());
 		
-			const int32 ChunkHeaderPosition = ObjectProxy.Tell();
-			RootRecord << SA_VALUE(TEXT("ChunkHeader"), ChunkHeader);
+			const int32 ChunkHeaderPosition = StateArchive.Tell();
+			RootRecord.Serialize(TEXT("ChunkHeader"), ChunkHeader);
 
-			const int32 ChunkStartPosition = ObjectProxy.Tell();
-			StateManager->Serialize(RootRecord);
-			const int32 ChunkEndPosition = ObjectProxy.Tell();
+			const int32 ChunkStartPosition = StateArchive.Tell();
+			RootRecord.SerializeObject(*StateManager);
+			const int32 ChunkEndPosition = StateArchive.Tell();
 	
-			ObjectProxy.Seek(ChunkHeaderPosition);
+			StateArchive.Seek(ChunkHeaderPosition);
 
 			// override chunk header data with new chunk size data
 			ChunkHeader.ChunkSize = ChunkEndPosition - ChunkStartPosition;
+			if (SizeEstimate != nullptr)
+			{
+				SizeEstimate->AddManagerSample(StateManager, ChunkHeader.ChunkSize);
+			}
 			// set archive to a chunk header position
-			ObjectProxy.Seek(ChunkHeaderPosition);
-			RootRecord << SA_VALUE(TEXT("ChunkHeader"), ChunkHeader);
+			StateArchive.Seek(ChunkHeaderPosition);
+			RootRecord.Serialize(TEXT("ChunkHeader"), ChunkHeader);
 			// set archive to point at the end position
-			ObjectProxy.Seek(ChunkEndPosition);
+			StateArchive.Seek(ChunkEndPosition);
 		}
-
-		OutObjectTablePosition = StringProxy.Tell();
-		ObjectProxy.WriteToArchive(StringProxy);
 	}
 
-	OutStringTablePosition = StringProxy.Tell();
-	StringProxy.WriteToArchive(Ar);
+	StateArchive.WriteTables(OutObjectTablePosition, OutStringTablePosition);
+
+	OutSchemaTablePosition = Ar.Tell();
+	FPersistentStateSchemaRegistry::Get().WriteSchemaTable(Ar, SchemaReferences.Schemas);
 }
 } // Private
 
+namespace Private
+{
+	/** @return bunch format used to save object properties */
+	FORCEINLINE EPersistentStateBunchFormat GetBunchFormat(const UObject& Object, bool bIsSaveGame)
+	{
+		// schema serialization is used only for SaveGame properties, as other property bunches are not stored with state data
+		// debug formatters always use tagged serialization to output human-readable data
+		// classes with a colliding schema hash fall back to tagged serialization
+		const bool bSchema = bIsSaveGame && GPersistentState_SchemaSerialization && FPersistentStateFormatter::IsReleaseFormatter()
+			&& FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Object.GetClass()).IsValid();
+		return bSchema ? EPersistentStateBunchFormat::Schema : EPersistentStateBunchFormat::Tagged;
+	}
+
+	/**
+	 * Per-thread SaveGame bunch writer. Keeps scratch buffer, memory writer and SaveGame archive alive between objects,
+	 * so that object properties are written to already allocated memory and copied to the bunch once
+	 */
+	struct FScratchBunchWriter
+	{
+		FScratchBunchWriter()
+			: Writer(Buffer, true)
+			, Archive(Writer)
+		{
+			Writer.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
+			Archive.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
+		}
+		UE_NONCOPYABLE(FScratchBunchWriter);
+
+		/** scratch buffer capacity retained between objects, buffer grown by a large object is freed above it */
+		static constexpr int32 MaxRetainedSize = 64 * 1024;
+
+		TArray<uint8> Buffer;
+		FPersistentStateMemoryWriter Writer;
+		FPersistentStateSaveGameArchive Archive;
+		bool bInUse = false;
+	};
+
+	/** Scope that provides SaveGame archive backed by a per-thread scratch writer */
+	class FScratchBunchWriterScope
+	{
+	public:
+		FScratchBunchWriterScope(UObject& Object, bool bIsSaveGame)
+		{
+			static thread_local FScratchBunchWriter ThreadWriter;
+			ScratchWriter = &ThreadWriter;
+			if (ScratchWriter->bInUse)
+			{
+				// object is saved from another object serialization, use a temporary writer
+				ScratchWriter = &LocalWriter.Emplace();
+			}
+			
+			ScratchWriter->bInUse = true;
+			ScratchWriter->Buffer.Reset();
+			ScratchWriter->Writer.Seek(0);
+			// failed serialization of a previous object shouldn't affect this one
+			ScratchWriter->Writer.ClearError();
+			ScratchWriter->Archive.ClearError();
+			ScratchWriter->Writer.ArIsSaveGame = bIsSaveGame;
+			ScratchWriter->Archive.ArIsSaveGame = bIsSaveGame;
+			ScratchWriter->Archive.OwningObject = &Object;
+		}
+
+		~FScratchBunchWriterScope()
+		{
+			ScratchWriter->Archive.OwningObject = nullptr;
+			ScratchWriter->bInUse = false;
+			if (ScratchWriter->Buffer.Max() > FScratchBunchWriter::MaxRetainedSize)
+			{
+				// don't pin memory of a large object on every thread that saved it
+				ScratchWriter->Buffer.Empty();
+			}
+		}
+
+		FORCEINLINE FPersistentStateSaveGameArchive& GetArchive() const { return ScratchWriter->Archive; }
+
+		/** copy written data to @Bunch, bunch memory from the previous save is reused if it is large enough */
+		void CopyTo(FPersistentStatePropertyBunch& Bunch) const
+		{
+			Bunch.Value.Reset();
+			Bunch.Value.Append(ScratchWriter->Buffer);
+		}
+		
+	private:
+		FScratchBunchWriter* ScratchWriter = nullptr;
+		TOptional<FScratchBunchWriter> LocalWriter;
+	};
+	
+	void LoadObjectProperties(FArchive& Ar, UObject& Object)
+	{
+		uint8 Value = 0;
+		Ar << Value;
+		const EPersistentStateBunchFormat Format = static_cast<EPersistentStateBunchFormat>(Value);
+
+		if (EnumHasAnyFlags(Format, EPersistentStateBunchFormat::FastState))
+		{
+			uint32 FastStateSize = 0;
+			Ar << FastStateSize;
+			const int64 EndPosition = Ar.Tell() + FastStateSize;
+
+			// fast state is skipped if class no longer provides a fast serializer, SaveGame properties are still loaded
+			if (FPersistentStateFastSerializeFunc FastSerializer = FPersistentStateFastSerializerRegistry::Find(Object.GetClass()))
+			{
+				FastSerializer(Object, Ar);
+				ensureAlwaysMsgf(Ar.Tell() == EndPosition, TEXT("%s: fast serializer for object %s serialized unexpected number of bytes."),
+					*FString(__FUNCTION__), *Object.GetName());
+			}
+			else
+			{
+				UE_LOG(LogPersistentState, Warning, TEXT("%s: object %s is saved with fast serializer, but its class doesn't provide one. Fast state is skipped."),
+					*FString(__FUNCTION__), *Object.GetName());
+			}
+
+			Ar.Seek(EndPosition);
+		}
+		
+		if ((Format & ~EPersistentStateBunchFormat::FastState) == EPersistentStateBunchFormat::Schema)
+		{
+			LoadObjectSchema(Ar, Object);
+			return;
+		}
+		
+		FPersistentStateRecord Record{Ar};
+		Record.SerializeObject(Object);
+	}
+
+	/**
+	 * save object properties to archive. If @Baseline is provided, schema properties are delta serialized against the baseline bunch
+	 * @return false if object properties match baseline and nothing has to be stored
+	 */
+	bool SaveObjectProperties(FArchive& Ar, UObject& Object, bool bIsSaveGame, const FPersistentStatePropertyBunch* Baseline = nullptr)
+	{
+		EPersistentStateBunchFormat Format = GetBunchFormat(Object, bIsSaveGame);
+		
+		FPersistentStateFastSerializeFunc FastSerializer = bIsSaveGame ? FPersistentStateFastSerializerRegistry::Find(Object.GetClass()) : nullptr;
+		if (FastSerializer != nullptr)
+		{
+			Format |= EPersistentStateBunchFormat::FastState;
+		}
+
+		uint8 Value = static_cast<uint8>(Format);
+		Ar << Value;
+
+		if (FastSerializer != nullptr)
+		{
+			// fast state size is stored to skip fast state if class no longer provides a fast serializer
+			const int64 SizePosition = Ar.Tell();
+			uint32 FastStateSize = 0;
+			Ar << FastStateSize;
+
+			FastSerializer(Object, Ar);
+
+			const int64 EndPosition = Ar.Tell();
+			FastStateSize = static_cast<uint32>(EndPosition - SizePosition - sizeof(uint32));
+
+			Ar.Seek(SizePosition);
+			Ar << FastStateSize;
+			Ar.Seek(EndPosition);
+		}
+
+		if ((Format & ~EPersistentStateBunchFormat::FastState) == EPersistentStateBunchFormat::Schema)
+		{
+			// fast state is opaque and is always stored, so delta against baseline is used only for pure schema bunches
+			if (Baseline != nullptr && !Baseline->IsEmpty() && FastSerializer == nullptr)
+			{
+				FPersistentStateMemoryReader BaselineReader{Baseline->Value, true};
+				BaselineReader.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
+				BaselineReader.ArIsSaveGame = bIsSaveGame;
+				FPersistentStateSaveGameArchive BaselineArchive{BaselineReader, Object};
+				
+				uint8 BaselineFormat = 0;
+				BaselineArchive << BaselineFormat;
+				if (static_cast<EPersistentStateBunchFormat>(BaselineFormat) == EPersistentStateBunchFormat::Schema)
+				{
+					return SaveObjectSchema(Ar, Object, &BaselineArchive);
+				}
+			}
+			
+			SaveObjectSchema(Ar, Object);
+			return true;
+		}
+		
+		// tagged properties, record writes them directly to the archive in release builds and through a formatter in editor builds
+		FPersistentStateRecord Record{Ar};
+		Record.SerializeObject(Object);
+		
+		return true;
+	}
+}
+
 void LoadObject(UObject& Object, const FPersistentStatePropertyBunch& PropertyBunch, bool bIsSaveGame)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	FScopeCycleCounterUObject Scope{&Object};
+
+	if (PropertyBunch.IsEmpty())
+	{
+		return;
+	}
 	
 	FPersistentStateMemoryReader Reader{PropertyBunch.Value, true};
 	Reader.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
 	Reader.ArIsSaveGame = bIsSaveGame;
 	
 	FPersistentStateSaveGameArchive Archive{Reader, Object};
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateLoadFormatter(Archive);
-	FStructuredArchive StructuredArchive{*Formatter};
-
-	Object.Serialize(StructuredArchive.Open().EnterRecord());
+	Private::LoadObjectProperties(Archive, Object);
 }
 
 void SaveObject(UObject& Object, FPersistentStatePropertyBunch& PropertyBunch, bool bIsSaveGame)
@@ -450,23 +677,27 @@ void SaveObject(UObject& Object, FPersistentStatePropertyBunch& PropertyBunch, b
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	FScopeCycleCounterUObject Scope{&Object};
 	
-	FPersistentStateMemoryWriter Writer{PropertyBunch.Value, true};
-	Writer.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-	Writer.ArIsSaveGame = bIsSaveGame;
-	
-	FPersistentStateSaveGameArchive Archive{Writer, Object};
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateSaveFormatter(Archive);
-	FStructuredArchive StructuredArchive{*Formatter};
-
-	Object.Serialize(StructuredArchive.Open().EnterRecord());
+	Private::FScratchBunchWriterScope WriterScope{Object, bIsSaveGame};
+	Private::SaveObjectProperties(WriterScope.GetArchive(), Object, bIsSaveGame);
+	WriterScope.CopyTo(PropertyBunch);
 }
 
 void LoadObject(UObject& Object, const FPersistentStatePropertyBunch& PropertyBunch, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame)
+{
+	LoadObject(Object, PropertyBunch.Value, DependencyTracker, bIsSaveGame);
+}
+
+void LoadObject(UObject& Object, TConstArrayView<uint8> PropertyData, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	FScopeCycleCounterUObject Scope{&Object};
+
+	if (PropertyData.IsEmpty())
+	{
+		return;
+	}
 	
-	FPersistentStateMemoryReader Reader{PropertyBunch.Value, true};
+	FPersistentStateMemoryReader Reader{PropertyData, true};
 	Reader.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
 	Reader.ArIsSaveGame = bIsSaveGame;
 	
@@ -474,10 +705,8 @@ void LoadObject(UObject& Object, const FPersistentStatePropertyBunch& PropertyBu
 	
 	constexpr bool bLoading = true;
 	FPersistentStateObjectTrackerProxy<bLoading, ESerializeObjectDependency::Hard> ObjectProxy{Archive, DependencyTracker};
-	
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateLoadFormatter(Archive);
-	FStructuredArchive StructuredArchive{*Formatter};
-	Object.Serialize(StructuredArchive.Open().EnterRecord());
+
+	Private::LoadObjectProperties(Archive, Object);
 }
 
 void SaveObject(UObject& Object, FPersistentStatePropertyBunch& SaveGameBunch, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame)
@@ -485,18 +714,37 @@ void SaveObject(UObject& Object, FPersistentStatePropertyBunch& SaveGameBunch, F
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	FScopeCycleCounterUObject Scope{&Object};
 	
-	FPersistentStateMemoryWriter Writer{SaveGameBunch.Value, true};
-	Writer.SetWantBinaryPropertySerialization(WITH_BINARY_SERIALIZATION);
-	Writer.ArIsSaveGame = bIsSaveGame;
+	Private::FScratchBunchWriterScope WriterScope{Object, bIsSaveGame};
+	FPersistentStateSaveGameArchive& Archive = WriterScope.GetArchive();
 	
-	FPersistentStateSaveGameArchive Archive{Writer, Object};
+	constexpr bool bLoading = false;
+	FPersistentStateObjectTrackerProxy<bLoading, ESerializeObjectDependency::Hard> ObjectProxy{Archive, DependencyTracker};
+
+	Private::SaveObjectProperties(Archive, Object, bIsSaveGame);
+	WriterScope.CopyTo(SaveGameBunch);
+}
+
+void SaveObject(UObject& Object, FPersistentStatePropertyBunch& SaveGameBunch, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStatePropertyBunch& BaselineBunch)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	FScopeCycleCounterUObject Scope{&Object};
+
+	constexpr bool bIsSaveGame = true;
+	Private::FScratchBunchWriterScope WriterScope{Object, bIsSaveGame};
+	FPersistentStateSaveGameArchive& Archive = WriterScope.GetArchive();
 	
 	constexpr bool bLoading = false;
 	FPersistentStateObjectTrackerProxy<bLoading, ESerializeObjectDependency::Hard> ObjectProxy{Archive, DependencyTracker};
 
-	TUniquePtr<FArchiveFormatterType> Formatter = FPersistentStateFormatter::CreateSaveFormatter(Archive);
-	FStructuredArchive StructuredArchive{*Formatter};
-	Object.Serialize(StructuredArchive.Open().EnterRecord());
+	if (Private::SaveObjectProperties(Archive, Object, bIsSaveGame, &BaselineBunch))
+	{
+		WriterScope.CopyTo(SaveGameBunch);
+	}
+	else
+	{
+		// object matches baseline, empty bunch is never loaded
+		SaveGameBunch.Value.Reset();
+	}
 }
 	
 }
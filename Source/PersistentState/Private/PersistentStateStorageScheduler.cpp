@@ -0,0 +1,130 @@
+#include "PersistentStateStorageScheduler.h"
+
+#include "PersistentStateCVars.h"
+#include "PersistentStateModule.h"
+
+FPersistentStateStorageScheduler FPersistentStateStorageScheduler::Instance;
+
+void FPersistentStateStorageScheduler::Initialize()
+{
+	FScopeLock Lock{&InteractiveCriticalSection};
+	check(InteractiveIdleEvent == nullptr);
+	
+	InteractiveIdleEvent = FPlatformProcess::GetSynchEventFromPool(true);
+	if (NumActiveInteractiveTasks.load(std::memory_order_relaxed) == 0)
+	{
+		InteractiveIdleEvent->Trigger();
+	}
+}
+
+void FPersistentStateStorageScheduler::Shutdown()
+{
+	FScopeLock Lock{&InteractiveCriticalSection};
+	if (InteractiveIdleEvent != nullptr)
+	{
+		// release background tasks that still wait for interactive tasks
+		InteractiveIdleEvent->Trigger();
+		FPlatformProcess::ReturnSynchEventToPool(InteractiveIdleEvent);
+		InteractiveIdleEvent = nullptr;
+	}
+}
+
+FGraphEventRef FPersistentStateStorageScheduler::Dispatch(EPersistentStateTaskPriority Priority, TUniqueFunction<void(const FGraphEventRef&)>&& Task, const FGraphEventArray& Prerequisites)
+{
+	const bool bInteractive = !IsBackground(Priority);
+	
+	FGraphEventRef Event = FFunctionGraphTask::CreateAndDispatchWhenReady([this, bInteractive, Task=MoveTemp(Task)](ENamedThreads::Type CurrentThread, const FGraphEventRef& CompletionEvent)
+	{
+		// interactive task is counted only after its prerequisites are completed, so that background tasks never yield
+		// to a task that is waiting for them
+		if (bInteractive)
+		{
+			BeginInteractiveTask();
+		}
+		
+		Task(CompletionEvent);
+	}, TStatId{}, &Prerequisites, GetThreadType(Priority));
+
+	if (bInteractive)
+	{
+		// interactive task may extend its completion event, wait for it before releasing background tasks
+		FFunctionGraphTask::CreateAndDispatchWhenReady([this]
+		{
+			EndInteractiveTask();
+		}, TStatId{}, Event, ENamedThreads::AnyHiPriThreadHiPriTask);
+	}
+
+	return Event;
+}
+
+void FPersistentStateStorageScheduler::YieldBackgroundTask(int64 NumBytes)
+{
+	if (GetNumActiveInteractiveTasks() > 0 && InteractiveIdleEvent != nullptr)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateStorageScheduler_Yield, PersistentStateChannel);
+		InteractiveIdleEvent->Wait();
+	}
+
+	const int64 Bandwidth = static_cast<int64>(UE::PersistentState::GPersistentState_BackgroundBandwidth) * 1024;
+	if (Bandwidth <= 0)
+	{
+		return;
+	}
+
+	double SleepTime = 0.0;
+	{
+		FScopeLock Lock{&ThrottleCriticalSection};
+		
+		const double CurrentTime = FPlatformTime::Seconds();
+		if (CurrentTime - ThrottleWindowStart > 1.0)
+		{
+			// start a new throttle window
+			ThrottleWindowStart = CurrentTime;
+			ThrottleWindowBytes = 0;
+		}
+
+		ThrottleWindowBytes += NumBytes;
+		SleepTime = static_cast<double>(ThrottleWindowBytes) / Bandwidth - (CurrentTime - ThrottleWindowStart);
+	}
+
+	if (SleepTime > 0.0)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FPersistentStateStorageScheduler_Throttle, PersistentStateChannel);
+		FPlatformProcess::SleepNoStats(static_cast<float>(SleepTime));
+	}
+}
+
+void FPersistentStateStorageScheduler::BeginInteractiveTask()
+{
+	FScopeLock Lock{&InteractiveCriticalSection};
+	if (NumActiveInteractiveTasks.fetch_add(1, std::memory_order_relaxed) == 0 && InteractiveIdleEvent != nullptr)
+	{
+		InteractiveIdleEvent->Reset();
+	}
+}
+
+void FPersistentStateStorageScheduler::EndInteractiveTask()
+{
+	FScopeLock Lock{&InteractiveCriticalSection};
+	if (NumActiveInteractiveTasks.fetch_sub(1, std::memory_order_relaxed) == 1 && InteractiveIdleEvent != nullptr)
+	{
+		InteractiveIdleEvent->Trigger();
+	}
+}
+
+ENamedThreads::Type FPersistentStateStorageScheduler::GetThreadType(EPersistentStateTaskPriority Priority)
+{
+	switch (Priority)
+	{
+	case EPersistentStateTaskPriority::InteractiveLoad:
+		return ENamedThreads::AnyHiPriThreadHiPriTask;
+	case EPersistentStateTaskPriority::InteractiveSave:
+		return ENamedThreads::AnyHiPriThreadNormalTask;
+	case EPersistentStateTaskPriority::BackgroundSave:
+		return ENamedThreads::AnyBackgroundHiPriTask;
+	case EPersistentStateTaskPriority::BackgroundLoad:
+	case EPersistentStateTaskPriority::SlotScan:
+	default:
+		return ENamedThreads::AnyBackgroundThreadNormalTask;
+	}
+}
@@ -5,6 +5,7 @@
 #include "PersistentStateInterface.h"
 #include "PersistentStateModule.h"
 #include "PersistentStateObjectId.h"
+#include "PersistentStateSchema.h"
 #include "PersistentStateSettings.h"
 #include "PersistentStateSlotDescriptor.h"
 #include "PersistentStateStatics.h"
@@ -15,6 +16,8 @@ DECLARE_MEMORY_STAT(TEXT("World State Memory"),		STAT_PersistentState_WorldState
 DECLARE_MEMORY_STAT(TEXT("Game State Memory"),		STAT_PersistentState_GameStateMemory,		STATGROUP_PersistentState);
 DECLARE_MEMORY_STAT(TEXT("Profile State Memory"),	STAT_PersistentState_ProfileStateMemory,	STATGROUP_PersistentState);
 DECLARE_MEMORY_STAT(TEXT("State Storage Memory"),	STAT_PersistentState_StateStorageMemory,	STATGROUP_PersistentState);
+DECLARE_MEMORY_STAT(TEXT("Schema Registry Memory"),	STAT_PersistentState_SchemaRegistryMemory,	STATGROUP_PersistentState);
+DECLARE_MEMORY_STAT(TEXT("Buffer Pool Memory"),		STAT_PersistentState_BufferPoolMemory,		STATGROUP_PersistentState);
 
 UPersistentStateSubsystem::UPersistentStateSubsystem()
 {
@@ -117,6 +120,7 @@ void UPersistentStateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &ThisClass::OnWorldInitActors);
 	FWorldDelegates::OnWorldCleanup.AddUObject(this, &ThisClass::OnWorldCleanup);
 	FWorldDelegates::OnSeamlessTravelTransition.AddUObject(this, &ThisClass::OnWorldSeamlessTravel);
+	FWorldDelegates::OnSeamlessTravelStart.AddUObject(this, &ThisClass::OnSeamlessTravelStart);
 
 #if WITH_EDITOR
 	FEditorDelegates::PrePIEEnded.AddUObject(this, &ThisClass::OnEndPlay);
@@ -275,11 +279,15 @@ void UPersistentStateSubsystem::Deinitialize()
 	FWorldDelegates::OnWorldInitializedActors.RemoveAll(this);
 	FWorldDelegates::OnWorldCleanup.RemoveAll(this);
 	FWorldDelegates::OnSeamlessTravelTransition.RemoveAll(this);
+	FWorldDelegates::OnSeamlessTravelStart.RemoveAll(this);
 	
 	StateStorage->Shutdown();
 	StateStorage->MarkAsGarbage();
 	StateStorage = nullptr;
 
+	StateSizeEstimate.Reset();
+	FPersistentStateBufferPool::Get().Reset();
+
 	check(bInitialized);
 	bInitialized = false;
 	
@@ -329,6 +337,10 @@ void UPersistentStateSubsystem::Tick(float DeltaTime)
 		// request open level
 		UGameplayStatics::OpenLevel(this, ActiveLoadRequest->MapName, true, ActiveLoadRequest->TravelOptions);
 	}
+	else if (UE::PersistentState::GPersistentState_AutoPrefetch)
+	{
+		PrefetchPendingTravel();
+	}
 
 	UpdateStats();
 }
@@ -345,9 +357,9 @@ void UPersistentStateSubsystem::ProcessSaveRequests()
 		const UWorld* World = GetWorld();
 		check(World);
 
-		FGameStateSharedRef	GameState = UE::PersistentState::CreateGameState(GetManagerCollectionByType(EManagerStorageType::Game));
+		FGameStateSharedRef	GameState = UE::PersistentState::CreateGameState(GetManagerCollectionByType(EManagerStorageType::Game), &StateSizeEstimate);
 		const FString WorldPackage = FPersistentStateObjectPathGenerator::Get().GetStableWorldPackage(World);
-		FWorldStateSharedRef WorldState = UE::PersistentState::CreateWorldState(World->GetName(), WorldPackage, GetManagerCollectionByType(EManagerStorageType::World));
+		FWorldStateSharedRef WorldState = UE::PersistentState::CreateWorldState(World->GetName(), WorldPackage, GetManagerCollectionByType(EManagerStorageType::World), &StateSizeEstimate);
 		
 		// create a local copy of save game requests
 		// any new requests are processed on the next update
@@ -360,7 +372,8 @@ void UPersistentStateSubsystem::ProcessSaveRequests()
 			OnSaveStateStarted.Broadcast(TargetSlot);
 	
 			const FPersistentStateSlotHandle& SourceSlot = LastActiveSlot.IsValid() ? LastActiveSlot : TargetSlot;
-			StateStorage->SaveState(GameState, WorldState, SourceSlot, TargetSlot, FSaveCompletedDelegate::CreateUObject(this, &ThisClass::OnSaveStateCompleted, TargetSlot));
+			const EPersistentStateTaskPriority Priority = Request->bBackgroundSave ? EPersistentStateTaskPriority::BackgroundSave : EPersistentStateTaskPriority::InteractiveSave;
+			StateStorage->SaveState(GameState, WorldState, SourceSlot, TargetSlot, FSaveCompletedDelegate::CreateUObject(this, &ThisClass::OnSaveStateCompleted, TargetSlot), Priority);
 		}
 		
 		ActiveSlot = PendingRequests.Last()->TargetSlot;
@@ -402,6 +415,8 @@ void UPersistentStateSubsystem::UpdateStats() const
 	SET_MEMORY_STAT(STAT_PersistentState_GameStateMemory, GameMemory);
 	SET_MEMORY_STAT(STAT_PersistentState_ProfileStateMemory, ProfileMemory);
 	SET_MEMORY_STAT(STAT_PersistentState_StateStorageMemory, StateStorage->GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_PersistentState_SchemaRegistryMemory, FPersistentStateSchemaRegistry::Get().GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_PersistentState_BufferPoolMemory, FPersistentStateBufferPool::Get().GetAllocatedSize());
 #endif
 }
 
@@ -539,7 +554,7 @@ UPersistentStateManager* UPersistentStateSubsystem::GetStateManager(TSubclassOf<
 	return OutManager;
 }
 
-bool UPersistentStateSubsystem::SaveGame()
+bool UPersistentStateSubsystem::SaveGame(bool bBackgroundSave)
 {
 	if (!ActiveSlot.IsValid())
 	{
@@ -547,10 +562,10 @@ bool UPersistentStateSubsystem::SaveGame()
 		return false;
 	}
 
-	return SaveGameToSlot(ActiveSlot);
+	return SaveGameToSlot(ActiveSlot, bBackgroundSave);
 }
 
-bool UPersistentStateSubsystem::SaveGameToSlot(const FPersistentStateSlotHandle& TargetSlot)
+bool UPersistentStateSubsystem::SaveGameToSlot(const FPersistentStateSlotHandle& TargetSlot, bool bBackgroundSave)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
 	check(StateStorage);
@@ -590,12 +605,13 @@ bool UPersistentStateSubsystem::SaveGameToSlot(const FPersistentStateSlotHandle&
 	{
 		if (TargetSlot == Request->TargetSlot)
 		{
-			// save to a target slot already requested
+			// save to a target slot already requested, interactive save request takes priority
+			Request->bBackgroundSave &= bBackgroundSave;
 			return true;
 		}
 	}
 	
-	SaveGameRequests.Add(MakeShared<FSaveGamePendingRequest>(TargetSlot));
+	SaveGameRequests.Add(MakeShared<FSaveGamePendingRequest>(TargetSlot, bBackgroundSave));
 	return true;
 }
 
@@ -655,6 +671,47 @@ bool UPersistentStateSubsystem::LoadGameWorldFromSlot(const FPersistentStateSlot
 	return true;
 }
 
+bool UPersistentStateSubsystem::PrefetchWorldState(TSoftObjectPtr<UWorld> World)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(__FUNCTION__, PersistentStateChannel);
+	check(StateStorage);
+	
+	return RequestWorldPrefetch(FName{World.GetAssetName()});
+}
+
+bool UPersistentStateSubsystem::RequestWorldPrefetch(FName WorldName)
+{
+	if (!ActiveSlot.IsValid() || WorldName == NAME_None)
+	{
+		return false;
+	}
+
+	if (const UWorld* World = GetOuterUGameInstance()->GetWorld(); World && World->GetFName() == WorldName)
+	{
+		// current world state is owned by world managers and is saved before travel
+		return false;
+	}
+
+	FGraphEventRef Event = StateStorage->PrefetchState(ActiveSlot, WorldName);
+	UE_CLOG(Event.IsValid(), LogPersistentState, Verbose, TEXT("%s: prefetching world state %s from slot %s"), *FString(__FUNCTION__), *WorldName.ToString(), *ActiveSlot.ToString());
+	
+	return Event.IsValid();
+}
+
+void UPersistentStateSubsystem::PrefetchPendingTravel()
+{
+	const FWorldContext* WorldContext = GetGameInstance()->GetWorldContext();
+	if (WorldContext == nullptr || WorldContext->TravelURL.IsEmpty() || WorldContext->TravelURL == PrefetchTravelURL)
+	{
+		return;
+	}
+
+	// travel URL is processed by the engine on the next frame, start reading the world state in the meantime
+	PrefetchTravelURL = WorldContext->TravelURL;
+	const FURL TravelURL{nullptr, *WorldContext->TravelURL, TRAVEL_Absolute};
+	RequestWorldPrefetch(FPackageName::GetShortFName(TravelURL.Map));
+}
+
 bool UPersistentStateSubsystem::LoadScreenshotFromSlot(const FPersistentStateSlotHandle& TargetSlot, FLoadScreenshotCompletedDelegate CompletedDelegate)
 {
 	check(StateStorage);
@@ -715,6 +772,12 @@ FPersistentStateSlotHandle UPersistentStateSubsystem::CreateSaveGameSlot(FName S
 	return StateStorage->CreateStateSlot(SlotName, SlotTitle, DescriptorClass);
 }
 
+FPersistentStateSlotHandle UPersistentStateSubsystem::DuplicateSaveGameSlot(const FPersistentStateSlotHandle& Slot, FName SlotName)
+{
+	check(StateStorage);
+	return StateStorage->DuplicateStateSlot(Slot, SlotName);
+}
+
 void UPersistentStateSubsystem::NotifyObjectInitialized(UObject& Object)
 {
 	check(Object.Implements<UPersistentStateObject>());
@@ -781,6 +844,15 @@ void UPersistentStateSubsystem::OnWorldSeamlessTravel(UWorld* World)
 	}
 }
 
+void UPersistentStateSubsystem::OnSeamlessTravelStart(UWorld* World, const FString& LevelName)
+{
+	if (World == GetOuterUGameInstance()->GetWorld() && UE::PersistentState::GPersistentState_AutoPrefetch)
+	{
+		// seamless travel loads the destination map in background, prefetch its world state alongside
+		RequestWorldPrefetch(FPackageName::GetShortFName(LevelName));
+	}
+}
+
 #if WITH_EDITOR
 void UPersistentStateSubsystem::OnEndPlay(const bool bSimulating)
 {
@@ -0,0 +1,70 @@
+#include "PersistentStateTraits.h"
+
+#include "UObject/ObjectKey.h"
+
+namespace UE::PersistentState::Private
+{
+	struct FFastSerializerRegistryData
+	{
+		/** registered fast serializers, static class is resolved lazily */
+		TArray<TPair<FPersistentStateFastSerializerRegistry::FStaticClassFunc, FPersistentStateFastSerializeFunc>> PendingSerializers;
+		/** map native class to a fast serializer */
+		TMap<const UClass*, FPersistentStateFastSerializeFunc> Serializers;
+		/** map any queried class to a fast serializer of its closest registered super class, nullptr is cached as well */
+		TMap<TObjectKey<UClass>, FPersistentStateFastSerializeFunc> ClassSerializers;
+	};
+
+	FFastSerializerRegistryData& GetFastSerializerRegistryData()
+	{
+		// function static to avoid static initialization order issues with registration objects
+		static FFastSerializerRegistryData Data;
+		return Data;
+	}
+}
+
+void FPersistentStateFastSerializerRegistry::Register(FStaticClassFunc StaticClass, FPersistentStateFastSerializeFunc SerializeFunc)
+{
+	check(StaticClass && SerializeFunc);
+	UE::PersistentState::Private::GetFastSerializerRegistryData().PendingSerializers.Emplace(StaticClass, SerializeFunc);
+}
+
+FPersistentStateFastSerializeFunc FPersistentStateFastSerializerRegistry::Find(const UClass* Class)
+{
+	check(Class && IsInGameThread());
+
+	auto& Data = UE::PersistentState::Private::GetFastSerializerRegistryData();
+	if (!Data.PendingSerializers.IsEmpty())
+	{
+		for (auto& [StaticClass, SerializeFunc]: Data.PendingSerializers)
+		{
+			Data.Serializers.Add(StaticClass(), SerializeFunc);
+		}
+		Data.PendingSerializers.Reset();
+		// new serializers can be used by already queried classes
+		Data.ClassSerializers.Reset();
+	}
+
+	if (Data.Serializers.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	if (const FPersistentStateFastSerializeFunc* CachedFunc = Data.ClassSerializers.Find(Class))
+	{
+		return *CachedFunc;
+	}
+
+	// walk super classes, so that blueprint classes derived from a native class with fast serializer still use it
+	FPersistentStateFastSerializeFunc Result = nullptr;
+	for (const UClass* SuperClass = Class; SuperClass != nullptr; SuperClass = SuperClass->GetSuperClass())
+	{
+		if (FPersistentStateFastSerializeFunc* SerializeFunc = Data.Serializers.Find(SuperClass))
+		{
+			Result = *SerializeFunc;
+			break;
+		}
+	}
+
+	Data.ClassSerializers.Add(Class, Result);
+	return Result;
+}
@@ -61,6 +61,9 @@ public:
 #if WITH_STRUCTURED_SERIALIZATION
 	bool Serialize(FStructuredArchive::FSlot Slot);
 #endif
+	/** reports bunch schema to the active schema reference scope when saving */
+	void PostSerialize(const FArchive& Ar);
+	
 	FORCEINLINE bool IsEmpty() const { return Value.IsEmpty(); }
 	FORCEINLINE typename TArray<uint8>::SizeType Num() const { return Value.Num(); }
 	FORCEINLINE SIZE_T GetAllocatedSize() const { return Value.GetAllocatedSize(); }
@@ -73,16 +76,15 @@ public:
 	TArray<uint8> Value;
 };
 
-#if WITH_STRUCTURED_SERIALIZATION
 template <>
 struct TStructOpsTypeTraits<FPersistentStatePropertyBunch> : public TStructOpsTypeTraitsBase2<FPersistentStatePropertyBunch>
 {
 	enum
 	{
-		WithStructuredSerializer = true,
+		WithStructuredSerializer = WITH_STRUCTURED_SERIALIZATION,
+		WithPostSerialize = true,
 	};
 };
-#endif
 
 /**
  * Base class for State Manager classes - objects that encapsulate both state and logic for a specific game feature
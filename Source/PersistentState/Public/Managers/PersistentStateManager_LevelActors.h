@@ -13,30 +13,89 @@ struct FActorPersistentState;
 struct FComponentPersistentState;
 struct FPersistentStateDescFlags;
 struct FPersistentStateObjectDesc;
+struct FLevelDependencyTable;
+struct FPersistentStateDefaultObjectDesc;
+struct FPersistentStateSharedDefaultState;
 class UPersistentStateManager_LevelActors;
 
+/** range of bytes allocated in a level state arena */
+USTRUCT()
+struct FPersistentStateArenaRange
+{
+	GENERATED_BODY()
+
+	FORCEINLINE bool IsEmpty() const { return Num == 0; }
+
+	friend FArchive& operator<<(FArchive& Ar, FPersistentStateArenaRange& Value)
+	{
+		Ar << Value.Offset;
+		Ar << Value.Num;
+		return Ar;
+	}
+
+	UPROPERTY()
+	int32 Offset = 0;
+
+	UPROPERTY()
+	int32 Num = 0;
+};
+
+/**
+ * Level state arena
+ * Bump allocator that stores SaveGame bunches of all objects in the level state in a single byte array, objects reference their data by range.
+ * Re-saved object allocates a new range, previous data is released as a whole when arena is compacted after the level is saved.
+ */
+USTRUCT()
+struct FPersistentStateLevelArena
+{
+	GENERATED_BODY()
+
+	/** allocate a new range and copy @Bytes to it */
+	FPersistentStateArenaRange Add(TConstArrayView<uint8> Bytes);
+	/** allocate a new uninitialized range */
+	FPersistentStateArenaRange AddUninitialized(int32 Num);
+
+	/** @return data referenced by @Range */
+	FORCEINLINE TConstArrayView<uint8> GetView(const FPersistentStateArenaRange& Range) const
+	{
+		checkSlow(Range.Offset >= 0 && Range.Offset + Range.Num <= Data.Num());
+		return TConstArrayView<uint8>{Data.GetData() + Range.Offset, Range.Num};
+	}
+	FORCEINLINE uint8* GetData(const FPersistentStateArenaRange& Range)
+	{
+		checkSlow(Range.Offset >= 0 && Range.Offset + Range.Num <= Data.Num());
+		return Data.GetData() + Range.Offset;
+	}
+
+	FORCEINLINE void Reset() { Data.Reset(); }
+	FORCEINLINE int32 Num() const { return Data.Num(); }
+	FORCEINLINE uint32 GetAllocatedSize() const { return Data.GetAllocatedSize(); }
+	
+	UPROPERTY()
+	TArray<uint8> Data;
+};
+
 struct FLevelLoadContext
 {
-	FLevelLoadContext(FPersistentStateObjectTracker& InTracker, bool bInFromLevelStreaming)
-		: DependencyTracker(InTracker)
-		, bFromLevelStreaming(bInFromLevelStreaming)
-	{}
+	FLevelLoadContext(FLevelDependencyTable& InDependencies, const FPersistentStateLevelArena& InArena, bool bInFromLevelStreaming);
 
 	void AddCreatedActor(const FActorPersistentState& ActorState);
 	void AddCreatedComponent(const FComponentPersistentState& ComponentState);
+	/** @return class resolved via world dependency table */
+	UClass* ResolveClass(const FSoftClassPath& ClassPath);
 	
 	TArray<FPersistentStateObjectId> CreatedActors;
 	TArray<FPersistentStateObjectId> CreatedComponents;
+	FLevelDependencyTable& Dependencies;
 	FPersistentStateObjectTracker& DependencyTracker;
+	/** level arena that stores SaveGame bunches */
+	const FPersistentStateLevelArena& Arena;
 	bool bFromLevelStreaming = false;
 };
 
 struct FLevelSaveContext
 {
-	FLevelSaveContext(FPersistentStateObjectTracker& InTracker, bool bInFromLevelStreaming)
-		: DependencyTracker(InTracker)
-		, bFromLevelStreaming(bInFromLevelStreaming)
-	{}
+	FLevelSaveContext(FLevelDependencyTable& InDependencies, FPersistentStateLevelArena& InArena, bool bInFromLevelStreaming);
 
 	void ProcessActorState(const FActorPersistentState& State);
 	void ProcessComponentState(const FComponentPersistentState& State);
@@ -58,19 +117,51 @@ struct FLevelSaveContext
 	TArray<FPersistentStateObjectId, TInlineAllocator<16>> DestroyedObjects;
 	TArray<FPersistentStateObjectId, TInlineAllocator<16>> OutdatedObjects;
 	FPersistentStateObjectTracker& DependencyTracker;
+	/** level arena that stores SaveGame bunches */
+	FPersistentStateLevelArena& Arena;
 	bool bFromLevelStreaming = false;
 };
 
+/**
+ * Transform encoding flags for compact serialization
+ * Component flags describe transform components stored in the state, missing components match default object state.
+ * Encoding flags describe how stored components are encoded.
+ */
+enum class EPersistentStateTransformFlags: uint16
+{
+	None				= 0,
+	Location			= 1 << 0,
+	Rotation			= 1 << 1,
+	Scale				= 1 << 2,
+	All					= Location | Rotation | Scale,
+	/** location is stored in single precision without precision loss */
+	FloatLocation		= 1 << 3,
+	/** rotation is stored in single precision without precision loss */
+	FloatRotation		= 1 << 4,
+	/** scale is stored in single precision without precision loss */
+	FloatScale			= 1 << 5,
+	/** scale is uniform, stored as a single value */
+	UniformScale		= 1 << 6,
+	/** location is stored as fixed point value, lossy */
+	QuantizedLocation	= 1 << 7,
+	/** rotation is stored as smallest three quaternion, lossy */
+	QuantizedRotation	= 1 << 8,
+};
+ENUM_CLASS_FLAGS(EPersistentStateTransformFlags);
+
 USTRUCT()
 struct FPersistentStateObjectDesc
 {
 	GENERATED_BODY()
 
-	static FPersistentStateObjectDesc Create(AActor& Actor, FPersistentStateObjectTracker& DependencyTracker);
-	static FPersistentStateObjectDesc Create(UActorComponent& Component, FPersistentStateObjectTracker& DependencyTracker);
+	/** create object desc, SaveGame properties are delta serialized against @Default state if it is provided */
+	static FPersistentStateObjectDesc Create(AActor& Actor, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStateDefaultObjectDesc* Default = nullptr);
+	static FPersistentStateObjectDesc Create(UActorComponent& Component, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStateDefaultObjectDesc* Default = nullptr);
 	
 	bool EqualSaveGame(const FPersistentStateObjectDesc& Other) const;
 	uint32 GetAllocatedSize() const;
+	/** move SaveGame bunch to the level @Arena if state stores it, otherwise release it */
+	void MoveSaveGameBunch(FPersistentStateLevelArena& Arena, bool bHasSaveGameBunch);
 
 	UPROPERTY()
 	FTransform Transform;
@@ -90,11 +181,48 @@ struct FPersistentStateObjectDesc
 	UPROPERTY()
 	FName AttachSocketName = NAME_None;
 
+	/** SaveGame bunch stored in the level arena */
 	UPROPERTY()
-	FPersistentStatePropertyBunch SaveGameBunch;
+	FPersistentStateArenaRange SaveGameRange;
 	
 	UPROPERTY()
 	bool bHasTransform = false;
+
+	/** transient SaveGame bunch created for the object, moved to the level arena once object state is saved */
+	FPersistentStatePropertyBunch SaveGameBunch;
+
+	/** @return object transform, transform components that are not stored in the state are taken from @DefaultTransform */
+	FTransform GetTransform(const FTransform& DefaultTransform) const;
+	/** initialize transform components that differ from @Default state */
+	void InitTransformComponents(const FPersistentStateDefaultObjectDesc& Default);
+
+	/** transform components stored in the state, other components match default state. Restored by compact serialization */
+	EPersistentStateTransformFlags TransformComponents = EPersistentStateTransformFlags::All;
+	/** transient, if set transform is quantized with a loss of precision */
+	bool bQuantizeTransform = false;
+};
+
+/**
+ * Default state of a static object, captured before saved object state is loaded and used to calculate state flags
+ * Class and SaveGame bunch are shared between instances with the same archetype and identical default values,
+ * so that only per-instance part of the default state is stored for each object.
+ */
+struct FPersistentStateDefaultObjectDesc
+{
+	/** create default state from object desc, SaveGame bunch is moved to the shared default state */
+	static FPersistentStateDefaultObjectDesc Create(const UObject& Object, FPersistentStateObjectDesc&& Desc);
+
+	const FSoftClassPath& GetClass() const;
+	const FPersistentStatePropertyBunch& GetSaveGameBunch() const;
+
+	FTransform Transform;
+	FPersistentStateObjectId OwnerID;
+	FPersistentStateObjectId AttachParentID;
+	FName Name = NAME_None;
+	FName AttachSocketName = NAME_None;
+	/** default state shared between instances of the same archetype */
+	TSharedPtr<const FPersistentStateSharedDefaultState> SharedState;
+	bool bHasTransform = false;
 };
 
 /**
@@ -117,7 +245,7 @@ struct alignas(1) FPersistentStateDescFlags
 	 * @return object state flags calculate for a static object as a different between @Default state and @Current state.
 	 * Use @SourceFlags to copy flags unrelated to object state
 	 */
-	FPersistentStateDescFlags GetFlagsForStaticObject(FPersistentStateDescFlags SourceFlags, const FPersistentStateObjectDesc& Default, const FPersistentStateObjectDesc& Current) const;
+	FPersistentStateDescFlags GetFlagsForStaticObject(FPersistentStateDescFlags SourceFlags, const FPersistentStateDefaultObjectDesc& Default, const FPersistentStateObjectDesc& Current) const;
 
 	/**
 	 * @return object state flags calculate for a static object as a different between @Default state and @Current state.
@@ -175,7 +303,7 @@ public:
 
 	void LinkComponentHandle(UActorComponent* Component, const FPersistentStateObjectId& InComponentHandle) const;
 	
-	UActorComponent* CreateDynamicComponent(AActor* OwnerActor) const;
+	UActorComponent* CreateDynamicComponent(FLevelLoadContext& Context, AActor* OwnerActor) const;
 
 	void LoadComponent(FLevelLoadContext& Context);
 	void SaveComponent(FLevelSaveContext& Context);
@@ -193,11 +321,12 @@ public:
 	
 	FORCEINLINE FString ToString() const { return ComponentHandle.ToString(); }
 	/** @return size of dynamically allocated memory stored in the state */
-	FORCEINLINE uint32 GetAllocatedSize() const { return DefaultComponentState.GetAllocatedSize() + SavedComponentState.GetAllocatedSize(); }
+	FORCEINLINE uint32 GetAllocatedSize() const { return SavedComponentState.GetAllocatedSize(); }
 
 private:
+	friend struct FLevelPersistentState;
 	
-	FPersistentStateObjectDesc DefaultComponentState;
+	FPersistentStateDefaultObjectDesc DefaultComponentState;
 
 	/** serialized object state */
 	UPROPERTY(meta = (AlwaysLoaded))
@@ -243,8 +372,6 @@ public:
 
 	/** initialize actor state with actor handle */
 	void LinkActorHandle(AActor* Actor, const FPersistentStateObjectId& InActorHandle) const;
-	/** initialize actor state by re-creating dynamic actor */
-	AActor* CreateDynamicActor(UWorld* World, FActorSpawnParameters& SpawnParams) const;
 
 	void LoadActor(FLevelLoadContext& Context);
 	void SaveActor(FLevelSaveContext& Context);
@@ -273,10 +400,11 @@ public:
 	TArray<FComponentPersistentState> Components;
 
 private:
+	friend struct FLevelPersistentState;
 
 	void UpdateActorComponents(FLevelSaveContext& Context, const AActor& Actor);
 
-	FPersistentStateObjectDesc DefaultActorState;
+	FPersistentStateDefaultObjectDesc DefaultActorState;
 
 	/** serialized object state */
 	UPROPERTY(meta = (AlwaysLoaded))
@@ -306,6 +434,63 @@ struct TStructOpsTypeTraits<FActorPersistentState> : public TStructOpsTypeTraits
 };
 #endif
 
+/**
+ * World dependency table, shared by all level states in the world
+ * Interns object paths referenced by level states with stable indices, so level states and property bunches reference
+ * dependencies by index. Dependency is requested for loading once and is kept alive while any loaded level references it.
+ * Resolved objects are cached next to the object paths.
+ */
+USTRUCT()
+struct PERSISTENTSTATE_API FLevelDependencyTable
+{
+	GENERATED_BODY()
+
+	/**
+	 * request async load for dependencies referenced by tracker indices, dependencies already requested by other levels are shared
+	 * @return streamable handle that is completed when all dependencies are loaded, nullptr if nothing has to be loaded
+	 */
+	TSharedPtr<FStreamableHandle> RequestAssets(TConstArrayView<int32> Indices);
+	/** release dependencies previously requested by RequestAssets */
+	void ReleaseAssets(TConstArrayView<int32> Indices);
+	/**
+	 * release dependencies that are not referenced by any level state and are not loaded, so that the table doesn't
+	 * accumulate dependencies between saves. Indices of referenced dependencies are stable, released index is stored as
+	 * an empty object path and is reused for the next added dependency
+	 * @param ReferencedIndices dependency indices referenced by level states
+	 */
+	void ReleaseUnreferenced(const TBitArray<>& ReferencedIndices);
+
+	/** @return resolved class, caches resolved object for tracked class paths */
+	UClass* ResolveClass(const FSoftClassPath& ClassPath);
+
+	/** @return size of dynamically allocated memory stored in the table */
+	uint32 GetAllocatedSize() const;
+
+	FORCEINLINE int32 NumDependencies() const { return Tracker.NumValues(); }
+
+	/** interned object paths, indices are stable while dependency is referenced by the world state */
+	UPROPERTY()
+	FPersistentStateObjectTracker Tracker;
+
+private:
+	struct FDependencyEntry
+	{
+		/** resolved object */
+		TWeakObjectPtr<UObject> Object;
+		/** streamable handle that keeps dependency alive, can be shared between multiple dependencies */
+		TSharedPtr<FStreamableHandle> Handle;
+		/** number of loaded levels that reference dependency */
+		int32 NumRefs = 0;
+	};
+
+	FDependencyEntry& GetEntry(int32 Index);
+
+	/** runtime dependency data, matches tracker layout */
+	TArray<FDependencyEntry> Entries;
+	/** number of dependency entries that share a streamable handle, handle is released once no entry references it */
+	TMap<FStreamableHandle*, int32> HandleRefs;
+};
+
 USTRUCT()
 struct PERSISTENTSTATE_API FLevelPersistentState
 {
@@ -326,27 +511,60 @@ struct PERSISTENTSTATE_API FLevelPersistentState
 	const FActorPersistentState* GetActorState(const FPersistentStateObjectId& ActorHandle) const;
 	FActorPersistentState* GetActorState(const FPersistentStateObjectId& ActorHandle);
 	FActorPersistentState* CreateActorState(AActor* Actor, const FPersistentStateObjectId& ActorHandle);
+	/** @return index of the actor state in Actors array, INDEX_NONE if level state doesn't contain an actor */
+	int32 FindActorIndex(const FPersistentStateObjectId& ActorHandle) const;
+	/** remove actor state referenced by actor id */
+	void RemoveActorState(const FPersistentStateObjectId& ActorHandle);
+	/** remove actor state at a given index. Last actor state is moved in place of the removed one */
+	void RemoveActorStateAt(int32 Index);
+	/**
+	 * initialize actor state at @ActorIndex by re-creating dynamic actor
+	 * Actor states can be reallocated by actors spawned during creation, so actor state is accessed by index
+	 */
+	AActor* CreateDynamicActor(int32 ActorIndex, FLevelLoadContext& Context, UWorld* World, FActorSpawnParameters& SpawnParams);
 	
-	FLevelLoadContext CreateLoadContext();
-	FLevelSaveContext CreateSaveContext(bool bFromLevelStreaming);
+	FLevelLoadContext CreateLoadContext(FLevelDependencyTable& DependencyTable);
+	FLevelSaveContext CreateSaveContext(FLevelDependencyTable& DependencyTable, bool bFromLevelStreaming);
 	
 	/** @return size of dynamically allocated memory stored in the state */
 	uint32 GetAllocatedSize() const;
 
 	FORCEINLINE bool IsEmpty() const { return Actors.IsEmpty(); }
 
-	void PreLoadAssets(FStreamableDelegate LoadCompletedDelegate);
+	/** release arena data no longer referenced by actor and component states */
+	void CompactArena();
+
+#if WITH_COMPACT_SERIALIZATION
+	/** serialize level state either in row or columnar layout @see GPersistentState_ColumnarLevelEncoding */
+	bool Serialize(FArchive& Ar);
+#endif // WITH_COMPACT_SERIALIZATION
+	/** reports schemas of SaveGame bunches stored in the arena to the active schema reference scope when saving */
+	void PostSerialize(const FArchive& Ar);
+
+	void PreLoadAssets(FLevelDependencyTable& DependencyTable, FStreamableDelegate LoadCompletedDelegate);
 	void FinishLoadAssets();
-	void ReleaseLevelAssets();
+	void ReleaseLevelAssets(FLevelDependencyTable& DependencyTable);
 	
 	UPROPERTY()
 	FPersistentStateObjectId LevelHandle;
 
+	/**
+	 * actor states stored contiguously, so that save and load iterate them linearly. Order is not stable,
+	 * removing an actor state moves the last actor state in its place. Use FindActorIndex to lookup actor state by id
+	 */
 	UPROPERTY()
-	TMap<FPersistentStateObjectId, FActorPersistentState> Actors;
+	TArray<FActorPersistentState> Actors;
 	
+	/** indices of world dependencies referenced by the level state @see FLevelDependencyTable */
 	UPROPERTY()
-	FPersistentStateObjectTracker DependencyTracker;
+	TArray<int32> Dependencies;
+
+	/** SaveGame bunches of actor and component states */
+	UPROPERTY()
+	FPersistentStateLevelArena Arena;
+
+	/** dependencies requested by the level state, released when level is unloaded */
+	TArray<int32> LoadedDependencies;
 
 	/** streamable handle that keeps hard dependencies alive required by level state */
 	TSharedPtr<FStreamableHandle> AssetHandle;
@@ -354,6 +572,23 @@ struct PERSISTENTSTATE_API FLevelPersistentState
 	uint8 bLevelInitialized: 1 = false;
 	uint8 bLevelAdded: 1 = false;
 	uint8 bStreamingLevel: 1 = false;
+
+private:
+	/** rebuild actor index map from the actor array */
+	void CacheActorIndices() const;
+
+	/** maps actor id to index in Actors array, lazily rebuilt if it gets out of sync with the actor array */
+	mutable TMap<FPersistentStateObjectId, int32> ActorIndices;
+};
+
+template <>
+struct TStructOpsTypeTraits<FLevelPersistentState> : public TStructOpsTypeTraitsBase2<FLevelPersistentState>
+{
+	enum
+	{
+		WithSerializer = WITH_COMPACT_SERIALIZATION,
+		WithPostSerialize = true,
+	};
 };
 
 UCLASS()
@@ -417,6 +652,10 @@ private:
 	UPROPERTY()
 	TMap<FPersistentStateObjectId, FLevelPersistentState> Levels;
 
+	/** object paths referenced by level states, shared between all levels */
+	UPROPERTY()
+	FLevelDependencyTable DependencyTable;
+
 	UPROPERTY()
 	TSet<FPersistentStateObjectId> DestroyedObjects;
 
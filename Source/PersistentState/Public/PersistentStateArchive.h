@@ -1,9 +1,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PersistentStateSerialization.h"
 #include "Serialization/ArchiveProxy.h"
 
-
 #include "PersistentStateArchive.generated.h"
 
 class FName;
@@ -46,13 +46,47 @@ public:
 	uint64 SaveValue(const FSoftObjectPath& Value);
 	/** Map deserialized object path index to a full object path */
 	FSoftObjectPath LoadValue(uint64 Index);
+	/** @return index of a previously saved object path, 0 if path is not tracked */
+	uint64 FindValue(const FSoftObjectPath& Value);
 
 	void Reset()
 	{
 		Values.Reset();
 		ValueMap.Reset();
+		FreeIndices.Reset();
+		NumReleasedValues = 0;
 	}
 
+	/** release value at a given index, released index loads an empty object path until it is reused by SaveValue */
+	void ReleaseValue(int32 Index);
+
+	/** Scope that collects unique indices of all values referenced via SaveValue */
+	struct FCollectReferencesScope
+	{
+		FCollectReferencesScope(FPersistentStateObjectTracker& InTracker, TArray<int32>& OutReferences)
+			: References(OutReferences)
+			, Guard(InTracker.ReferenceCollector, this)
+		{}
+
+		FORCEINLINE void AddReference(int32 Index)
+		{
+			if (Index >= CollectedIndices.Num())
+			{
+				CollectedIndices.SetNum(Index + 1, false);
+			}
+			if (!CollectedIndices[Index])
+			{
+				CollectedIndices[Index] = true;
+				References.Add(Index);
+			}
+		}
+
+		TArray<int32>& References;
+		/** indices already added to references */
+		TBitArray<> CollectedIndices;
+		TGuardValue<FCollectReferencesScope*> Guard;
+	};
+
 	bool IsEmpty() const
 	{
 		return Values.IsEmpty();
@@ -66,12 +100,25 @@ public:
 	UPROPERTY()
 	TArray<FSoftObjectPath> Values;
 private:
+	/** rebuild value map from values, value map is not serialized */
+	void CacheValueMap();
+	/** @return true if value map has to be rebuilt */
+	FORCEINLINE bool IsValueMapDirty() const { return ValueMap.Num() + NumReleasedValues != Values.Num(); }
+	
 	TMap<FSoftObjectPath, int32> ValueMap;
+	/** released indices that are reused for new values, rebuilt with the value map */
+	TArray<int32> FreeIndices;
+	/** number of released values, which are not stored in the value map */
+	int32 NumReleasedValues = 0;
+	/** optional collector of referenced value indices @see FCollectReferencesScope */
+	FCollectReferencesScope* ReferenceCollector = nullptr;
 };
 
 
 /**
- * Generic implementation for reference tracker of a specific type
+ * Name tracker, that maps names to a string table
+ * On save, names are keyed by FName comparison, so name string is created only once for each unique name.
+ * On load, string table is converted to names once, so that each name lookup is an array access.
  */
 template <bool bLoading>
 struct PERSISTENTSTATE_API FPersistentStateStringTracker
@@ -80,12 +127,14 @@ public:
 	FPersistentStateStringTracker() = default;
 	FPersistentStateStringTracker(const TArray<FString>& InValues) requires bLoading
 		: Values(InValues)
-	{}
+	{
+		CacheNames();
+	}
 
-	/** Map string to an index which caller is expected to serialize instead of a string */
-	uint64 SaveValue(const FString& Value) requires !bLoading;
-	/** Map deserialized string index to a full string */
-	FString LoadValue(uint64 Index) requires bLoading;
+	/** Map name to an index which caller is expected to serialize instead of a string */
+	uint64 SaveValue(FName Value) requires !bLoading;
+	/** Map deserialized string index to a name */
+	FName LoadValue(uint64 Index) const requires bLoading;
 
 	int32 NumValues() const { return Values.Num(); }
 	TArrayView<FString> GetValues() { return Values; }
@@ -94,12 +143,23 @@ public:
 	friend FArchive& operator<<(FArchive& Ar, FPersistentStateStringTracker& Tracker)
 	{
 		Ar << Tracker.Values;
+		if constexpr (bLoading)
+		{
+			Tracker.CacheNames();
+		}
+		
 		return Ar;
 	}
 	
 	TArray<FString> Values;
 private:
-	TMap<FString, int32> ValueMap;
+	/** convert string table to names */
+	void CacheNames() requires bLoading;
+
+	/** map name to a string table index, used by save */
+	TMap<FName, int32> ValueMap;
+	/** names created from string table, used by load */
+	TArray<FName> Names;
 };
 
 /**
@@ -159,3 +219,32 @@ struct FPersistentStateObjectTrackerProxy: public FArchiveProxy
 	
 	FPersistentStateObjectTracker& ObjectTracker;
 };
+
+/**
+ * State archive, fuses object tracker proxy, string tracker proxy and persistent state proxy archive into a single layer
+ * Names, soft objects and top level assets are mapped to string and object tables inline, and every other value
+ * is forwarded to the wrapped archive with a single virtual call. Produces the same output as a proxy chain of
+ * ObjectTrackerProxy -> StringTrackerProxy -> PersistentStateProxyArchive, so both can be used to read the data.
+ * Load/save direction and dependency mode are compile time parameters and should match for both save and load.
+ */
+template <bool bLoading, ESerializeObjectDependency DependencyMode>
+struct FPersistentStateStateArchive final: public FPersistentStateProxyArchive
+{
+	FPersistentStateStateArchive(FArchive& InArchive, FPersistentStateObjectTracker& InObjectTracker)
+		: FPersistentStateProxyArchive(InArchive)
+		, ObjectTracker(InObjectTracker)
+	{}
+
+	/** write object table and string table to the archive, object table is written first as it adds names to a string table */
+	void WriteTables(uint32& OutObjectTablePosition, uint32& OutStringTablePosition) requires !bLoading;
+	/** read string table and object table from the archive, restores archive position */
+	void ReadTables(int32 ObjectTablePosition, int32 StringTablePosition) requires bLoading;
+
+	virtual FArchive& operator<<(FName& Name) override;
+	virtual FArchive& operator<<(UObject*& Obj) override;
+	virtual FArchive& operator<<(FSoftObjectPtr& Value) override;
+	virtual FArchive& operator<<(FSoftObjectPath& Value) override;
+
+	FPersistentStateStringTracker<bLoading> StringTracker;
+	FPersistentStateObjectTracker& ObjectTracker;
+};
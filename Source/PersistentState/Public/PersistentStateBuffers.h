@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPersistentStateManager;
+
+/**
+ * State Buffer Pool
+ * Keeps state and compression buffers released by previous saves and loads, so that next save can reuse already
+ * allocated memory instead of growing a new buffer from scratch. Buffers can be acquired and released from any thread.
+ */
+class PERSISTENTSTATE_API FPersistentStateBufferPool
+{
+public:
+	FORCEINLINE static FPersistentStateBufferPool& Get()
+	{
+		return Instance;
+	}
+
+	/** @return empty buffer with at least @MinCapacity bytes allocated */
+	TArray<uint8> Acquire(int32 MinCapacity);
+	/**
+	 * return buffer to the pool. Buffer slack beyond its used size is freed first, buffer is discarded if pool is full
+	 * or if it doesn't fit into the pool memory budget
+	 */
+	void Release(TArray<uint8>&& Buffer);
+	/** free all pooled buffers */
+	void Reset();
+
+	/** @return pooled buffers memory */
+	SIZE_T GetAllocatedSize() const;
+	
+private:
+	static FPersistentStateBufferPool Instance;
+
+	mutable FCriticalSection CriticalSection;
+	/** pooled buffers, always empty */
+	TArray<TArray<uint8>> Buffers;
+	/** total capacity of pooled buffers in bytes */
+	int64 RetainedSize = 0;
+};
+
+/**
+ * Rolling size estimate of a serialized state, tracked per state (game state or a world) and per state manager
+ * Estimate grows immediately to the largest sample and decays slowly towards smaller samples, so that state buffers are
+ * reserved once before save instead of being reallocated while state managers are serialized.
+ */
+struct PERSISTENTSTATE_API FPersistentStateSizeEstimate
+{
+	/** @return estimated state size in bytes, uses sum of state manager estimates if state was never saved before */
+	int32 EstimateStateSize(FName State, TConstArrayView<UPersistentStateManager*> Managers) const;
+	/** add state size sample */
+	void AddStateSample(FName State, int32 Size);
+	/** add state manager size sample */
+	void AddManagerSample(const UPersistentStateManager* Manager, int32 Size);
+
+	void Reset()
+	{
+		StateSizes.Reset();
+		ManagerSizes.Reset();
+	}
+	
+private:
+	static void AddSample(TMap<FName, int32>& Sizes, FName Key, int32 Size);
+	
+	/** map state name to its estimated size */
+	TMap<FName, int32> StateSizes;
+	/** map state manager class name to its estimated size */
+	TMap<FName, int32> ManagerSizes;
+};
+
+/**
+ * State Delta
+ * Binary delta between two state buffers. State is split into content-defined chunks, so that chunk boundaries
+ * survive inserted or removed data. Chunks found in the base state are encoded as copy operations, others as literals.
+ */
+struct PERSISTENTSTATE_API FPersistentStateDelta
+{
+	/** @return delta that turns @Base into @State. Result buffer is taken from the buffer pool */
+	static TArray<uint8> Create(TConstArrayView<uint8> Base, TConstArrayView<uint8> State);
+	/**
+	 * apply delta created from @Base to @Base
+	 * @return false if delta doesn't match the base state
+	 */
+	static bool Apply(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, TArray<uint8>& OutState);
+};
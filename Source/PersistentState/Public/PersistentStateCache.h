@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PersistentStateSlot.h"
+
+/**
+ * State Cache
+ * LRU cache of decompressed game and world states, keyed by state slot and world and bounded by a memory budget.
+ * Travelling between recently visited worlds or slots is served from memory instead of reading and decompressing
+ * state data again. Most recently used game state and world state are always kept, even if they exceed the budget.
+ * Cache is not thread safe and is expected to be accessed from the game thread.
+ */
+class PERSISTENTSTATE_API FPersistentStateCache
+{
+public:
+	/** @return cached game state for a slot, or nullptr. Updates hit/miss stats */
+	FGameStateSharedRef FindGameState(FName Slot);
+	/** @return cached world state for a slot, or nullptr. Updates hit/miss stats */
+	FWorldStateSharedRef FindWorldState(FName Slot, FName World);
+	/** @return true if world state is cached for a slot. Doesn't update access order or stats */
+	bool HasWorldState(FName Slot, FName World) const;
+
+	/** add or replace game state for a slot and mark it as most recently used */
+	void AddGameState(FName Slot, const FGameStateSharedRef& GameState);
+	/** add or replace world state for a slot and mark it as most recently used */
+	void AddWorldState(FName Slot, const FWorldStateSharedRef& WorldState);
+
+	/** remove all states cached for a slot */
+	void RemoveSlot(FName Slot);
+	/** remove all states cached for slots that don't pass @Predicate */
+	void RemoveSlots(TFunctionRef<bool(FName)> Predicate);
+	/** remove all cached states */
+	void Reset();
+
+	/** @return number of invalidations, changes each time cached states are removed */
+	uint32 GetInvalidationCount() const { return InvalidationCount; }
+	/** @return cached states memory */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		FName Slot;
+		/** world name, NAME_None for a game state */
+		FName World;
+		FGameStateSharedRef GameState;
+		FWorldStateSharedRef WorldState;
+		/** state memory at the moment it was added to the cache */
+		SIZE_T Size = 0;
+		/** access order, larger is more recent */
+		uint64 LastAccess = 0;
+	};
+
+	FEntry* FindEntry(FName Slot, FName World);
+	FEntry& AddEntry(FName Slot, FName World, SIZE_T Size);
+	/** evict least recently used states until cache fits into the budget */
+	void Trim();
+
+	TArray<FEntry> Entries;
+	/** total memory of cached states */
+	SIZE_T TotalSize = 0;
+	uint64 AccessCounter = 0;
+	uint32 InvalidationCount = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PersistentStateStorage.h"
+
+#include "PersistentStateMemoryStorage.generated.h"
+
+struct FPersistentStateMemoryFiles;
+
+/**
+ * Memory State Storage
+ * Keeps state slots in memory as byte blobs with the same layout as slot files, state data is compressed if compression
+ * is enabled. Provides instant quick save/quick load and a disk-free baseline for performance tests.
+ * Modified slots can be flushed to slot files, so that they are picked up by the file-backed slot storage.
+ */
+UCLASS()
+class PERSISTENTSTATE_API UPersistentStateMemoryStorage: public UPersistentStateStorage
+{
+	GENERATED_BODY()
+public:
+	UPersistentStateMemoryStorage(const FObjectInitializer& Initializer);
+	UPersistentStateMemoryStorage(FVTableHelper& Helper);
+
+	//~Begin PersistentStateStorage interface
+	virtual void Init() override;
+	virtual void Shutdown() override;
+	virtual uint32 GetAllocatedSize() const override;
+	virtual void WaitUntilTasksComplete() const override;
+	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority = EPersistentStateTaskPriority::InteractiveSave) override;
+	virtual FGraphEventRef LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad, FLoadCompletedDelegate CompletedDelegate) override;
+	virtual FGraphEventRef UpdateAvailableStateSlots(FSlotUpdateCompletedDelegate CompletedDelegate) override;
+	virtual void SaveStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle) override {}
+	virtual bool LoadStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle, FLoadScreenshotCompletedDelegate CompletedDelegate) override { return false; }
+	virtual bool HasScreenshotForStateSlot(const FPersistentStateSlotHandle& TargetSlotHandle) override { return false; }
+	virtual FPersistentStateSlotHandle CreateStateSlot(const FName& SlotName, const FText& Title, TSubclassOf<UPersistentStateSlotDescriptor> DescriptorClass) override;
+	virtual FPersistentStateSlotHandle DuplicateStateSlot(const FPersistentStateSlotHandle& SourceSlotHandle, FName SlotName) override;
+	virtual void GetAvailableStateSlots(TArray<FPersistentStateSlotHandle>& OutStates, bool bOnDiskOnly) override;
+	virtual UPersistentStateSlotDescriptor* GetStateSlotDescriptor(const FPersistentStateSlotHandle& SlotHandle) const override;
+	virtual FPersistentStateSlotHandle GetStateSlotByName(FName SlotName) const override;
+	virtual bool CanLoadFromStateSlot(const FPersistentStateSlotHandle& SlotHandle, FName World) const override;
+	virtual bool CanSaveToStateSlot(const FPersistentStateSlotHandle& SlotHandle, FName World) const override;
+	virtual void RemoveStateSlot(const FPersistentStateSlotHandle& SlotHandle) override;
+	//~End PersistentStorage interface
+
+	/**
+	 * Write slots modified since the last flush to slot files, remove slot files for removed slots.
+	 * Flush is done asynchronously after all previously scheduled operations
+	 * @return task handle, may be completed on return
+	 */
+	FGraphEventRef FlushToFiles();
+
+protected:
+	FPersistentStateSlotSharedRef FindSlot(FName SlotName, bool* OutNamedSlot = nullptr) const;
+
+	/** @return true if slot has an associated memory file */
+	bool HasStateSlotFile(const FPersistentStateSlotSharedRef& Slot) const;
+	/** create empty memory file and associate it with a state slot */
+	void CreateStateSlotFile(const FPersistentStateSlotSharedRef& Slot, const FString& FilePath);
+
+	/** ensure all running tasks are completed */
+	void EnsureTaskCompletion() const;
+	FGraphEventArray GetPrerequisites() const;
+
+	/** default descriptor */
+	TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor;
+
+	/** A list of named slots, user-defined in editor */
+	TArray<FPersistentStateSlotSharedRef> NamedSlots;
+	/** A list of runtime-created slots */
+	TArray<FPersistentStateSlotSharedRef> RuntimeSlots;
+
+	/** memory files associated with state slots, shared with save and load tasks */
+	TSharedPtr<FPersistentStateMemoryFiles, ESPMode::ThreadSafe> Files;
+
+	/** last launched event, emulates a pipe behavior */
+	FGraphEventRef LastQueuedEvent;
+};
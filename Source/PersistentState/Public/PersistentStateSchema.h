@@ -0,0 +1,202 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UClass;
+class FProperty;
+enum class EReloadCompleteReason;
+
+/**
+ * Bunch encoding, stored as a first byte of the SaveGame property bunch
+ * Tagged - bunch is serialized via UObject::Serialize with tagged properties
+ * Schema - bunch stores class schema hash, property presence bitmask and raw property values
+ * FastState - flag, bunch starts with a size prefixed native state written by a fast serializer @see TPersistentStateTraits
+ */
+enum class EPersistentStateBunchFormat: uint8
+{
+	Tagged = 0,
+	Schema = 1,
+	FastState = 1 << 7,
+};
+ENUM_CLASS_FLAGS(EPersistentStateBunchFormat);
+
+/**
+ * Single schema entry, describes SaveGame property (or element of a static array property) by name and type
+ */
+struct PERSISTENTSTATE_API FPersistentStateSchemaProperty
+{
+	/** property name */
+	FString Name;
+	/** full property type, including template arguments for container types */
+	FString Type;
+	/** static array index */
+	int32 ArrayIndex = 0;
+
+	friend bool operator==(const FPersistentStateSchemaProperty& A, const FPersistentStateSchemaProperty& B)
+	{
+		return A.ArrayIndex == B.ArrayIndex && A.Name == B.Name && A.Type == B.Type;
+	}
+
+	friend uint32 GetTypeHash(const FPersistentStateSchemaProperty& Value)
+	{
+		return HashCombineFast(HashCombineFast(GetTypeHash(Value.Name), GetTypeHash(Value.Type)), ::GetTypeHash(Value.ArrayIndex));
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FPersistentStateSchemaProperty& Value)
+	{
+		Ar << Value.Name;
+		Ar << Value.Type;
+		Ar << Value.ArrayIndex;
+		return Ar;
+	}
+};
+
+/**
+ * Ordered list of SaveGame properties for a given class. Schema is content addressed by its hash, so that bunches
+ * reference schema only by hash value and full schema is stored once per state data in a schema table
+ */
+struct PERSISTENTSTATE_API FPersistentStateClassSchema
+{
+	/** class path, used only for diagnostics */
+	FString ClassPath;
+	/** schema hash, calculated from class path and schema properties. Never zero for a valid schema */
+	uint64 Hash = 0;
+	/** schema properties */
+	TArray<FPersistentStateSchemaProperty> Properties;
+
+	/** @return number of bytes required to store property presence bitmask */
+	FORCEINLINE int32 GetMaskSize() const { return FMath::DivideAndRoundUp(Properties.Num(), 8); }
+
+	uint64 CalculateHash() const;
+	SIZE_T GetAllocatedSize() const;
+
+	/** compare schema contents, schemas with equal hashes can still be different in case of a hash collision */
+	friend bool operator==(const FPersistentStateClassSchema& A, const FPersistentStateClassSchema& B)
+	{
+		return A.Hash == B.Hash && A.ClassPath == B.ClassPath && A.Properties == B.Properties;
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FPersistentStateClassSchema& Value)
+	{
+		Ar << Value.ClassPath;
+		Ar << Value.Hash;
+		Ar << Value.Properties;
+		return Ar;
+	}
+};
+
+/**
+ * Runtime class schema, maps schema properties to a class properties
+ */
+struct PERSISTENTSTATE_API FPersistentStateRuntimeSchema
+{
+	/** @return false if class schema collides with another registered schema, class can't use schema serialization */
+	FORCEINLINE bool IsValid() const { return Hash != 0; }
+	
+	/** schema hash, zero if runtime schema is not valid */
+	uint64 Hash = 0;
+	/** class properties, matches schema property layout */
+	TArray<TPair<FProperty*, int32>> Properties;
+};
+
+/**
+ * Schema Registry
+ * Builds and stores class schemas for SaveGame property serialization. Schemas are never removed from the registry,
+ * as property bunches stored in game and world state can reference them long after they were created.
+ * Runtime schemas cache SaveGame property list for each class, so that SaveGame serialization skips full reflection walk.
+ * Runtime schema is rebuilt after hot reload, class reinstancing or if class has been garbage collected.
+ */
+class PERSISTENTSTATE_API FPersistentStateSchemaRegistry
+{
+public:
+	FORCEINLINE static FPersistentStateSchemaRegistry& Get()
+	{
+		return Instance;
+	}
+
+	/** @return runtime schema for a given class, creates a new schema if class is encountered for the first time */
+	const FPersistentStateRuntimeSchema& GetRuntimeSchema(const UClass* Class);
+
+	/** @return class schema by hash value, nullptr if schema is not registered. Schema registered first keeps a colliding hash */
+	const FPersistentStateClassSchema* FindSchema(uint64 Hash) const;
+
+	/**
+	 * @return remap table from @SavedSchema property indices to the @CurrentSchema property indices, INDEX_NONE for properties
+	 * that were removed or changed their type. Remap table is cached for each saved and current schema pair
+	 */
+	const TArray<int32>& GetSchemaRemap(const FPersistentStateClassSchema& SavedSchema, const FPersistentStateClassSchema& CurrentSchema);
+
+	/** write schema table with @SchemaHashes schemas to the archive */
+	void WriteSchemaTable(FArchive& Ar, const TSet<uint64>& SchemaHashes);
+	/** read schema table from archive at a given position, register all missing schemas. Restores archive position */
+	void ReadSchemaTable(FArchive& Ar, int32 StartPosition);
+
+	/** @return schema registry memory */
+	SIZE_T GetAllocatedSize() const;
+
+	/** reset runtime schema cache */
+	void ResetRuntimeSchemas() { RuntimeSchemas.Reset(); }
+
+	/** register engine delegates, called on module startup */
+	void Initialize();
+	/** unregister engine delegates and reset runtime schemas, called on module shutdown */
+	void Shutdown();
+private:
+	using ThisClass = FPersistentStateSchemaRegistry;
+	static FPersistentStateSchemaRegistry Instance;
+
+	void OnReloadComplete(EReloadCompleteReason Reason);
+	void OnObjectsReinstanced(const TMap<UObject*, UObject*>& ReplacedObjects);
+	void OnPostGarbageCollect();
+
+	/** register class schema. @return false if schema hash is already used by a different schema, registered schema is kept */
+	bool AddSchema(FPersistentStateClassSchema&& Schema);
+
+	/** map class to a runtime schema */
+	TMap<TWeakObjectPtr<const UClass>, FPersistentStateRuntimeSchema> RuntimeSchemas;
+	/** map schema hash to a class schema, either created at runtime or loaded from the schema table */
+	TMap<uint64, FPersistentStateClassSchema> Schemas;
+	/** map saved and current schema hash pair to the property remap table */
+	TMap<TPair<uint64, uint64>, TArray<int32>> SchemaRemaps;
+
+	FDelegateHandle ReloadCompleteHandle;
+	FDelegateHandle ObjectsReinstancedHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+};
+
+/**
+ * Schema Reference Scope
+ * Collects schemas referenced by property bunches written to the state data while scope is active on the current thread,
+ * so that state schema table stores only schemas required to load its bunches.
+ */
+class PERSISTENTSTATE_API FPersistentStateSchemaReferenceScope
+{
+public:
+	FPersistentStateSchemaReferenceScope();
+	~FPersistentStateSchemaReferenceScope();
+	UE_NONCOPYABLE(FPersistentStateSchemaReferenceScope);
+
+	/** add schema referenced by @PropertyBunch to the active scope, if any */
+	static void AddBunchReference(TConstArrayView<uint8> PropertyBunch);
+
+	/** referenced schema hashes */
+	TSet<uint64> Schemas;
+
+private:
+	FPersistentStateSchemaReferenceScope* OuterScope = nullptr;
+};
+
+namespace UE::PersistentState
+{
+	/** @return schema hash referenced by a property bunch, zero if bunch is not a schema bunch or doesn't store properties */
+	PERSISTENTSTATE_API uint64 GetBunchSchemaHash(TConstArrayView<uint8> PropertyBunch);
+	
+	/**
+	 * save object SaveGame property values using class schema
+	 * Properties are delta serialized against @BaselineAr schema data if it is provided, or against object archetype otherwise.
+	 * @return true if any property value has been written
+	 */
+	PERSISTENTSTATE_API bool SaveObjectSchema(FArchive& Ar, UObject& Object, FArchive* BaselineAr = nullptr);
+	/** load object SaveGame property values using class schema, handles schema mismatch for removed/changed properties */
+	PERSISTENTSTATE_API void LoadObjectSchema(FArchive& Ar, UObject& Object);
+}
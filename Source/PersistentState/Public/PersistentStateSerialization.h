@@ -1,6 +1,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Serialization/StructuredArchive.h"
+#include "Serialization/Formatters/BinaryArchiveFormatter.h"
+#include "UObject/Class.h"
 
 /** Persistent State Archive Formatter */
 template <bool bWithTextSupport>
@@ -17,6 +20,89 @@ public:
 
 using FPersistentStateFormatter = TPersistentStateFormatter<WITH_TEXT_ARCHIVE_SUPPORT && WITH_STRUCTURED_SERIALIZATION>;
 
+/**
+ * Persistent State root record, serializes top level values (chunk headers, state managers, state slot) to the archive
+ * Structured version opens a structured archive with a formatter selected by @FPersistentStateFormatter, so that
+ * debug formatters can write named fields. Binary formatter is created on the stack, text formatters are allocated.
+ */
+template <bool bWithTextSupport>
+class TPersistentStateRecord
+{
+public:
+	explicit TPersistentStateRecord(FArchive& Ar)
+		: StructuredArchive(CreateFormatter(Ar))
+		, Record(StructuredArchive.Open().EnterRecord())
+	{}
+
+	template <typename T>
+	FORCEINLINE void Serialize(const TCHAR* Name, T& Value)
+	{
+		Record << SA_VALUE(Name, Value);
+	}
+
+	FORCEINLINE void SerializeStruct(const TCHAR* Name, UScriptStruct* Struct, void* Data)
+	{
+		Struct->SerializeItem(Record.EnterField(Name), Data, nullptr);
+	}
+
+	FORCEINLINE void SerializeObject(UObject& Object)
+	{
+		Object.Serialize(Record);
+	}
+
+private:
+	FArchiveFormatterType& CreateFormatter(FArchive& Ar)
+	{
+		// always use binary formatter for loading
+		if (Ar.IsLoading() || TPersistentStateFormatter<bWithTextSupport>::IsReleaseFormatter())
+		{
+			return BinaryFormatter.Emplace(Ar);
+		}
+
+		TextFormatter = TPersistentStateFormatter<bWithTextSupport>::CreateSaveFormatter(Ar);
+		return *TextFormatter;
+	}
+	
+	TOptional<FBinaryArchiveFormatter> BinaryFormatter;
+	TUniquePtr<FArchiveFormatterType> TextFormatter;
+	FStructuredArchive StructuredArchive;
+	FStructuredArchive::FRecord Record;
+};
+
+/**
+ * Release version, serializes values directly to the archive without formatter and structured archive bookkeeping
+ * Produces the same binary output as a structured archive with binary formatter.
+ */
+template <>
+class TPersistentStateRecord<false>
+{
+public:
+	explicit TPersistentStateRecord(FArchive& InAr)
+		: Ar(InAr)
+	{}
+
+	template <typename T>
+	FORCEINLINE void Serialize(const TCHAR* Name, T& Value)
+	{
+		Ar << Value;
+	}
+
+	FORCEINLINE void SerializeStruct(const TCHAR* Name, UScriptStruct* Struct, void* Data)
+	{
+		Struct->SerializeItem(Ar, Data, nullptr);
+	}
+
+	FORCEINLINE void SerializeObject(UObject& Object)
+	{
+		Object.Serialize(Ar);
+	}
+
+private:
+	FArchive& Ar;
+};
+
+using FPersistentStateRecord = TPersistentStateRecord<WITH_TEXT_ARCHIVE_SUPPORT && WITH_STRUCTURED_SERIALIZATION>;
+
 /** Persistent State Proxy archive */
 struct PERSISTENTSTATE_API FPersistentStateProxyArchive: public FArchiveProxy
 {
@@ -58,12 +144,12 @@ struct PERSISTENTSTATE_API FPersistentStateSaveGameArchive: public FPersistentSt
 	UObject* OwningObject = nullptr;
 };
 
-/** Memory reader */
-class PERSISTENTSTATE_API FPersistentStateMemoryReader: public FMemoryReader
+/** Memory reader, reads from a non-owning view so that data can be stored in any contiguous memory */
+class PERSISTENTSTATE_API FPersistentStateMemoryReader: public FMemoryReaderView
 {
 public:
-	FPersistentStateMemoryReader(const TArray<uint8>& InBytes, bool bIsPersistent = false)
-		: FMemoryReader(InBytes, bIsPersistent)
+	FPersistentStateMemoryReader(TConstArrayView<uint8> InBytes, bool bIsPersistent = false)
+		: FMemoryReaderView(InBytes, bIsPersistent)
 	{}
 };
 
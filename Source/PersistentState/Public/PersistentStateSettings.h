@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
 
 #include "PersistentStateSettings.generated.h"
 
@@ -38,6 +39,7 @@ public:
 	UPersistentStateSettings(const FObjectInitializer& Initializer);
 
 	virtual void PostLoad() override;
+	virtual void PostReloadConfig(FProperty* PropertyThatWasLoaded) override;
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
@@ -68,6 +70,8 @@ public:
 	bool CanCreateWorldState() const;
 	bool ShouldCacheSlotState() const;
 	bool UseGameThread() const;
+	/** @return true if object transform can be quantized with a loss of precision. Result is cached per class, game thread only */
+	bool ShouldQuantizeTransform(const UClass* ObjectClass) const;
 	
 	
 	/** state storage implementation used by state subsystem */
@@ -105,6 +109,17 @@ public:
 	UPROPERTY(EditAnywhere, Config, meta = (EditCondition = "bCaptureScreenshot", DisplayAfter = "bCaptureScreenshot"))
 	FIntPoint ScreenshotResolution{600, 400};
 
+	/**
+	 * Classes that allow lossy transform quantization: location is stored as fixed point value and rotation is stored as
+	 * a compressed quaternion. Transforms of any other class are stored without precision loss
+	 */
+	UPROPERTY(EditAnywhere, Config)
+	TArray<TSoftClassPtr<UObject>> QuantizedTransformClasses;
+
+	/** fixed point location precision in world units, used for quantized transforms */
+	UPROPERTY(EditAnywhere, Config, meta = (ClampMin = "0.0001", UIMin = "0.0001"))
+	double QuantizedLocationPrecision = 0.01;
+
 	/**
 	 * Controls whether persistent state subsystem is created
 	 * If set to false, persistent state functionality is fully disabled
@@ -152,4 +167,8 @@ public:
 	/** If set, screenshot captures UI as well */
 	UPROPERTY(EditAnywhere, Config, meta = (EditCondition = "bEnabled && bCaptureScreenshot"))
 	uint8 bCaptureUI: 1 = false;
+
+private:
+	/** cached ShouldQuantizeTransform result for each class, reset when settings are changed */
+	mutable TMap<TObjectKey<UClass>, bool> QuantizedTransformCache;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PersistentStateBuffers.h"
 #include "Managers/PersistentStateManager.h"
 
 #include "PersistentStateSlot.generated.h"
@@ -54,6 +55,23 @@ static constexpr int32 SLOT_HEADER_TAG		= 0x53A41B6D;
 static constexpr int32 GAME_HEADER_TAG		= 0x8D4525F3;
 static constexpr int32 WORLD_HEADER_TAG		= 0x3AEF241C;
 
+/** state data format version, stored in the state data header */
+enum class EPersistentStateFormatVersion: uint32
+{
+	/** state data saved before format version has been introduced */
+	Initial = 0,
+	/** property bunches start with a bunch format, fast state is size prefixed, schema table stores 64-bit schema hashes */
+	BunchFormat = 1,
+	/** level state stores quantized location precision */
+	LevelLocationPrecision = 2,
+
+	// -----<new versions can be added above this line>-----
+	VersionPlusOne,
+	LatestVersion = VersionPlusOne - 1,
+	/** oldest format version that can be loaded */
+	MinSupportedVersion = LevelLocationPrecision,
+};
+
 /**
  * 
  */
@@ -101,6 +119,13 @@ public:
 		Record << SA_VALUE(TEXT("Size"), Value.ChunkSize);
 	}
 
+	friend FArchive& operator<<(FArchive& Ar, FPersistentStateDataChunkHeader& Value)
+	{
+		Value.ChunkType.SerializePath(Ar);
+		Ar << Value.ChunkSize;
+		return Ar;
+	}
+
 	friend bool operator==(const FPersistentStateDataChunkHeader& A, const FPersistentStateDataChunkHeader& B)
 	{
 		return A.ChunkType == B.ChunkType && A.ChunkSize == B.ChunkSize;
@@ -128,13 +153,35 @@ struct PERSISTENTSTATE_API FStateDataHeader
 	
 	void InitializeToEmpty()
 	{
-		ChunkCount = ObjectTablePosition = StringTablePosition = 0;
+		ChunkCount = ObjectTablePosition = StringTablePosition = SchemaTablePosition = 0;
 		DataStart = DataSize = 0;
+		FormatVersion = static_cast<uint32>(EPersistentStateFormatVersion::LatestVersion);
+		BlockHash.Reset();
+		BaseBlockHash.Reset();
 	}
 
 	FORCEINLINE bool HasData() const
 	{
-		return IsValid() && DataStart != 0 && DataSize > 0;
+		return IsValid() && (DataStart != 0 || IsBlockData()) && DataSize > 0;
+	}
+
+	/** @return true if state data is stored in the block store instead of the slot file */
+	FORCEINLINE bool IsBlockData() const
+	{
+		return !BlockHash.IsEmpty();
+	}
+
+	/** @return true if state data is a delta against a base state stored in the block store */
+	FORCEINLINE bool IsDeltaData() const
+	{
+		return !BaseBlockHash.IsEmpty();
+	}
+	
+	/** @return true if state data format version can be loaded */
+	FORCEINLINE bool IsSupportedVersion() const
+	{
+		return	FormatVersion >= static_cast<uint32>(EPersistentStateFormatVersion::MinSupportedVersion) &&
+				FormatVersion <= static_cast<uint32>(EPersistentStateFormatVersion::LatestVersion);
 	}
 	
 	FORCEINLINE bool IsValid() const
@@ -142,6 +189,7 @@ struct PERSISTENTSTATE_API FStateDataHeader
 		return	ChunkCount != INVALID_SIZE &&
 				ObjectTablePosition != INVALID_SIZE &&
 				StringTablePosition != INVALID_SIZE &&
+				SchemaTablePosition != INVALID_SIZE &&
 				DataSize != INVALID_SIZE;
 	}
 	
@@ -164,13 +212,29 @@ struct PERSISTENTSTATE_API FStateDataHeader
 	UPROPERTY()
 	uint32 StringTablePosition = INVALID_SIZE;
 
-	/** state data start position inside the slot save archive, never zero */
+	/** schema table position inside the state data, absolute is calculated as DataStart + SchemaTablePosition. Can be zero */
+	UPROPERTY()
+	uint32 SchemaTablePosition = INVALID_SIZE;
+
+	/** state data start position inside the slot save archive, never zero. Zero if state data is stored in the block store */
 	UPROPERTY()
 	FPersistentStateFixedInteger DataStart{INVALID_SIZE};
 
 	/** state data length in bytes in the save file, including object table and string table, can be zero */
 	UPROPERTY()
 	uint32 DataSize = INVALID_SIZE;
+
+	/** content hash of the uncompressed state data, identifies a block file in the block store. Empty if state data is stored in the slot file */
+	UPROPERTY()
+	FString BlockHash;
+
+	/** content hash of the base state in the block store, state data is a delta against it. Empty if state data is a full state */
+	UPROPERTY()
+	FString BaseBlockHash;
+
+	/** state data format version @see EPersistentStateFormatVersion. Zero if state data is saved before versioning */
+	UPROPERTY()
+	uint32 FormatVersion = 0;
 };
 
 USTRUCT()
@@ -240,10 +304,14 @@ struct PERSISTENTSTATE_API FWorldStateDataHeader: public FStateDataHeader
 template <typename TDataHeader>
 struct PERSISTENTSTATE_API FManagerState
 {
-	/** create manager state for save */
-	static FManagerState<TDataHeader> CreateSaveState()
+	/** create manager state for save, state buffer is taken from the buffer pool and reserved to @ReserveSize */
+	static FManagerState<TDataHeader> CreateSaveState(int32 ReserveSize = 0)
 	{
-		return FManagerState<TDataHeader>{};
+		FManagerState<TDataHeader> State{};
+		// state data is always saved with the latest format version
+		State.Header.FormatVersion = static_cast<uint32>(EPersistentStateFormatVersion::LatestVersion);
+		State.Buffer = FPersistentStateBufferPool::Get().Acquire(ReserveSize);
+		return State;
 	}
 
 	/** create manager state for load */
@@ -258,6 +326,17 @@ struct PERSISTENTSTATE_API FManagerState
 		
 	TDataHeader Header;
 	TArray<uint8> Buffer;
+
+	FManagerState(const FManagerState&) = default;
+	FManagerState(FManagerState&&) = default;
+	FManagerState& operator=(const FManagerState&) = default;
+	FManagerState& operator=(FManagerState&&) = default;
+	
+	~FManagerState()
+	{
+		// return state buffer to the pool, so that it can be reused by the next save or load
+		FPersistentStateBufferPool::Get().Release(MoveTemp(Buffer));
+	}
 	
 private:
 	/** save constructor */
@@ -315,25 +394,65 @@ public:
 	
 	/** reset all data */
 	void ResetFileState();
+
+	/** @return copy of the slot named @InSlotName, associated with @InFilePath that holds a copy of the slot file */
+	FPersistentStateSlot CreateDuplicate(FName InSlotName, const FString& InFilePath) const;
 	
-	/** load game state to a shared game data via archive reader */
+	/** load game state to a shared game data via archive reader. @return null state if state data can't be read */
 	FGameStateSharedRef LoadGameState(FArchiveFactory CreateReadArchive) const;
-	/** load world state to a shared world data via archive reader */
+	/** load world state to a shared world data via archive reader. @return null state if state data can't be read or resolved */
 	FWorldStateSharedRef LoadWorldState(FName World, FArchiveFactory CreateReadArchive) const;
+	/**
+	 * load game state and world state via a single archive reader. State data is read sequentially,
+	 * game state is decompressed on a separate task while world state is read and decompressed. Returns after both states are loaded
+	 * @param bLoadGameState if false, game state is not loaded
+	 * @param World world to load, world state is not loaded if slot doesn't have world data
+	 * Output state is null if its data can't be read or resolved
+	 */
+	void LoadState(bool bLoadGameState, FName World, FArchiveFactory CreateReadArchive, FGameStateSharedRef& OutGameState, FWorldStateSharedRef& OutWorldState) const;
 	/** save state directly to the */
 	void SaveStateDirect(const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateWriteArchive);
-	/** save new state to a slot archive */
-	void SaveState(const FPersistentStateSlot& SourceSlot,
+	/**
+	 * save new state to a slot archive
+	 * @param bCanWriteToSourceFile if true, writing to the source slot file doesn't affect already opened source reader,
+	 * so slot file is written in place instead of a temporary file
+	 * @param bUseBlockStore if true, new state data is written to the block store and slot file only references it.
+	 * Source worlds already stored in the block store are referenced as is, without copying their data
+	 * @return false if slot file was not replaced, slot keeps its previous state in that case
+	 */
+	bool SaveState(const FPersistentStateSlot& SourceSlot,
 		const FPersistentStateSlotSaveRequest& Request,
 		FArchiveFactory CreateReadArchive,
-		FArchiveFactory CreateWriteArchive
+		FArchiveFactory CreateWriteArchive,
+		bool bCanWriteToSourceFile = false,
+		bool bUseBlockStore = false
 	);
 
 	/** @return true if state slot has a game state */
 	bool HasGameState() const;
+
+	/** @return game state header, describes game state data location in the slot file */
+	const FGameStateDataHeader& GetGameHeader() const { return GameHeader; }
+	/** @return world state header for a given world, nullptr if slot doesn't have world state */
+	const FWorldStateDataHeader* FindWorldHeader(FName WorldName) const;
 	
 	/** @return true if state slot has world state for a given world */
 	bool HasWorldState(FName WorldName) const;
+
+	/** decompress raw state data read from the slot file into a state buffer, if compression was enabled. Can be called from any thread */
+	static void DecompressStateData(TArray<uint8>&& Data, TArray<uint8>& OutBuffer);
+
+	/** @return file path that stores state data for a given header, either a slot file or a block file */
+	FString GetStateDataPath(const FStateDataHeader& Header) const;
+	/**
+	 * replace delta in @InOutBuffer with a full state, if header describes delta data. Base state is read from the block store
+	 * @return false if delta can't be applied, buffer is empty in this case
+	 */
+	bool ResolveStateDelta(const FStateDataHeader& Header, TArray<uint8>& InOutBuffer, FArchiveFactory& CreateReadArchive) const;
+	/** add references to blocks used by the slot to @OutRefCounts */
+	void AddBlockReferences(TMap<FString, int32>& OutRefCounts) const;
+	/** @return block store directory for a save game directory */
+	static FString GetBlockStorePath(const FString& SaveGamePath);
 	
 	/**
 	 * Create save request, initialized with proper descriptor information and optional game/world state data
@@ -367,28 +486,62 @@ private:
 	UClass* ResolveDescriptorClass() const;
 	bool IsPhysical() const;
 	
-	/** save new state */
-	void SaveStateToArchive(const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateWriteArchive, TArray<uint8>* PersistentData = nullptr);
+	/** block store references for new game and world state, empty if state data is written to the slot file */
+	struct FStateBlockRefs
+	{
+		FString GameState;
+		FString WorldState;
+		/** base state for a world delta */
+		FString WorldBase;
+		/** world state delta against the base state, written to the slot file instead of world state */
+		TArray<uint8> WorldDelta;
+	};
+	
+	/**
+	 * save new state to a slot file
+	 * @param WritePath file path to write to, may differ from slot file path if slot file is replaced after save completes
+	 * @param SourceReader optional source slot reader, world data for all non-first world headers is streamed from it
+	 * @param BlockRefs new states that are already written to the block store
+	 */
+	void SaveStateToArchive(const FPersistentStateSlotSaveRequest& Request, FArchiveFactory CreateWriteArchive, const FString& WritePath, FArchive* SourceReader = nullptr, const FStateBlockRefs& BlockRefs = {});
+
+	/**
+	 * write state buffer to the block store, unless block with the same content already exists
+	 * @return block hash
+	 */
+	FString WriteStateBlock(const TArray<uint8>& Buffer, FArchiveFactory& CreateReadArchive, FArchiveFactory& CreateWriteArchive) const;
+	/** @return decompressed state stored in the block store, empty if block file is missing */
+	TArray<uint8> ReadStateBlock(const FString& BlockHash, FArchiveFactory& CreateReadArchive) const;
+	/**
+	 * create world state delta against the base state of the same world in @SourceSlot
+	 * @return true if delta fits into delta save threshold
+	 */
+	bool CreateWorldStateDelta(const FPersistentStateSlot& SourceSlot, const FWorldState& WorldState, FArchiveFactory& CreateReadArchive, FStateBlockRefs& OutBlockRefs) const;
 
 	/**
-	 * Read data from an archive into a data buffer, taking into account possible decompression
-	 * If compression was enabled during @WriteCompressed operation data is uncompressed first before being written into a
-	 * buffer
-	 * @param Ar loading archive
-	 * @param DataStart start of the data chunk that should be read into a buffer
-	 * @param DataSize size of data that should be read into a buffer
-	 * @param OutBuffer result
+	 * read state data for a given header as is, without decompression. Slot file reader is opened on demand,
+	 * state data stored in the block store is read from a block file
+	 * @return state data, empty if block file is missing
 	 */
-	static void ReadCompressed(FArchive& Ar, int32 DataStart, int32 DataSize, TArray<uint8>& OutBuffer);
+	TArray<uint8> ReadStateData(const FStateDataHeader& Header, FArchiveFactory& CreateReadArchive, TUniquePtr<FArchive>& SlotReader) const;
+
+	/** read data chunk from an archive as is, without decompression. Result buffer is taken from the buffer pool */
+	static TArray<uint8> ReadStateData(FArchive& Ar, int32 DataStart, int32 DataSize);
 
 	/**
-	 * Write data from the data buffer into an archive with possible compression as an intermediate step
-	 * If compression is enabled (via WITH_STATE_DATA_COMPRESSION) and data is large enough,
-	 * data buffer is compressed into the intermediate storage first before being written to the archive
+	 * Write state buffers into an archive with possible compression as an intermediate step
+	 * If compression is enabled (via WITH_STATE_DATA_COMPRESSION), buffers are compressed in parallel, bounded by save window size.
+	 * Compressed data is written in order, as soon as it is ready
 	 * @param Ar writing archive
-	 * @param Buffer data buffer to write into the archive
+	 * @param Buffers data buffers to write into the archive, paired with data start location to update
 	 */
-	static void WriteCompressed(FArchive& Ar, TArray<uint8>& Buffer);
+	static void WriteCompressed(FArchive& Ar, TConstArrayView<TPair<const TArray<uint8>*, FPersistentStateFixedInteger*>> Buffers);
+
+	/** compress state buffer into a pooled buffer. Can be called from any thread */
+	static TArray<uint8> CompressStateData(const TArray<uint8>& Buffer);
+
+	/** copy world data from the source slot archive, using a bounded intermediate buffer */
+	static void CopyStateData(FArchive& SourceAr, FArchive& Ar, int32 DataStart, int32 DataSize, TArray<uint8>& Window);
 
 	/** match @WorldName to index inside @WorldHeaders array */
 	int32 GetWorldHeaderIndex(FName WorldName) const;
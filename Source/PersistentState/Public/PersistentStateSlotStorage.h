@@ -1,10 +1,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PersistentStateCache.h"
 #include "PersistentStateStorage.h"
 
 #include "PersistentStateSlotStorage.generated.h"
 
+class IAsyncReadFileHandle;
+
 UCLASS()
 class PERSISTENTSTATE_API UPersistentStateSlotStorage: public UPersistentStateStorage
 {
@@ -27,13 +30,15 @@ public:
 	virtual void Shutdown() override;
 	virtual uint32 GetAllocatedSize() const override;
 	virtual void WaitUntilTasksComplete() const override;
-	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate) override;
+	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority = EPersistentStateTaskPriority::InteractiveSave) override;
 	virtual FGraphEventRef LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad, FLoadCompletedDelegate CompletedDelegate) override;
+	virtual FGraphEventRef PrefetchState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldToLoad) override;
 	virtual FGraphEventRef UpdateAvailableStateSlots(FSlotUpdateCompletedDelegate CompletedDelegate) override;
 	virtual void SaveStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle) override;
 	virtual bool LoadStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle, FLoadScreenshotCompletedDelegate CompletedDelegate) override;
 	virtual bool HasScreenshotForStateSlot(const FPersistentStateSlotHandle& TargetSlotHandle) override;
 	virtual FPersistentStateSlotHandle CreateStateSlot(const FName& SlotName, const FText& Title, TSubclassOf<UPersistentStateSlotDescriptor> DescriptorClass) override;
+	virtual FPersistentStateSlotHandle DuplicateStateSlot(const FPersistentStateSlotHandle& SourceSlotHandle, FName SlotName) override;
 	virtual void GetAvailableStateSlots(TArray<FPersistentStateSlotHandle>& OutStates, bool bOnDiskOnly) override;
 	virtual UPersistentStateSlotDescriptor* GetStateSlotDescriptor(const FPersistentStateSlotHandle& SlotHandle) const override;
 	virtual FPersistentStateSlotHandle GetStateSlotByName(FName SlotName) const override;
@@ -45,6 +50,18 @@ protected:
 	void CompleteLoadState_GameThread(FPersistentStateSlotSharedRef TargetSlot, FGameStateSharedRef LoadedGameState, FWorldStateSharedRef LoadedWorldState, FLoadCompletedDelegate CompletedDelegate);
 	void CompleteSlotUpdate_GameThread(const FUpdateAvailableSlotsAsyncTask& Task, FSlotUpdateCompletedDelegate CompletedDelegate);
 
+	/**
+	 * load world state into the state cache in background, if it is not already cached or being prefetched
+	 * @return prefetch task handle, or null if prefetch is not required
+	 */
+	FGraphEventRef PrefetchWorldState(const FPersistentStateSlotSharedRef& TargetSlot, FName World);
+
+	/**
+	 * remove block files that are no longer referenced by any state slot. Reference counts are rebuilt from headers of slot
+	 * files on disk in background, after all previously queued saves are complete
+	 */
+	void CollectUnreferencedBlocks();
+
 	FPersistentStateSlotSharedRef FindSlot(const FPersistentStateSlotHandle& SlotHandle, bool* OutNamedSlot = nullptr) const;
 	FPersistentStateSlotSharedRef FindSlot(FName SlotName, bool* OutNamedSlot = nullptr) const;
 	
@@ -53,7 +70,9 @@ protected:
 		FPersistentStateSlotSharedRef SourceSlot,
 		FPersistentStateSlotSharedRef TargetSlot,
 		const FString& FilePath,
-		TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor
+		TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor,
+		bool bBackgroundSave,
+		bool bUseBlockStore
 	);
 
 	static bool HasStateSlotScreenshotFile(const FPersistentStateSlotSharedRef& Slot);
@@ -67,6 +86,8 @@ protected:
 	
 	static TUniquePtr<FArchive> CreateStateSlotReader(const FString& FilePath);
 	static TUniquePtr<FArchive> CreateStateSlotWriter(const FString& FilePath);
+	/** @return async read handle for a slot file, used to read game and world state without blocking worker threads */
+	static TUniquePtr<IAsyncReadFileHandle> CreateStateSlotAsyncReader(const FString& FilePath);
 
 	/** @return available save game names */
 	static void RemoveStateSlotFile(const FString& FilePath);
@@ -77,7 +98,14 @@ protected:
 
 	/** ensure all running tasks are completed */
 	void EnsureTaskCompletion() const;
-	FGraphEventArray GetPrerequisites() const;
+	/**
+	 * @return prerequisites for a new storage task. Background tasks run after all previously queued tasks, interactive
+	 * tasks run after previous interactive tasks and only wait for background tasks that access the same slots
+	 * @param Slots slots accessed by the task, empty list means that task may access any slot
+	 */
+	FGraphEventArray GetPrerequisites(EPersistentStateTaskPriority Priority, TConstArrayView<FName> Slots);
+	/** add queued storage task, @Event should be the last event of a task chain */
+	void AddQueuedTask(EPersistentStateTaskPriority Priority, TConstArrayView<FName> Slots, const FGraphEventRef& Event);
 
 	/** default descriptor */
 	TSubclassOf<UPersistentStateSlotDescriptor> DefaultDescriptor;
@@ -92,13 +120,36 @@ protected:
 
 	/** cached slot handle, supposedly used by the state subsystem */
 	FPersistentStateSlotHandle CurrentSlot;
-	/** cached world state, supposedly used by the state subsystem */
-	FWorldStateSharedRef CurrentWorldState;
-	/** cached game state, supposedly used by the state subsystem */
-	FGameStateSharedRef CurrentGameState;
+	/** recently used game and world states, keyed by slot and world */
+	FPersistentStateCache StateCache;
+	
+	struct FBackgroundTask
+	{
+		FGraphEventRef Event;
+		/** slots accessed by the task, empty list means that task may access any slot */
+		TArray<FName, TInlineAllocator<2>> Slots;
+		EPersistentStateTaskPriority Priority = EPersistentStateTaskPriority::BackgroundSave;
+	};
 	
-	/** last launched event, emulates a pipe behavior */
-	FGraphEventRef LastQueuedEvent;
+	/** last launched interactive event, emulates a pipe behavior for interactive tasks */
+	FGraphEventRef LastInteractiveEvent;
+	/** last launched background event, emulates a pipe behavior for all tasks */
+	FGraphEventRef LastBackgroundEvent;
+	/** background tasks that may still be in flight */
+	TArray<FBackgroundTask> BackgroundTasks;
+
+	struct FPrefetchRequest
+	{
+		FName Slot;
+		FName World;
+		TSharedPtr<FLoadStateAsyncTask, ESPMode::ThreadSafe> Task;
+		/** prefetch task event, completed after world state is read */
+		FGraphEventRef Event;
+		/** state cache invalidation count at the moment prefetch was requested */
+		uint32 InvalidationCount = 0;
+	};
+	/** prefetch requests in flight, a load of the same world takes over the prefetched state instead of reading it again */
+	TArray<FPrefetchRequest> PrefetchRequests;
 
 	/** OnViewportRendered delegate handle */
 	FDelegateHandle CaptureScreenshotHandle;
@@ -42,10 +42,10 @@ namespace UE::PersistentState
 	/** sanitize object reference, editor only */
 	void SanitizeReference(const UObject& SourceObject, const UObject* ReferenceObject);
 	
-	/** */
-	FWorldStateSharedRef CreateWorldState(const FString& World, const FString& WorldPackage, TConstArrayView<UPersistentStateManager*> Managers);
-	/** */
-	FGameStateSharedRef CreateGameState(TConstArrayView<UPersistentStateManager*> Managers);
+	/** create world state. If @SizeEstimate is provided, state buffer is reserved up front and estimate is updated with new sizes */
+	FWorldStateSharedRef CreateWorldState(const FString& World, const FString& WorldPackage, TConstArrayView<UPersistentStateManager*> Managers, FPersistentStateSizeEstimate* SizeEstimate = nullptr);
+	/** create game state. If @SizeEstimate is provided, state buffer is reserved up front and estimate is updated with new sizes */
+	FGameStateSharedRef CreateGameState(TConstArrayView<UPersistentStateManager*> Managers, FPersistentStateSizeEstimate* SizeEstimate = nullptr);
 	/** */
 	void LoadGameState(TConstArrayView<UPersistentStateManager*> Managers, const FGameStateSharedRef& GameState);
 	/** */
@@ -55,14 +55,22 @@ namespace UE::PersistentState
 	PERSISTENTSTATE_API void LoadObject(UObject& Object, const FPersistentStatePropertyBunch& PropertyBunch, bool bIsSaveGame = true);
 	/** load object SaveGame property values, convert indexes to top-level asset dependencies via @DependencyTracker */
 	PERSISTENTSTATE_API void LoadObject(UObject& Object, const FPersistentStatePropertyBunch& PropertyBunch, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame = true);
+	/** load object SaveGame property values from raw bunch data, convert indexes to top-level asset dependencies via @DependencyTracker */
+	PERSISTENTSTATE_API void LoadObject(UObject& Object, TConstArrayView<uint8> PropertyData, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame = true);
 	/** save object SaveGame property values */
 	PERSISTENTSTATE_API void SaveObject(UObject& Object, FPersistentStatePropertyBunch& PropertyBunch, bool bIsSaveGame = true);
     /** save object SaveGame property values, converts top-level asset dependencies to indexes via @DependencyTracker */
     PERSISTENTSTATE_API void SaveObject(UObject& Object, FPersistentStatePropertyBunch& PropertyBunch, FPersistentStateObjectTracker& DependencyTracker, bool bIsSaveGame = true);
+	/**
+	 * save object SaveGame property values as a delta against @BaselineBunch, previously saved for the same object.
+	 * Only properties that differ from the baseline are written, @PropertyBunch is left empty if object matches the baseline.
+	 * Bunch can be loaded only on top of the object state that matches the baseline.
+	 */
+	PERSISTENTSTATE_API void SaveObject(UObject& Object, FPersistentStatePropertyBunch& PropertyBunch, FPersistentStateObjectTracker& DependencyTracker, const FPersistentStatePropertyBunch& BaselineBunch);
 
 namespace Private
 {
-	void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32 ChunkCount, uint32 ObjectTablePosition, uint32 StringTablePosition);
-	void SaveManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32& OutObjectTablePosition, uint32& OutStringTablePosition);
+	void LoadManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32 ChunkCount, uint32 ObjectTablePosition, uint32 StringTablePosition, uint32 SchemaTablePosition);
+	void SaveManagerState(FArchive& Ar, TConstArrayView<UPersistentStateManager*> Managers, uint32& OutObjectTablePosition, uint32& OutStringTablePosition, uint32& OutSchemaTablePosition, FPersistentStateSizeEstimate* SizeEstimate = nullptr);
 } // Private
 } // UE::PersistentState
\ No newline at end of file
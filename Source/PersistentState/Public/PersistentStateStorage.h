@@ -3,6 +3,7 @@
 #include "CoreMinimal.h"
 #include "PersistentStateSlot.h"
 #include "PersistentStateSlotView.h"
+#include "PersistentStateStorageScheduler.h"
 
 #include "PersistentStateStorage.generated.h"
 
@@ -47,9 +48,10 @@ public:
 	 * @param SourceSlotHandle reference slot that provides data for other worlds
 	 * @param TargetSlotHandle target slot to save world data to
 	 * @param CompletedDelegate triggered after operation is complete
+	 * @param Priority save priority class, background saves yield to interactive loads and saves
 	 * @return task handle, may be completed on return. Task can be forced to completion via its handle
 	 */
-	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate)
+	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority = EPersistentStateTaskPriority::InteractiveSave)
 	PURE_VIRTUAL(UPersistentStateStorage::SaveWorldState, return {};)
 
 	/**
@@ -64,6 +66,18 @@ public:
 	virtual FGraphEventRef LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldName, FLoadCompletedDelegate CompletedDelegate)
 	PURE_VIRTUAL(UPersistentStateStorage::LoadWorldState, return {};)
 
+	/**
+	 * Prefetch world state stored inside @TargetSlotHandle ahead of a travel, so that a following @LoadState for the same
+	 * world doesn't wait for disk reads and decompression. Prefetch is a hint, storage may ignore it.
+	 * @param TargetSlotHandle target slot to get world data from
+	 * @param WorldName world to prefetch
+	 * @return task handle, may be completed on return. Null if prefetch request was ignored
+	 */
+	virtual FGraphEventRef PrefetchState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldName)
+	{
+		return {};
+	}
+
 	/**
 	 * Launch an update slots task that searches for valid state slot files, results in an up-to-date state about
 	 * what state slots are available on background storage and their details
@@ -91,6 +105,14 @@ public:
 	virtual FPersistentStateSlotHandle CreateStateSlot(const FName& SlotName, const FText& Title, TSubclassOf<UPersistentStateSlotDescriptor> DescriptorClass)
 	PURE_VIRTUAL(UPersistentStateStorage::CreateStateSlot, return {};)
 
+	/**
+	 * create a new state slot @SlotName that shares saved state with @SourceSlotHandle, and @return the handle.
+	 * State data is not copied where storage can share it, slots diverge on the next save to either of them.
+	 * Slot is removed and handle is no longer valid if saved state can't be copied
+	 */
+	virtual FPersistentStateSlotHandle DuplicateStateSlot(const FPersistentStateSlotHandle& SourceSlotHandle, FName SlotName)
+	PURE_VIRTUAL(UPersistentStateStorage::DuplicateStateSlot, return {};)
+
 	/** delete slot data from the device storage and remove state slot itself, unless it is a persistent slot */
 	virtual void RemoveStateSlot(const FPersistentStateSlotHandle& SlotHandle)
 	PURE_VIRTUAL(UPersistentStateStorage::RemoveStateSlot, );
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#include <atomic>
+
+/** storage task priority classes, in order of decreasing priority */
+enum class EPersistentStateTaskPriority: uint8
+{
+	/** load requested by the player, preempts background tasks */
+	InteractiveLoad,
+	/** save requested by the player */
+	InteractiveSave,
+	/** save that player doesn't wait for (e.g. autosave). Yields to interactive tasks and is bandwidth throttled */
+	BackgroundSave,
+	/** load that player doesn't wait for (e.g. state cache prefetch) */
+	BackgroundLoad,
+	/** state slot scan */
+	SlotScan,
+};
+
+/**
+ * Storage Task Scheduler
+ * Dispatches storage tasks to the task graph based on their priority class. Background tasks yield to running
+ * interactive tasks between data blocks and may throttle their disk bandwidth, so that player initiated loads and
+ * streaming IO are not delayed by a large autosave in flight.
+ */
+class PERSISTENTSTATE_API FPersistentStateStorageScheduler
+{
+public:
+	FORCEINLINE static FPersistentStateStorageScheduler& Get()
+	{
+		return Instance;
+	}
+
+	/** create scheduler resources, called on module startup */
+	void Initialize();
+	/** release scheduler resources and wake up waiting background tasks, called on module shutdown */
+	void Shutdown();
+
+	/** @return true if tasks of a given priority class run in background */
+	FORCEINLINE static bool IsBackground(EPersistentStateTaskPriority Priority)
+	{
+		return Priority >= EPersistentStateTaskPriority::BackgroundSave;
+	}
+
+	/**
+	 * Dispatch storage task after prerequisites are completed
+	 * @param Task task body, receives task completion event that can be extended via DontCompleteUntil
+	 * @return task completion event
+	 */
+	FGraphEventRef Dispatch(EPersistentStateTaskPriority Priority, TUniqueFunction<void(const FGraphEventRef&)>&& Task, const FGraphEventArray& Prerequisites);
+
+	/**
+	 * Called by background tasks between data blocks. Blocks on an event until running interactive tasks are completed,
+	 * then throttles the calling task to a configured background bandwidth
+	 * @param NumBytes number of bytes read or written since the last call
+	 */
+	void YieldBackgroundTask(int64 NumBytes);
+
+	/** @return number of currently running interactive tasks */
+	int32 GetNumActiveInteractiveTasks() const { return NumActiveInteractiveTasks.load(std::memory_order_relaxed); }
+
+private:
+	static ENamedThreads::Type GetThreadType(EPersistentStateTaskPriority Priority);
+
+	void BeginInteractiveTask();
+	void EndInteractiveTask();
+	
+	static FPersistentStateStorageScheduler Instance;
+
+	/** number of interactive tasks that are running or waiting for their subsequent work (e.g. async reads) */
+	std::atomic<int32> NumActiveInteractiveTasks{0};
+	/** guards interactive task count transitions to and from zero, so that idle event state matches the count */
+	FCriticalSection InteractiveCriticalSection;
+	/** manual reset event, triggered while no interactive tasks are running */
+	FEvent* InteractiveIdleEvent = nullptr;
+
+	FCriticalSection ThrottleCriticalSection;
+	/** start of the current throttle window */
+	double ThrottleWindowStart = 0.0;
+	/** number of background bytes processed during current throttle window */
+	int64 ThrottleWindowBytes = 0;
+};
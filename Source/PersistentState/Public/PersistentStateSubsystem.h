@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PersistentStateBuffers.h"
 #include "PersistentStateStorage.h"
 #include "Managers/PersistentStateManager.h"
 #include "Subsystems/GameInstanceSubsystem.h"
@@ -18,6 +19,8 @@ DECLARE_MULTICAST_DELEGATE_OneParam(FStateChangeDelegate, const FPersistentState
 struct FSaveGamePendingRequest
 {
 	FPersistentStateSlotHandle TargetSlot;
+	/** if true, save is scheduled as a background task that yields to player initiated loads and saves */
+	bool bBackgroundSave = false;
 };
 
 struct FLoadGamePendingRequest
@@ -106,6 +109,15 @@ public:
 	 */
 	bool LoadGameWorldFromSlot(const FPersistentStateSlotHandle& TargetSlot, TSoftObjectPtr<UWorld> World, FString TravelOptions = FString(TEXT("")));
 
+	/**
+	 * Prefetch @World state from the active slot ahead of travel, so that the following travel to @World uses already
+	 * decompressed world state instead of reading it while the map is being loaded.
+	 * Prefetch is also requested automatically for pending and seamless travel, @see PersistentState.AutoPrefetch
+	 * @return true if prefetch was started
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Persistent State")
+	bool PrefetchWorldState(TSoftObjectPtr<UWorld> World);
+
 	/**
 	 * Load screenshot from a provided slot
 	 * @param TargetSlot slot to load a screenshot from
@@ -117,11 +129,15 @@ public:
 	/**
 	 * Save game state to the current slot
 	 * Does nothing if active slot has not been established. To create a new save, call @CreateSaveGameSlot first
+	 * @param bBackgroundSave if true, save yields to player initiated loads and saves (e.g. autosave)
 	 */
-	bool SaveGame();
+	bool SaveGame(bool bBackgroundSave = false);
 
-	/** Save game state to the specified target slot. @ActiveSlot is automatically updated to a @TargetSlot value if save is successful */
-	bool SaveGameToSlot(const FPersistentStateSlotHandle& TargetSlot);
+	/**
+	 * Save game state to the specified target slot. @ActiveSlot is automatically updated to a @TargetSlot value if save is successful
+	 * @param bBackgroundSave if true, save yields to player initiated loads and saves (e.g. autosave)
+	 */
+	bool SaveGameToSlot(const FPersistentStateSlotHandle& TargetSlot, bool bBackgroundSave = false);
 
 	/** update a list of save game slots */
 	void UpdateSaveGameSlots(FSlotUpdateCompletedDelegate OnUpdateCompleted);
@@ -147,6 +163,13 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Persistent State")
 	FPersistentStateSlotHandle CreateSaveGameSlot(FName SlotName, const FText& SlotTitle, TSubclassOf<UPersistentStateSlotDescriptor> DescriptorClass = nullptr);
 
+	/**
+	 * Create a new save game slot @SlotName with a copy of @Slot saved state, without loading and saving it again.
+	 * @return new slot handle, or invalid handle if @Slot doesn't have saved state or @SlotName already exists
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Persistent State")
+	FPersistentStateSlotHandle DuplicateSaveGameSlot(const FPersistentStateSlotHandle& Slot, FName SlotName);
+
 	/** @return state slot identified by @SlotName */
 	UFUNCTION(BlueprintCallable, Category = "Persistent State")
 	FPersistentStateSlotHandle FindSaveGameSlotByName(FName SlotName) const;
@@ -208,6 +231,7 @@ protected:
 	void OnWorldInitActors(const FActorsInitializedParams& Params);
 	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
 	void OnWorldSeamlessTravel(UWorld* World);
+	void OnSeamlessTravelStart(UWorld* World, const FString& LevelName);
 #if WITH_EDITOR
 	void OnEndPlay(const bool bSimulating);
 #endif
@@ -216,6 +240,10 @@ protected:
 	void OnLoadStateCompleted(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, TSharedPtr<FLoadGamePendingRequest> LoadRequest);
 
 	void CreateAutoLoadRequest(FName MapName, bool bInitialLoad);
+	/** prefetch world state from the active slot, @return true if prefetch was started */
+	bool RequestWorldPrefetch(FName WorldName);
+	/** prefetch world state for a travel that is going to happen on the next frame */
+	void PrefetchPendingTravel();
 	void ProcessSaveRequests();
 	void UpdateStats() const;
 
@@ -238,8 +266,12 @@ protected:
 	/** flags that describe a set of managers that can be created by subsystem. Initialized once during startup */
 	EManagerStorageType CachedCanCreateManagerState = EManagerStorageType::None;
 
+	/** rolling size estimate of game and world states, used to reserve state buffers before save */
+	FPersistentStateSizeEstimate StateSizeEstimate;
 	/** current slot, either fully loaded or in progress (@see ActiveLoadRequest) */
 	FPersistentStateSlotHandle ActiveSlot;
+	/** last pending travel URL world state was prefetched for */
+	FString PrefetchTravelURL;
 	/** subsystem is initialized */
 	uint8 bInitialized : 1 = false;
 };
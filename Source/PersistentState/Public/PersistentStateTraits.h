@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Persistent state traits for native classes.
+ * Specialize traits for a class to provide hand-written state serialization, that bypasses reflection-based
+ * SaveGame property serialization. Fast serializer is called before SaveGame properties are serialized,
+ * so native state handled by SerializeState should not be marked as SaveGame.
+ *
+ * template <>
+ * struct TPersistentStateTraits<AMyDoor>
+ * {
+ *		enum { WithFastSerializer = true };
+ * };
+ *
+ * void AMyDoor::SerializeState(FArchive& Ar)
+ * {
+ *		Ar << bOpened;
+ *		Ar << OpenAngle;
+ * }
+ *
+ * Fast serializer has to be registered once in a source file:
+ * UE_PERSISTENT_STATE_FAST_SERIALIZER(AMyDoor);
+ */
+template <typename T>
+struct TPersistentStateTraits
+{
+	enum
+	{
+		/** class provides void SerializeState(FArchive& Ar) */
+		WithFastSerializer = false,
+	};
+};
+
+using FPersistentStateFastSerializeFunc = void(*)(UObject&, FArchive&);
+
+/**
+ * Fast Serializer Registry
+ * Maps native classes to their fast serializers. Fast serializer is also used by classes derived from the registered class
+ */
+class PERSISTENTSTATE_API FPersistentStateFastSerializerRegistry
+{
+public:
+	using FStaticClassFunc = UClass*(*)();
+
+	/** register fast serializer for a class, can be called during static initialization */
+	static void Register(FStaticClassFunc StaticClass, FPersistentStateFastSerializeFunc SerializeFunc);
+
+	/** @return fast serializer for a given class or its closest registered super class, nullptr if class doesn't have one. Result is cached per class */
+	static FPersistentStateFastSerializeFunc Find(const UClass* Class);
+};
+
+namespace UE::PersistentState
+{
+	template <typename T>
+	void FastSerializeState(UObject& Object, FArchive& Ar) requires (TPersistentStateTraits<T>::WithFastSerializer)
+	{
+		static_cast<T&>(Object).SerializeState(Ar);
+	}
+
+	template <typename T>
+	struct TFastSerializerRegistration
+	{
+		static_assert(TPersistentStateTraits<T>::WithFastSerializer, "TPersistentStateTraits<T>::WithFastSerializer should be specialized to register fast serializer.");
+
+		TFastSerializerRegistration()
+		{
+			FPersistentStateFastSerializerRegistry::Register(&T::StaticClass, &FastSerializeState<T>);
+		}
+	};
+}
+
+/** registers fast serializer for a native class with specialized TPersistentStateTraits */
+#define UE_PERSISTENT_STATE_FAST_SERIALIZER(ClassName) \
+	static const UE::PersistentState::TFastSerializerRegistration<ClassName> PREPROCESSOR_JOIN(GPersistentStateFastSerializer_, ClassName){};
@@ -0,0 +1,223 @@
+#include "PersistentStateArchive.h"
+#include "PersistentStateSchema.h"
+#include "PersistentStateSerialization.h"
+#include "PersistentStateStatics.h"
+#include "PersistentStateTestClasses.h"
+
+using namespace UE::PersistentState;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_FastSerializer, "PersistentState.FastSerializer", AutomationFlags)
+
+bool FPersistentStateTest_FastSerializer::RunTest(const FString& Parameters)
+{
+	UPersistentStateFastStateTestObject* Source = NewObject<UPersistentStateFastStateTestObject>();
+	Source->FastInt = 42;
+	Source->FastString = TEXT("FastState");
+	Source->StoredInt = 7;
+	Source->StoredString = TEXT("SaveGame");
+
+	FPersistentStatePropertyBunch Bunch{};
+	SaveObject(*Source, Bunch);
+	UTEST_TRUE("Bunch is saved", !Bunch.IsEmpty());
+	UTEST_TRUE("Bunch stores fast state", EnumHasAnyFlags(static_cast<EPersistentStateBunchFormat>(Bunch.Value[0]), EPersistentStateBunchFormat::FastState));
+
+	UPersistentStateFastStateTestObject* Target = NewObject<UPersistentStateFastStateTestObject>();
+	LoadObject(*Target, Bunch);
+	UTEST_TRUE("Fast state is restored", Target->FastInt == Source->FastInt && Target->FastString == Source->FastString);
+	UTEST_TRUE("SaveGame properties are restored", Target->StoredInt == Source->StoredInt && Target->StoredString == Source->StoredString);
+
+	// class without a fast serializer skips fast state by its size and still restores SaveGame properties
+	AddExpectedError(TEXT("Fast state is skipped."), EAutomationExpectedErrorFlags::MatchType::Contains, 1);
+	UPersistentStateSaveGameTestObject* Fallback = NewObject<UPersistentStateSaveGameTestObject>();
+	LoadObject(*Fallback, Bunch);
+	UTEST_TRUE("SaveGame properties are restored without fast serializer", Fallback->StoredInt == Source->StoredInt && Fallback->StoredString == Source->StoredString);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_SchemaSerialization, "PersistentState.Schema.RoundTrip", AutomationFlags)
+
+bool FPersistentStateTest_SchemaSerialization::RunTest(const FString& Parameters)
+{
+	UPersistentStateSaveGameTestObject* Source = NewObject<UPersistentStateSaveGameTestObject>();
+	Source->StoredInt = 42;
+	Source->StoredString = TEXT("Schema");
+
+	FPersistentStatePropertyBunch Bunch{};
+	SaveObject(*Source, Bunch);
+	UTEST_TRUE("Bunch is saved", !Bunch.IsEmpty());
+	UTEST_TRUE("Bunch uses schema format", static_cast<EPersistentStateBunchFormat>(Bunch.Value[0]) == EPersistentStateBunchFormat::Schema);
+
+	const FPersistentStateRuntimeSchema& RuntimeSchema = FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Source->GetClass());
+	UTEST_TRUE("Runtime schema is valid", RuntimeSchema.IsValid());
+	UTEST_TRUE("Bunch references class schema", GetBunchSchemaHash(Bunch.Value) == RuntimeSchema.Hash);
+	UTEST_TRUE("Class schema is registered", FPersistentStateSchemaRegistry::Get().FindSchema(RuntimeSchema.Hash) != nullptr);
+
+	UPersistentStateSaveGameTestObject* Target = NewObject<UPersistentStateSaveGameTestObject>();
+	LoadObject(*Target, Bunch);
+	UTEST_TRUE("SaveGame properties are restored", Target->StoredInt == Source->StoredInt && Target->StoredString == Source->StoredString);
+
+	// object that matches its archetype doesn't store schema reference
+	FPersistentStatePropertyBunch DefaultBunch{};
+	SaveObject(*NewObject<UPersistentStateSaveGameTestObject>(), DefaultBunch);
+	UTEST_TRUE("Default object bunch doesn't reference schema", GetBunchSchemaHash(DefaultBunch.Value) == 0);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_SchemaMismatch, "PersistentState.Schema.Mismatch", AutomationFlags)
+
+bool FPersistentStateTest_SchemaMismatch::RunTest(const FString& Parameters)
+{
+	// save object with the original layout and load it to the class with a changed layout, which mimics schema
+	// that changed between save and load
+	UPersistentStateSaveGameTestObject* Source = NewObject<UPersistentStateSaveGameTestObject>();
+	Source->StoredInt = 42;
+	Source->StoredString = TEXT("Schema");
+
+	FPersistentStatePropertyBunch Bunch{};
+	SaveObject(*Source, Bunch);
+
+	UPersistentStateChangedSchemaTestObject* Target = NewObject<UPersistentStateChangedSchemaTestObject>();
+	UTEST_TRUE("Schemas are different", GetBunchSchemaHash(Bunch.Value) != FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Target->GetClass()).Hash);
+	
+	LoadObject(*Target, Bunch);
+	UTEST_TRUE("Matching property is restored", Target->StoredInt == Source->StoredInt);
+	UTEST_TRUE("Property with a changed type is skipped", Target->StoredString == NAME_None);
+	UTEST_TRUE("Added property keeps default value", Target->AddedFloat == 0.f);
+
+	// load bunch that stores the changed layout into the original class
+	Target->AddedFloat = 1.f;
+	Target->StoredInt = 7;
+	Target->StoredString = TEXT("Changed");
+
+	FPersistentStatePropertyBunch ChangedBunch{};
+	SaveObject(*Target, ChangedBunch);
+
+	UPersistentStateSaveGameTestObject* Original = NewObject<UPersistentStateSaveGameTestObject>();
+	LoadObject(*Original, ChangedBunch);
+	UTEST_TRUE("Matching property is restored", Original->StoredInt == Target->StoredInt);
+	UTEST_TRUE("Property with a changed type is skipped", Original->StoredString.IsEmpty());
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_SchemaTable, "PersistentState.Schema.Table", AutomationFlags)
+
+bool FPersistentStateTest_SchemaTable::RunTest(const FString& Parameters)
+{
+	UPersistentStateSaveGameTestObject* Source = NewObject<UPersistentStateSaveGameTestObject>();
+	Source->StoredInt = 42;
+
+	// register schema that is never referenced by the saved state
+	UPersistentStateChangedSchemaTestObject* Unreferenced = NewObject<UPersistentStateChangedSchemaTestObject>();
+	UTEST_TRUE("Schema is registered", FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Unreferenced->GetClass()).IsValid());
+
+	FPersistentStatePropertyBunch Bunch{};
+	SaveObject(*Source, Bunch);
+	const uint64 SchemaHash = GetBunchSchemaHash(Bunch.Value);
+
+	TArray<uint8> Data;
+	FPersistentStateMemoryWriter Writer{Data};
+	
+	FPersistentStateSchemaReferenceScope SchemaReferences{};
+	// bunch reports its schema when serialized
+	FPersistentStatePropertyBunch::StaticStruct()->SerializeItem(Writer, &Bunch, nullptr);
+	UTEST_TRUE("Scope stores only referenced schema", SchemaReferences.Schemas.Num() == 1 && SchemaReferences.Schemas.Contains(SchemaHash));
+
+	const int32 SchemaTablePosition = Writer.Tell();
+	FPersistentStateSchemaRegistry::Get().WriteSchemaTable(Writer, SchemaReferences.Schemas);
+
+	FPersistentStateMemoryReader Reader{Data};
+	Reader.Seek(SchemaTablePosition);
+
+	int32 NumSchemas = 0;
+	Reader << NumSchemas;
+	UTEST_TRUE("Schema table stores only referenced schemas", NumSchemas == 1);
+
+	FPersistentStateClassSchema Schema{};
+	Reader << Schema;
+	UTEST_TRUE("Schema table stores referenced schema", Schema.Hash == SchemaHash && Schema.CalculateHash() == SchemaHash);
+
+	// reading schema table that matches registered schemas doesn't change archive position
+	Reader.Seek(0);
+	FPersistentStateSchemaRegistry::Get().ReadSchemaTable(Reader, SchemaTablePosition);
+	UTEST_TRUE("Reader position is restored", Reader.Tell() == 0);
+	UTEST_TRUE("Schema is registered", FPersistentStateSchemaRegistry::Get().FindSchema(SchemaHash) != nullptr);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_SchemaCollision, "PersistentState.Schema.Collision", AutomationFlags)
+
+bool FPersistentStateTest_SchemaCollision::RunTest(const FString& Parameters)
+{
+	UPersistentStateSaveGameTestObject* Source = NewObject<UPersistentStateSaveGameTestObject>();
+	Source->StoredInt = 42;
+
+	FPersistentStatePropertyBunch Bunch{};
+	SaveObject(*Source, Bunch);
+	const uint64 SchemaHash = GetBunchSchemaHash(Bunch.Value);
+	const FPersistentStateClassSchema* RegisteredSchema = FPersistentStateSchemaRegistry::Get().FindSchema(SchemaHash);
+	UTEST_NOT_NULL("Schema is registered", RegisteredSchema);
+	const FString ClassPath = RegisteredSchema->ClassPath;
+
+	// schema table with a different schema that shares the registered hash
+	FPersistentStateClassSchema CollidingSchema{};
+	CollidingSchema.ClassPath = TEXT("/Script/PersistentStateTestSuite.CollidingSchema");
+	CollidingSchema.Hash = SchemaHash;
+
+	TArray<uint8> Data;
+	FPersistentStateMemoryWriter Writer{Data};
+	int32 NumSchemas = 1;
+	Writer << NumSchemas;
+	Writer << CollidingSchema;
+
+	AddExpectedError(TEXT("schema hash collision"), EAutomationExpectedErrorFlags::MatchType::Contains, 1);
+	FPersistentStateMemoryReader Reader{Data};
+	FPersistentStateSchemaRegistry::Get().ReadSchemaTable(Reader, 0);
+
+	RegisteredSchema = FPersistentStateSchemaRegistry::Get().FindSchema(SchemaHash);
+	UTEST_TRUE("Registered schema keeps its hash", RegisteredSchema != nullptr && RegisteredSchema->ClassPath == ClassPath);
+	UTEST_TRUE("Runtime schema stays valid", FPersistentStateSchemaRegistry::Get().GetRuntimeSchema(Source->GetClass()).Hash == SchemaHash);
+
+	UPersistentStateSaveGameTestObject* Target = NewObject<UPersistentStateSaveGameTestObject>();
+	LoadObject(*Target, Bunch);
+	UTEST_TRUE("Bunch written before collision is loaded", Target->StoredInt == Source->StoredInt);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_ObjectTracker, "PersistentState.ObjectTracker", AutomationFlags)
+
+bool FPersistentStateTest_ObjectTracker::RunTest(const FString& Parameters)
+{
+	const FSoftObjectPath FirstPath{UPersistentStateSaveGameTestObject::StaticClass()};
+	const FSoftObjectPath SecondPath{UPersistentStateFastStateTestObject::StaticClass()};
+	
+	FPersistentStateObjectTracker Tracker{};
+	TArray<int32> References;
+	{
+		FPersistentStateObjectTracker::FCollectReferencesScope Scope{Tracker, References};
+		Tracker.SaveValue(FirstPath);
+		Tracker.SaveValue(SecondPath);
+		Tracker.SaveValue(FirstPath);
+	}
+	UTEST_TRUE("Referenced indices are unique", References == TArray<int32>{1, 2});
+
+	// released value is an empty path until its index is reused
+	Tracker.ReleaseValue(1);
+	UTEST_TRUE("Released value is not tracked", Tracker.FindValue(FirstPath) == 0);
+	UTEST_TRUE("Released value is empty", Tracker.LoadValue(1).IsNull());
+	UTEST_TRUE("Other values keep their indices", Tracker.FindValue(SecondPath) == 2);
+	UTEST_TRUE("Released index is reused", Tracker.SaveValue(FirstPath) == 1 && Tracker.NumValues() == 2);
+
+	// value map and released indices are rebuilt for serialized values
+	Tracker.ReleaseValue(2);
+	FPersistentStateObjectTracker LoadedTracker{};
+	LoadedTracker.Values = Tracker.Values;
+	UTEST_TRUE("Loaded tracker skips released values", LoadedTracker.FindValue(FirstPath) == 1 && LoadedTracker.FindValue(SecondPath) == 0);
+	UTEST_TRUE("Loaded tracker reuses released index", LoadedTracker.SaveValue(SecondPath) == 2 && LoadedTracker.NumValues() == 2);
+
+	return !HasAnyErrors();
+}
@@ -1,9 +1,13 @@
 
 #include "AutomationWorld.h"
+#include "PersistentStateBuffers.h"
+#include "PersistentStateCache.h"
+#include "PersistentStateMemoryStorage.h"
 #include "PersistentStateSerialization.h"
 #include "PersistentStateTestClasses.h"
 #include "PersistentStateSettings.h"
 #include "PersistentStateStatics.h"
+#include "PersistentStateStorageScheduler.h"
 #include "PersistentStateSubsystem.h"
 
 using namespace UE::PersistentState;
@@ -72,6 +76,46 @@ public:
 		ScopedWorld.Reset();
 	}
 
+	/** @return world state for @WorldName, which stores @Size bytes of @Value */
+	static FWorldStateSharedRef CreateWorldState(FName WorldName, int32 Size = 0, uint8 Value = 0)
+	{
+		TArray<uint8> Buffer;
+		Buffer.Init(Value, Size);
+		
+		return CreateWorldState(WorldName, Buffer);
+	}
+
+	/** @return world state for @WorldName, which stores @Buffer */
+	static FWorldStateSharedRef CreateWorldState(FName WorldName, const TArray<uint8>& Buffer)
+	{
+		FWorldStateSharedRef WorldState = MakeShared<FWorldState>(FWorldState::CreateSaveState());
+		WorldState->Header.World = WorldName.ToString();
+		WorldState->Header.WorldPackage = TEXT("/Temp");
+		WorldState->Buffer = Buffer;
+		WorldState->Header.DataSize = WorldState->Buffer.Num();
+		
+		return WorldState;
+	}
+
+	/** @return load delegate that stores loaded states to @OutGameState and @OutWorldState */
+	static FLoadCompletedDelegate CreateLoadDelegate(FGameStateSharedRef& OutGameState, FWorldStateSharedRef& OutWorldState)
+	{
+		return FLoadCompletedDelegate::CreateLambda([&OutGameState, &OutWorldState](FGameStateSharedRef InGameState, FWorldStateSharedRef InWorldState)
+		{
+			OutGameState = InGameState;
+			OutWorldState = InWorldState;
+		});
+	}
+
+	/** @return number of blocks in the block store */
+	static int32 GetNumBlocks()
+	{
+		TArray<FString> Files;
+		const FString BlockStorePath = FPersistentStateSlot::GetBlockStorePath(UPersistentStateSettings::Get()->GetSaveGamePath());
+		IFileManager::Get().FindFiles(Files, *(BlockStorePath / TEXT("*.blk")), true, false);
+		return Files.Num();
+	}
+
 protected:
 	UPersistentStateSettings* OriginalSettings = nullptr;
 	UPersistentStateSlotMockStorage* Storage = nullptr;
@@ -169,6 +213,111 @@ bool FPersistentStateTest_StateSlotSerialization::RunTest(const FString& Paramet
 	UTEST_TRUE("Serialize Structured: text,		delta", SerializeSlotStructured(false, true));
 	UTEST_TRUE("Serialize Structured: binary,	delta", SerializeSlotStructured(true, true));
 
+	// direct record has to produce the same output as a structured archive with binary formatter
+	auto WriteSlot = [StateSlot]<typename RecordType>(TArray<uint8>& Buffer)
+	{
+		FPersistentStateMemoryWriter Writer{Buffer, true};
+		Writer.SetWantBinaryPropertySerialization(true);
+
+		FPersistentStateSaveGameArchive SaveGameArchive{Writer};
+		RecordType RootRecord{SaveGameArchive};
+
+		FPersistentStateFixedInteger HeaderTag{SLOT_HEADER_TAG};
+		RootRecord.Serialize(TEXT("FileHeaderTag"), HeaderTag);
+		RootRecord.SerializeStruct(TEXT("StateSlot"), FPersistentStateSlot::StaticStruct(), StateSlot.Get());
+	};
+
+	TArray<uint8> DirectBuffer, StructuredBuffer;
+	WriteSlot.operator()<TPersistentStateRecord<false>>(DirectBuffer);
+#if WITH_TEXT_ARCHIVE_SUPPORT
+	if (TPersistentStateFormatter<true>::IsReleaseFormatter())
+	{
+		WriteSlot.operator()<TPersistentStateRecord<true>>(StructuredBuffer);
+		UTEST_TRUE("Direct record matches structured binary record", DirectBuffer == StructuredBuffer);
+	}
+#endif
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_StateArchive, "PersistentState.StateArchive", AutomationFlags)
+
+bool FPersistentStateTest_StateArchive::RunTest(const FString& Parameters)
+{
+	constexpr int32 NumReferences = 256;
+	TArray<FName> Names;
+	for (int32 Index = 0; Index < 64; ++Index)
+	{
+		Names.Add(FName{TEXT("TestName"), Index});
+	}
+	UObject* TopLevelAsset = UPersistentStateTestObject::StaticClass();
+	FSoftObjectPath SoftPath{UPersistentStateTestObject_NoInterface::StaticClass()};
+
+	auto WriteReferences = [&](FArchive& Ar)
+	{
+		for (int32 Index = 0; Index < NumReferences; ++Index)
+		{
+			FName Name = Names[Index % Names.Num()];
+			Ar << Name;
+			Ar << TopLevelAsset;
+			Ar << SoftPath;
+		}
+	};
+
+	constexpr bool bLoading = false;
+	constexpr ESerializeObjectDependency DependencyMode = ESerializeObjectDependency::All;
+
+	// proxy chain, used before state archive was introduced
+	TArray<uint8> ChainBuffer;
+	{
+		FPersistentStateMemoryWriter Writer{ChainBuffer, true};
+		FPersistentStateProxyArchive ProxyArchive{Writer};
+		FPersistentStateStringTrackerProxy<bLoading> StringProxy{ProxyArchive};
+		FPersistentStateObjectTracker ObjectTracker{};
+		FPersistentStateObjectTrackerProxy<bLoading, DependencyMode> ObjectProxy{StringProxy, ObjectTracker};
+
+		WriteReferences(ObjectProxy);
+		ObjectProxy.WriteToArchive(StringProxy);
+		StringProxy.WriteToArchive(ProxyArchive);
+	}
+
+	TArray<uint8> StateBuffer;
+	uint32 ObjectTablePosition = 0, StringTablePosition = 0;
+	{
+		FPersistentStateMemoryWriter Writer{StateBuffer, true};
+		FPersistentStateObjectTracker ObjectTracker{};
+		FPersistentStateStateArchive<bLoading, DependencyMode> StateArchive{Writer, ObjectTracker};
+
+		WriteReferences(StateArchive);
+		StateArchive.WriteTables(ObjectTablePosition, StringTablePosition);
+	}
+
+	UTEST_TRUE("State archive matches proxy chain", StateBuffer == ChainBuffer);
+
+	// load round trip, references are restored from tables read by the state archive
+	{
+		FPersistentStateMemoryReader Reader{StateBuffer, true};
+		FPersistentStateObjectTracker ObjectTracker{};
+		FPersistentStateStateArchive<true, DependencyMode> StateArchive{Reader, ObjectTracker};
+		StateArchive.ReadTables(ObjectTablePosition, StringTablePosition);
+		UTEST_TRUE("Reading tables restores archive position", StateArchive.Tell() == 0);
+
+		bool bReferencesMatch = true;
+		for (int32 Index = 0; Index < NumReferences && bReferencesMatch; ++Index)
+		{
+			FName Name;
+			UObject* Object = nullptr;
+			FSoftObjectPath Path;
+			StateArchive << Name;
+			StateArchive << Object;
+			StateArchive << Path;
+
+			bReferencesMatch = Name == Names[Index % Names.Num()] && Object == TopLevelAsset && Path == SoftPath;
+		}
+		UTEST_TRUE("Loaded references match saved references", bReferencesMatch);
+		UTEST_TRUE("State data is fully read", StateArchive.Tell() == ObjectTablePosition);
+	}
+
 	return !HasAnyErrors();
 }
 
@@ -260,15 +409,6 @@ bool FPersistentStateTest_StateStorageAPI::RunTest(const FString& Parameters)
 	UTEST_TRUE("Storage has 1 available slots on disk", AvailableSlots.Num() == 1);
 
 	/** saving/loading world state to slots */
-	auto CreateWorldState = [](FName WorldName)
-	{
-		FWorldStateSharedRef WorldState = MakeShared<FWorldState>(FWorldState::CreateSaveState());
-		WorldState->Header.World = WorldName.ToString();
-		WorldState->Header.WorldPackage = TEXT("/Temp");
-		
-		return WorldState;
-	};
-	
 	const FName World{TEXT("TestWorld")};
 	const FName OtherWorld{TEXT("OtherTestWorld")};
 	const FName LastWorld{TEXT("LastWorld")};
@@ -281,12 +421,7 @@ bool FPersistentStateTest_StateStorageAPI::RunTest(const FString& Parameters)
 
 	FGameStateSharedRef LoadedGameState = nullptr;
 	FWorldStateSharedRef LoadedWorldState = nullptr;
-	FLoadCompletedDelegate LoadDelegate = FLoadCompletedDelegate::CreateLambda(
-	[&LoadedWorldState, &LoadedGameState](FGameStateSharedRef InGameState, FWorldStateSharedRef InWorldState)
-	{
-		LoadedGameState = InGameState;
-		LoadedWorldState = InWorldState;
-	});
+	const FLoadCompletedDelegate LoadDelegate = CreateLoadDelegate(LoadedGameState, LoadedWorldState);
 
 	{
 		// expected 2 errors from default named slots, as they do not require associated file path before the first save
@@ -360,6 +495,603 @@ bool FPersistentStateTest_StateStorageAPI::RunTest(const FString& Parameters)
 	return !HasAnyErrors();
 }
 
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_MemoryStorage, FPersistentStateStorageTestBase, "PersistentState.MemoryStorage", AutomationFlags)
+
+bool FPersistentStateTest_MemoryStorage::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	const FName TestSlot{TEXT("TestSlot")};
+	Initialize({TestSlot});
+	ON_SCOPE_EXIT { Cleanup(); };
+
+	UPersistentStateMemoryStorage* MemoryStorage = NewObject<UPersistentStateMemoryStorage>(*ScopedWorld);
+	MemoryStorage->AddToRoot();
+	MemoryStorage->Init();
+	ON_SCOPE_EXIT
+	{
+		MemoryStorage->Shutdown();
+		MemoryStorage->RemoveFromRoot();
+		MemoryStorage->MarkAsGarbage();
+	};
+
+	const FName World{TEXT("TestWorld")};
+	const FName OtherWorld{TEXT("OtherTestWorld")};
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	const FLoadCompletedDelegate LoadDelegate = CreateLoadDelegate(LoadedGameState, LoadedWorldState);
+
+	FGameStateSharedRef DefaultGameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	auto SlotHandle = MemoryStorage->GetStateSlotByName(TestSlot);
+	UTEST_TRUE("Found named slot", SlotHandle.IsValid());
+	UTEST_TRUE("Named slot doesn't have data", !MemoryStorage->CanLoadFromStateSlot(SlotHandle, World) && MemoryStorage->CanSaveToStateSlot(SlotHandle, World));
+
+	MemoryStorage->SaveState(DefaultGameState, CreateWorldState(World), SlotHandle, SlotHandle, {});
+	MemoryStorage->LoadState(SlotHandle, World, LoadDelegate);
+	UTEST_TRUE("Slot contains data from World1", LoadedGameState.IsValid() && LoadedWorldState.IsValid());
+	LoadedWorldState.Reset();
+
+	const FName NewTestSlot{TEXT("NewTestSlot")};
+	auto NewSlotHandle = MemoryStorage->CreateStateSlot(NewTestSlot, FText::FromName(NewTestSlot), nullptr);
+	MemoryStorage->SaveState(DefaultGameState, CreateWorldState(OtherWorld), SlotHandle, NewSlotHandle, {});
+	
+	/** world data is transferred between slots */
+	MemoryStorage->LoadState(NewSlotHandle, World, LoadDelegate);
+	UTEST_TRUE("New slot contains data from World1", LoadedWorldState.IsValid());
+	LoadedWorldState.Reset();
+	MemoryStorage->LoadState(NewSlotHandle, OtherWorld, LoadDelegate);
+	UTEST_TRUE("New slot contains data from World2", LoadedWorldState.IsValid());
+	LoadedWorldState.Reset();
+
+	MemoryStorage->RemoveStateSlot(NewSlotHandle);
+	UTEST_TRUE("New slot is removed", !MemoryStorage->GetStateSlotByName(NewTestSlot).IsValid());
+
+	/** duplicated slot shares saved state with the source slot */
+	const FName DuplicateSlot{TEXT("DuplicateSlot")};
+	auto DuplicateSlotHandle = MemoryStorage->DuplicateStateSlot(SlotHandle, DuplicateSlot);
+	UTEST_TRUE("Duplicate slot is created", DuplicateSlotHandle.IsValid());
+	MemoryStorage->LoadState(DuplicateSlotHandle, World, LoadDelegate);
+	MemoryStorage->WaitUntilTasksComplete();
+	UTEST_TRUE("Duplicate slot contains data from World1", LoadedWorldState.IsValid());
+	LoadedWorldState.Reset();
+
+	/** flushed memory files are slot files that slot storage can load */
+	MemoryStorage->FlushToFiles();
+	MemoryStorage->WaitUntilTasksComplete();
+	Storage->UpdateAvailableStateSlots({});
+	Storage->WaitUntilTasksComplete();
+	
+	Storage->LoadState(Storage->GetStateSlotByName(DuplicateSlot), World, LoadDelegate);
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Flushed slot contains data from World1", LoadedWorldState.IsValid());
+	UTEST_FALSE("Removed slot is not flushed", Storage->GetStateSlotByName(NewTestSlot).IsValid());
+	
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_StateCache, "PersistentState.StateCache", AutomationFlags)
+
+bool FPersistentStateTest_StateCache::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* CacheSize = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.StateCacheSize"));
+	UTEST_NOT_NULL("State cache size cvar exists", CacheSize);
+	
+	const int32 PrevCacheSize = CacheSize->GetInt();
+	ON_SCOPE_EXIT
+	{
+		CacheSize->Set(PrevCacheSize);
+	};
+
+	auto CreateWorldState = [](const TCHAR* World, int32 Size)
+	{
+		FWorldStateDataHeader Header{};
+		Header.World = World;
+		FWorldStateSharedRef WorldState = MakeShared<FWorldState>(FWorldState::CreateLoadState(Header));
+		WorldState->Buffer.Reserve(Size);
+		return WorldState;
+	};
+
+	// budget fits two world states
+	constexpr int32 StateSize = 256 * 1024;
+	CacheSize->Set(640);
+
+	const FName Slot1{TEXT("Slot1")}, Slot2{TEXT("Slot2")};
+	const FName WorldA{TEXT("WorldA")}, WorldB{TEXT("WorldB")}, WorldC{TEXT("WorldC")}, WorldD{TEXT("WorldD")};
+	
+	FPersistentStateCache Cache;
+	Cache.AddGameState(Slot1, MakeShared<FGameState>(FGameState::CreateLoadState(FGameStateDataHeader{})));
+	Cache.AddWorldState(Slot1, CreateWorldState(TEXT("WorldA"), StateSize));
+	Cache.AddWorldState(Slot1, CreateWorldState(TEXT("WorldB"), StateSize));
+	UTEST_TRUE("Game state is cached", Cache.FindGameState(Slot1).IsValid());
+	UTEST_TRUE("World states within budget are cached", Cache.FindWorldState(Slot1, WorldA).IsValid() && Cache.HasWorldState(Slot1, WorldB));
+	UTEST_TRUE("Other slot misses cache", !Cache.FindGameState(Slot2).IsValid() && !Cache.FindWorldState(Slot2, WorldA).IsValid());
+
+	// WorldA was accessed more recently than WorldB
+	Cache.AddWorldState(Slot1, CreateWorldState(TEXT("WorldC"), StateSize));
+	UTEST_TRUE("Least recently used world state is evicted", !Cache.HasWorldState(Slot1, WorldB));
+	UTEST_TRUE("Recently used world states are kept", Cache.HasWorldState(Slot1, WorldA) && Cache.HasWorldState(Slot1, WorldC));
+
+	// most recently used states are kept even if they don't fit into the budget
+	CacheSize->Set(0);
+	Cache.AddWorldState(Slot1, CreateWorldState(TEXT("WorldD"), StateSize));
+	UTEST_TRUE("Older world states are evicted", !Cache.HasWorldState(Slot1, WorldA) && !Cache.HasWorldState(Slot1, WorldC));
+	UTEST_TRUE("Most recently used states are kept", Cache.HasWorldState(Slot1, WorldD) && Cache.FindGameState(Slot1).IsValid());
+
+	CacheSize->Set(PrevCacheSize);
+	Cache.AddWorldState(Slot2, CreateWorldState(TEXT("WorldA"), StateSize));
+	
+	const uint32 InvalidationCount = Cache.GetInvalidationCount();
+	Cache.RemoveSlot(Slot1);
+	UTEST_TRUE("Slot removal invalidates cache", Cache.GetInvalidationCount() != InvalidationCount);
+	UTEST_TRUE("Removed slot states are not cached", !Cache.FindGameState(Slot1).IsValid() && !Cache.HasWorldState(Slot1, WorldD));
+	UTEST_TRUE("Other slot states are kept", Cache.HasWorldState(Slot2, WorldA));
+
+	Cache.Reset();
+	UTEST_TRUE("Cache is empty after reset", !Cache.HasWorldState(Slot2, WorldA) && Cache.GetAllocatedSize() == 0);
+	
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_BufferPool, "PersistentState.BufferPool", AutomationFlags)
+
+bool FPersistentStateTest_BufferPool::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* PoolSize = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BufferPoolSize"));
+	IConsoleVariable* PoolMaxSize = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BufferPoolMaxSize"));
+	UTEST_NOT_NULL("Buffer pool size cvar exists", PoolSize);
+	UTEST_NOT_NULL("Buffer pool max size cvar exists", PoolMaxSize);
+
+	const int32 PrevPoolSize = PoolSize->GetInt();
+	const int32 PrevPoolMaxSize = PoolMaxSize->GetInt();
+	ON_SCOPE_EXIT
+	{
+		PoolSize->Set(PrevPoolSize);
+		PoolMaxSize->Set(PrevPoolMaxSize);
+	};
+
+	auto CreateBuffer = [](int32 Capacity, int32 Size)
+	{
+		TArray<uint8> Buffer;
+		Buffer.Reserve(Capacity);
+		Buffer.SetNumZeroed(Size);
+		return Buffer;
+	};
+
+	// pool fits two buffers and 256KB
+	constexpr int32 BufferSize = 64 * 1024;
+	PoolSize->Set(2);
+	PoolMaxSize->Set(256);
+
+	FPersistentStateBufferPool Pool;
+	Pool.Release(CreateBuffer(BufferSize, BufferSize));
+	UTEST_TRUE("Released buffer is pooled", Pool.GetAllocatedSize() >= BufferSize);
+
+	TArray<uint8> Buffer = Pool.Acquire(BufferSize / 2);
+	UTEST_TRUE("Acquired buffer is empty", Buffer.IsEmpty());
+	UTEST_TRUE("Pooled buffer is reused", Buffer.Max() >= BufferSize);
+	UTEST_TRUE("Acquired buffer is removed from the pool", Pool.GetAllocatedSize() < BufferSize);
+	Pool.Release(MoveTemp(Buffer));
+
+	// buffer slack is freed before buffer is pooled
+	Pool.Reset();
+	Pool.Release(CreateBuffer(4 * BufferSize, BufferSize));
+	Buffer = Pool.Acquire(0);
+	UTEST_TRUE("Buffer slack is freed on release", Buffer.Max() >= BufferSize && Buffer.Max() < 2 * BufferSize);
+
+	// smallest fitting buffer is preferred
+	Pool.Release(MoveTemp(Buffer));
+	Pool.Release(CreateBuffer(2 * BufferSize, 2 * BufferSize));
+	Buffer = Pool.Acquire(BufferSize);
+	UTEST_TRUE("Smallest fitting buffer is acquired", Buffer.Max() >= BufferSize && Buffer.Max() < 2 * BufferSize);
+	Pool.Release(MoveTemp(Buffer));
+
+	// pool is full, smaller buffer is replaced as long as pool fits into its memory budget
+	Pool.Release(CreateBuffer(3 * BufferSize, 3 * BufferSize));
+	UTEST_TRUE("Buffer over memory budget is not pooled", Pool.GetAllocatedSize() < 4 * BufferSize);
+
+	Pool.Release(CreateBuffer(5 * BufferSize, 5 * BufferSize));
+	UTEST_TRUE("Buffer larger than memory budget is discarded", Pool.GetAllocatedSize() < 4 * BufferSize);
+
+	PoolMaxSize->Set(512);
+	Pool.Release(CreateBuffer(3 * BufferSize, 3 * BufferSize));
+	UTEST_TRUE("Smallest buffer is replaced by a larger one", Pool.GetAllocatedSize() >= 5 * BufferSize);
+
+	PoolMaxSize->Set(0);
+	Pool.Reset();
+	Pool.Release(CreateBuffer(BufferSize, BufferSize));
+	UTEST_TRUE("Zero memory budget disables pooling", Pool.GetAllocatedSize() == 0);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_StorageScheduler, "PersistentState.StorageScheduler", AutomationFlags)
+
+bool FPersistentStateTest_StorageScheduler::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageScheduler& Scheduler = FPersistentStateStorageScheduler::Get();
+	UTEST_TRUE("Interactive tasks run in foreground", !FPersistentStateStorageScheduler::IsBackground(EPersistentStateTaskPriority::InteractiveLoad) && !FPersistentStateStorageScheduler::IsBackground(EPersistentStateTaskPriority::InteractiveSave));
+	UTEST_TRUE("Background tasks run in background", FPersistentStateStorageScheduler::IsBackground(EPersistentStateTaskPriority::BackgroundSave) && FPersistentStateStorageScheduler::IsBackground(EPersistentStateTaskPriority::SlotScan));
+
+	IConsoleVariable* Bandwidth = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BackgroundBandwidth"));
+	UTEST_NOT_NULL("Background bandwidth cvar exists", Bandwidth);
+	UTEST_TRUE("Background tasks are not throttled by default", Bandwidth->GetInt() == 0);
+	
+	const int32 NumActiveTasks = Scheduler.GetNumActiveInteractiveTasks();
+	UTEST_TRUE("No interactive tasks are running", NumActiveTasks == 0);
+
+	FEvent* InteractiveEvent = FPlatformProcess::GetSynchEventFromPool(true);
+	FGraphEventRef ReadsCompletedEvent = FGraphEvent::CreateGraphEvent();
+	FGraphEventRef InteractiveTask, BackgroundTask;
+	std::atomic<bool> bBackgroundResumed{false};
+	ON_SCOPE_EXIT
+	{
+		// release and join scheduled tasks even if test fails early
+		InteractiveEvent->Trigger();
+		if (!ReadsCompletedEvent->IsComplete())
+		{
+			ReadsCompletedEvent->DispatchSubsequents();
+		}
+		for (const FGraphEventRef& Task: {InteractiveTask, BackgroundTask})
+		{
+			if (Task.IsValid())
+			{
+				FTaskGraphInterface::Get().WaitUntilTaskCompletes(Task);
+			}
+		}
+		FPlatformProcess::ReturnSynchEventToPool(InteractiveEvent);
+	};
+
+	// interactive task is counted until its completion event is extended
+	InteractiveTask = Scheduler.Dispatch(EPersistentStateTaskPriority::InteractiveLoad, [InteractiveEvent, ReadsCompletedEvent](const FGraphEventRef& CompletionEvent)
+	{
+		InteractiveEvent->Wait();
+		CompletionEvent->DontCompleteUntil(ReadsCompletedEvent);
+	}, {});
+
+	const double StartTime = FPlatformTime::Seconds();
+	while (Scheduler.GetNumActiveInteractiveTasks() == NumActiveTasks && FPlatformTime::Seconds() - StartTime < 5.0)
+	{
+		FPlatformProcess::Sleep(0.f);
+	}
+	UTEST_TRUE("Running interactive task is counted", Scheduler.GetNumActiveInteractiveTasks() == NumActiveTasks + 1);
+
+	// background task is preempted by a running interactive task
+	BackgroundTask = Scheduler.Dispatch(EPersistentStateTaskPriority::BackgroundSave, [&Scheduler, &bBackgroundResumed](const FGraphEventRef&)
+	{
+		Scheduler.YieldBackgroundTask(0);
+		bBackgroundResumed = true;
+	}, {});
+
+	FPlatformProcess::Sleep(0.05f);
+	UTEST_FALSE("Background task yields to interactive task", bBackgroundResumed.load());
+
+	InteractiveEvent->Trigger();
+	FPlatformProcess::Sleep(0.05f);
+	UTEST_FALSE("Background task yields until interactive task completion event", bBackgroundResumed.load());
+	
+	ReadsCompletedEvent->DispatchSubsequents();
+	FTaskGraphInterface::Get().WaitUntilTaskCompletes(InteractiveTask);
+	FTaskGraphInterface::Get().WaitUntilTaskCompletes(BackgroundTask);
+	UTEST_TRUE("Background task resumes after interactive task", bBackgroundResumed.load());
+	UTEST_TRUE("Completed interactive task is not counted", Scheduler.GetNumActiveInteractiveTasks() == NumActiveTasks);
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_WorldStatePrefetch, FPersistentStateStorageTestBase, "PersistentState.WorldStatePrefetch", AutomationFlags)
+
+bool FPersistentStateTest_WorldStatePrefetch::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	const FName TestSlot{TEXT("TestSlot")};
+	Initialize({TestSlot});
+	ON_SCOPE_EXIT { Cleanup(); };
+
+	const FName World{TEXT("TestWorld")};
+	const FName OtherWorld{TEXT("OtherTestWorld")};
+	
+	FPersistentStateSlotHandle SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	Storage->SaveState(GameState, CreateWorldState(World, 1024), SlotHandle, SlotHandle, {});
+	Storage->SaveState(GameState, CreateWorldState(OtherWorld, 1024), SlotHandle, SlotHandle, {});
+
+	// recreate storage, so that saved states are not cached
+	constexpr bool bDeleteSaveGames = false;
+	Cleanup(bDeleteSaveGames);
+	Initialize({TestSlot}, bDeleteSaveGames);
+	UPersistentStateSettings::GetMutable()->bCacheSlotState = true;
+	SlotHandle = Storage->GetStateSlotByName(TestSlot);
+
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	const FLoadCompletedDelegate LoadDelegate = CreateLoadDelegate(LoadedGameState, LoadedWorldState);
+	
+	Storage->LoadState(SlotHandle, World, LoadDelegate);
+	UTEST_TRUE("World state is loaded", LoadedGameState.IsValid() && LoadedWorldState.IsValid());
+	
+	UTEST_TRUE("Prefetch is started for other world", Storage->PrefetchState(SlotHandle, OtherWorld).IsValid());
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Prefetch is skipped for cached world state", !Storage->PrefetchState(SlotHandle, OtherWorld).IsValid());
+
+	// prefetched world state is loaded without reading slot file
+	IFileManager::Get().Delete(*UPersistentStateSettings::Get()->GetSaveGameFilePath(TestSlot), true, false, true);
+	Storage->LoadState(SlotHandle, OtherWorld, LoadDelegate);
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Prefetched world state is loaded", LoadedGameState.IsValid() && LoadedWorldState.IsValid() && LoadedWorldState->Header.GetWorld() == OtherWorld);
+	UTEST_TRUE("Prefetched world state data is valid", LoadedWorldState.IsValid() && LoadedWorldState->Buffer.Num() == 1024);
+	
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_BlockStore, FPersistentStateStorageTestBase, "PersistentState.BlockStore", AutomationFlags)
+
+bool FPersistentStateTest_BlockStore::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	IConsoleVariable* BlockStore = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BlockStore"));
+	UTEST_NOT_NULL("Block store cvar exists", BlockStore);
+	
+	const bool bPrevBlockStore = BlockStore->GetBool();
+	BlockStore->Set(true);
+	
+	const FName TestSlot{TEXT("TestSlot")};
+	const FName OtherTestSlot{TEXT("OtherTestSlot")};
+	Initialize({TestSlot, OtherTestSlot});
+	ON_SCOPE_EXIT
+	{
+		Cleanup();
+		BlockStore->Set(bPrevBlockStore);
+	};
+
+	const FName World{TEXT("TestWorld")};
+	const FName OtherWorld{TEXT("OtherTestWorld")};
+	
+	FPersistentStateSlotHandle SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	FPersistentStateSlotHandle OtherSlotHandle = Storage->GetStateSlotByName(OtherTestSlot);
+	
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	GameState->Buffer.Init(0x3C, 512);
+	GameState->Header.DataSize = GameState->Buffer.Num();
+	
+	Storage->SaveState(GameState, CreateWorldState(World, 1024, 0x5A), SlotHandle, SlotHandle, {});
+	// save as, world state is shared with the source slot and other world has the same content
+	Storage->SaveState(GameState, CreateWorldState(OtherWorld, 1024, 0x5A), SlotHandle, OtherSlotHandle, {});
+	Storage->WaitUntilTasksComplete();
+	UTEST_EQUAL("Game and world blocks are deduplicated between slots", GetNumBlocks(), 2);
+
+	// recreate storage, so that saved states are not cached
+	constexpr bool bDeleteSaveGames = false;
+	Cleanup(bDeleteSaveGames);
+	Initialize({TestSlot, OtherTestSlot}, bDeleteSaveGames);
+	SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	OtherSlotHandle = Storage->GetStateSlotByName(OtherTestSlot);
+
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	const FLoadCompletedDelegate LoadDelegate = CreateLoadDelegate(LoadedGameState, LoadedWorldState);
+	
+	Storage->LoadState(OtherSlotHandle, World, LoadDelegate);
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Game state is loaded from the block store", LoadedGameState.IsValid() && LoadedGameState->Buffer == GameState->Buffer);
+	UTEST_TRUE("Copied world state is loaded from the block store", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == CreateWorldState(World, 1024, 0x5A)->Buffer);
+
+	Storage->RemoveStateSlot(SlotHandle);
+	Storage->WaitUntilTasksComplete();
+	UTEST_EQUAL("Blocks referenced by other slot are kept", GetNumBlocks(), 2);
+	
+	Storage->RemoveStateSlot(OtherSlotHandle);
+	Storage->WaitUntilTasksComplete();
+	UTEST_EQUAL("Unreferenced blocks are removed", GetNumBlocks(), 0);
+	
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_SaveDuringSlotUpdate, FPersistentStateStorageTestBase, "PersistentState.SaveDuringSlotUpdate", AutomationFlags)
+
+bool FPersistentStateTest_SaveDuringSlotUpdate::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	IConsoleVariable* BlockStore = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BlockStore"));
+	UTEST_NOT_NULL("Block store cvar exists", BlockStore);
+	
+	const bool bPrevBlockStore = BlockStore->GetBool();
+	BlockStore->Set(true);
+
+	// run storage tasks in background, so that save is queued while slot update is in flight
+	const FName TestSlot{TEXT("TestSlot")};
+	constexpr bool bForceGameThread = false;
+	Initialize({TestSlot}, true, bForceGameThread);
+	ON_SCOPE_EXIT
+	{
+		Cleanup();
+		BlockStore->Set(bPrevBlockStore);
+	};
+
+	const FName World{TEXT("TestWorld")};
+	FPersistentStateSlotHandle SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	
+	Storage->SaveState(GameState, CreateWorldState(World, 1024, 0x1A), SlotHandle, SlotHandle, {});
+	Storage->WaitUntilTasksComplete();
+
+	Storage->UpdateAvailableStateSlots({});
+	Storage->SaveState(GameState, CreateWorldState(World, 1024, 0x2B), SlotHandle, SlotHandle, {});
+	Storage->WaitUntilTasksComplete();
+
+	const TArray<uint8> ExpectedBuffer = CreateWorldState(World, 1024, 0x2B)->Buffer;
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	Storage->LoadState(SlotHandle, World, CreateLoadDelegate(LoadedGameState, LoadedWorldState));
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Saved world state is loaded after slot update", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == ExpectedBuffer);
+
+	// recreate storage, so that world state is loaded from the block store
+	constexpr bool bDeleteSaveGames = false;
+	Cleanup(bDeleteSaveGames);
+	Initialize({TestSlot}, bDeleteSaveGames);
+	SlotHandle = Storage->GetStateSlotByName(TestSlot);
+
+	LoadedWorldState = nullptr;
+	Storage->LoadState(SlotHandle, World, CreateLoadDelegate(LoadedGameState, LoadedWorldState));
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Block referenced by the slot file is not removed", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == ExpectedBuffer);
+	
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_DeltaSaves, FPersistentStateStorageTestBase, "PersistentState.DeltaSaves", AutomationFlags)
+
+bool FPersistentStateTest_DeltaSaves::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	auto CreateRandomBuffer = [](int32 Seed, int32 Size)
+	{
+		FRandomStream RandomStream{Seed};
+		TArray<uint8> Buffer;
+		Buffer.SetNumUninitialized(Size);
+		for (uint8& Value: Buffer)
+		{
+			Value = static_cast<uint8>(RandomStream.RandHelper(256));
+		}
+		
+		return Buffer;
+	};
+
+	// base state with inserted and modified data
+	const TArray<uint8> BaseBuffer = CreateRandomBuffer(42, 64 * 1024);
+	TArray<uint8> StateBuffer = BaseBuffer;
+	StateBuffer.Insert(CreateRandomBuffer(7, 100), 30 * 1024);
+	FMemory::Memset(StateBuffer.GetData() + 50 * 1024, 0, 16);
+
+	{
+		TArray<uint8> Delta = FPersistentStateDelta::Create(BaseBuffer, StateBuffer);
+		UTEST_TRUE("Delta is small", Delta.Num() < 4 * 1024);
+
+		TArray<uint8> AppliedState;
+		UTEST_TRUE("Delta is applied", FPersistentStateDelta::Apply(BaseBuffer, Delta, AppliedState));
+		UTEST_TRUE("Applied delta matches state", AppliedState == StateBuffer);
+		UTEST_FALSE("Delta doesn't apply to a different base", FPersistentStateDelta::Apply(TArray<uint8>{}, Delta, AppliedState));
+	}
+
+	IConsoleVariable* BlockStore = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.BlockStore"));
+	IConsoleVariable* DeltaSaveThreshold = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.DeltaSaveThreshold"));
+	UTEST_TRUE("Block store cvars exist", BlockStore != nullptr && DeltaSaveThreshold != nullptr);
+	
+	const bool bPrevBlockStore = BlockStore->GetBool();
+	const int32 PrevDeltaSaveThreshold = DeltaSaveThreshold->GetInt();
+	BlockStore->Set(true);
+	DeltaSaveThreshold->Set(25);
+	
+	const FName TestSlot{TEXT("TestSlot")};
+	Initialize({TestSlot});
+	ON_SCOPE_EXIT
+	{
+		Cleanup();
+		BlockStore->Set(bPrevBlockStore);
+		DeltaSaveThreshold->Set(PrevDeltaSaveThreshold);
+	};
+
+	const FName World{TEXT("TestWorld")};
+
+	FPersistentStateSlotHandle SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	
+	Storage->SaveState(GameState, CreateWorldState(World, BaseBuffer), SlotHandle, SlotHandle, {});
+	Storage->SaveState(GameState, CreateWorldState(World, StateBuffer), SlotHandle, SlotHandle, {});
+	Storage->WaitUntilTasksComplete();
+	UTEST_EQUAL("World state delta is saved to the slot file", GetNumBlocks(), 1);
+
+	// recreate storage, so that saved states are not cached
+	constexpr bool bDeleteSaveGames = false;
+	Cleanup(bDeleteSaveGames);
+	Initialize({TestSlot}, bDeleteSaveGames);
+	SlotHandle = Storage->GetStateSlotByName(TestSlot);
+
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	Storage->LoadState(SlotHandle, World, CreateLoadDelegate(LoadedGameState, LoadedWorldState));
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("World state is restored from base and delta", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == StateBuffer);
+
+	// large change is saved as a new base state, previous base state is no longer referenced
+	const TArray<uint8> NewBaseBuffer = CreateRandomBuffer(13, 64 * 1024);
+	Storage->SaveState(GameState, CreateWorldState(World, NewBaseBuffer), SlotHandle, SlotHandle, {});
+	Storage->UpdateAvailableStateSlots({});
+	Storage->WaitUntilTasksComplete();
+	UTEST_EQUAL("Unreferenced base state is removed", GetNumBlocks(), 1);
+
+	// delta can't be resolved without its base state, world state is not loaded
+	StateBuffer = NewBaseBuffer;
+	FMemory::Memset(StateBuffer.GetData() + 10 * 1024, 0, 16);
+	Storage->SaveState(GameState, CreateWorldState(World, StateBuffer), SlotHandle, SlotHandle, {});
+	Storage->WaitUntilTasksComplete();
+	Cleanup(bDeleteSaveGames);
+
+	const FString BlockStorePath = FPersistentStateSlot::GetBlockStorePath(UPersistentStateSettings::Get()->GetSaveGamePath());
+	IFileManager::Get().DeleteDirectory(*BlockStorePath, false, true);
+	Initialize({TestSlot}, bDeleteSaveGames);
+	SlotHandle = Storage->GetStateSlotByName(TestSlot);
+
+	AddExpectedError(TEXT("is missing from the block store."), EAutomationExpectedErrorFlags::MatchType::Contains, 1);
+	AddExpectedError(TEXT("failed to apply state delta"), EAutomationExpectedErrorFlags::MatchType::Contains, 1);
+	LoadedWorldState = nullptr;
+	Storage->LoadState(SlotHandle, World, CreateLoadDelegate(LoadedGameState, LoadedWorldState));
+	Storage->WaitUntilTasksComplete();
+	UTEST_FALSE("World state with unresolved delta is not loaded", LoadedWorldState.IsValid());
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_CUSTOM_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_DuplicateStateSlot, FPersistentStateStorageTestBase, "PersistentState.DuplicateStateSlot", AutomationFlags)
+
+bool FPersistentStateTest_DuplicateStateSlot::RunTest(const FString& Parameters)
+{
+	FPersistentStateStorageTestBase::RunTest(Parameters);
+
+	const FName TestSlot{TEXT("TestSlot")};
+	const FName DuplicateSlot{TEXT("DuplicateSlot")};
+	Initialize({TestSlot});
+	ON_SCOPE_EXIT { Cleanup(); };
+
+	const FName World{TEXT("TestWorld")};
+	FGameStateSharedRef LoadedGameState = nullptr;
+	FWorldStateSharedRef LoadedWorldState = nullptr;
+	const FLoadCompletedDelegate LoadDelegate = CreateLoadDelegate(LoadedGameState, LoadedWorldState);
+
+	const FPersistentStateSlotHandle SlotHandle = Storage->GetStateSlotByName(TestSlot);
+	UTEST_FALSE("Slot without saved state can't be duplicated", Storage->DuplicateStateSlot(SlotHandle, DuplicateSlot).IsValid());
+	
+	FGameStateSharedRef GameState = MakeShared<FGameState>(FGameState::CreateSaveState());
+	Storage->SaveState(GameState, CreateWorldState(World, 1024, 1), SlotHandle, SlotHandle, {});
+
+	const FPersistentStateSlotHandle DuplicateHandle = Storage->DuplicateStateSlot(SlotHandle, DuplicateSlot);
+	UTEST_TRUE("Slot is duplicated", DuplicateHandle.IsValid() && DuplicateHandle.GetSlotName() == DuplicateSlot);
+	UTEST_FALSE("Existing slot name can't be reused", Storage->DuplicateStateSlot(SlotHandle, DuplicateSlot).IsValid());
+	UTEST_TRUE("Duplicated slot has world state", Storage->CanLoadFromStateSlot(DuplicateHandle, World));
+
+	// duplicate diverges from the source slot on save
+	Storage->SaveState(GameState, CreateWorldState(World, 1024, 2), DuplicateHandle, DuplicateHandle, {});
+	
+	// recreate storage, so that saved states are not cached and slots are read from slot files
+	constexpr bool bDeleteSaveGames = false;
+	Cleanup(bDeleteSaveGames);
+	Initialize({TestSlot}, bDeleteSaveGames);
+
+	Storage->LoadState(Storage->GetStateSlotByName(TestSlot), World, LoadDelegate);
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Source slot state is not modified", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == CreateWorldState(World, 1024, 1)->Buffer);
+	
+	Storage->LoadState(Storage->GetStateSlotByName(DuplicateSlot), World, LoadDelegate);
+	Storage->WaitUntilTasksComplete();
+	UTEST_TRUE("Duplicated slot state is saved", LoadedWorldState.IsValid() && LoadedWorldState->Buffer == CreateWorldState(World, 1024, 2)->Buffer);
+	
+	return !HasAnyErrors();
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPersistentStateTest_ActiveStateSlot, "PersistentState.ActiveStateSlot", AutomationFlags)
 
 bool FPersistentStateTest_ActiveStateSlot::RunTest(const FString& Parameters)
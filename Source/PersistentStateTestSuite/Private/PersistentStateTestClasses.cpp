@@ -6,6 +6,8 @@
 #include "PersistentStateSlotDescriptor.h"
 #include "PersistentStateSubsystem.h"
 
+UE_PERSISTENT_STATE_FAST_SERIALIZER(UPersistentStateFastStateTestObject);
+
 namespace UE::PersistentState
 {
 	FGameStateSharedRef CurrentGameState;
@@ -155,7 +157,7 @@ uint32 UPersistentStateFakeStorage::GetAllocatedSize() const
 	return TotalMemory;
 }
 
-FGraphEventRef UPersistentStateFakeStorage::SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate)
+FGraphEventRef UPersistentStateFakeStorage::SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority)
 {
 	check(UE::PersistentState::ExpectedSlot == TargetSlotHandle);
 	UE::PersistentState::CurrentWorldState = WorldState;
@@ -8,6 +8,7 @@
 #include "PersistentStateModule.h"
 #include "PersistentStateSlotStorage.h"
 #include "PersistentStateSlot.h"
+#include "PersistentStateTraits.h"
 #include "Managers/PersistentStateManager.h"
 
 #include "PersistentStateTestClasses.generated.h"
@@ -108,7 +109,7 @@ public:
 	virtual void Shutdown() override {}
 	virtual uint32 GetAllocatedSize() const override;
 	virtual void WaitUntilTasksComplete() const override {}
-	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate) override;
+	virtual FGraphEventRef SaveState(FGameStateSharedRef GameState, FWorldStateSharedRef WorldState, const FPersistentStateSlotHandle& SourceSlotHandle, const FPersistentStateSlotHandle& TargetSlotHandle, FSaveCompletedDelegate CompletedDelegate, EPersistentStateTaskPriority Priority = EPersistentStateTaskPriority::InteractiveSave) override;
 	virtual FGraphEventRef LoadState(const FPersistentStateSlotHandle& TargetSlotHandle, FName WorldName, FLoadCompletedDelegate CompletedDelegate) override;
 	virtual void SaveStateSlotScreenshot(const FPersistentStateSlotHandle& TargetSlotHandle) override {}
 	virtual bool HasScreenshotForStateSlot(const FPersistentStateSlotHandle& TargetSlotHandle) override { return false; }
@@ -149,6 +150,60 @@ class UPersistentStateTestObject_NoInterface: public UObject
 	GENERATED_BODY()
 };
 
+UCLASS(HideDropdown)
+class UPersistentStateSaveGameTestObject: public UObject
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY(SaveGame)
+	int32 StoredInt = 0;
+
+	UPROPERTY(SaveGame)
+	FString StoredString{};
+};
+
+/** @UPersistentStateSaveGameTestObject with changed SaveGame layout: StoredString changed its type, AddedFloat is added */
+UCLASS(HideDropdown)
+class UPersistentStateChangedSchemaTestObject: public UObject
+{
+	GENERATED_BODY()
+public:
+
+	UPROPERTY(SaveGame)
+	float AddedFloat = 0.f;
+	
+	UPROPERTY(SaveGame)
+	int32 StoredInt = 0;
+
+	UPROPERTY(SaveGame)
+	FName StoredString = NAME_None;
+};
+
+UCLASS(HideDropdown)
+class UPersistentStateFastStateTestObject: public UPersistentStateSaveGameTestObject
+{
+	GENERATED_BODY()
+public:
+
+	/** fast serializer, @see TPersistentStateTraits */
+	void SerializeState(FArchive& Ar)
+	{
+		Ar << FastInt;
+		Ar << FastString;
+	}
+
+	/** native state stored by fast serializer */
+	int32 FastInt = 0;
+	FString FastString{};
+};
+
+template <>
+struct TPersistentStateTraits<UPersistentStateFastStateTestObject>
+{
+	enum { WithFastSerializer = true };
+};
+
 UCLASS(HideDropdown, BlueprintType)
 class UPersistentStateEmptyTestComponent: public UActorComponent, public IPersistentStateCallbackListener
 {
@@ -771,4 +771,86 @@ bool FPersistentStateTest_ObjectState::RunTest(const FString& Parameters)
 	return !HasAnyErrors();
 }
 
+IMPLEMENT_CUSTOM_COMPLEX_AUTOMATION_TEST(
+	FPersistentStateTest_LevelStateLayout, FPersistentStateAutoTest,
+	"PersistentState.LevelStateLayout", AutomationFlags
+)
+
+void FPersistentStateTest_LevelStateLayout::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	OutBeautifiedNames.Add(TEXT("Rows"));
+	OutBeautifiedNames.Add(TEXT("Columns"));
+	OutTestCommands.Add(TEXT("0"));
+	OutTestCommands.Add(TEXT("1"));
+}
+
+bool FPersistentStateTest_LevelStateLayout::RunTest(const FString& Parameters)
+{
+	// level state layout is used by compact serialization, other builds verify that the layout doesn't affect saved state
+	IConsoleVariable* LayoutCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("PersistentState.ColumnarLevelEncoding"));
+	UTEST_TRUE("Found level layout console variable", LayoutCVar != nullptr);
+	
+	const bool bPrevColumnarLayout = LayoutCVar->GetBool();
+	LayoutCVar->Set(Parameters == TEXT("1"), ECVF_SetByCode);
+	ON_SCOPE_EXIT { LayoutCVar->Set(bPrevColumnarLayout, ECVF_SetByCode); };
+
+	const FString WorldPackage{TEXT("/PersistentState/PersistentStateTestMap_Default")};
+	FPersistentStateAutoTest::RunTest(WorldPackage);
+
+	const FString SlotName{TEXT("TestSlot")};
+	Initialize(WorldPackage, {SlotName});
+	ON_SCOPE_EXIT { Cleanup(); };
+
+	APersistentStateTestActor* StaticActor = ScopedWorld->FindActorByTag<APersistentStateTestActor>(TEXT("StaticActor1"));
+	UTEST_TRUE("Found static actor", StaticActor != nullptr);
+	const FPersistentStateObjectId StaticId = FPersistentStateObjectId::FindObjectId(StaticActor);
+	
+	TArray<FPersistentStateObjectId> DynamicIds;
+	TArray<FTransform> DynamicTransforms;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		APersistentStateTestActor* DynamicActor = ScopedWorld->SpawnActor<APersistentStateTestActor>();
+		UTEST_TRUE("Spawned dynamic actor", DynamicActor != nullptr);
+		
+		const FTransform Transform{FRotator{10.0 * Index, 20.0, 0.0}, FVector{100.0 * Index, 0.5, -25.0}, FVector{1.0 + Index}};
+		DynamicActor->SetActorTransform(Transform);
+		DynamicActor->StoredInt = Index + 1;
+		DynamicActor->StoredString = FString::Printf(TEXT("DynamicActor%d"), Index);
+		if (Index % 2 == 0)
+		{
+			DynamicActor->AttachToActor(StaticActor, FAttachmentTransformRules::KeepWorldTransform);
+		}
+
+		DynamicIds.Add(FPersistentStateObjectId::FindObjectId(DynamicActor));
+		DynamicTransforms.Add(DynamicActor->GetActorTransform());
+	}
+	StaticActor->StoredInt = 42;
+	
+	ExpectedSlot = StateSubsystem->FindSaveGameSlotByName(FName{SlotName});
+	UTEST_TRUE("Found slot", ExpectedSlot.IsValid());
+	
+	StateSubsystem->SaveGameToSlot(ExpectedSlot);
+	StateSubsystem->Tick(1.f);
+
+	// add travel option to override game mode for the loaded map. Otherwise it will load default game mode which will not match the current one
+	const FString TravelOptions = TEXT("GAME=") + FSoftClassPath{ScopedWorld->GetGameMode()->GetClass()}.ToString();
+	StateSubsystem->LoadGameFromSlot(ExpectedSlot, TravelOptions);
+	StateSubsystem->Tick(1.f);
+	ScopedWorld->FinishWorldTravel();
+
+	StaticActor = StaticId.ResolveObject<APersistentStateTestActor>();
+	UTEST_TRUE("Static actor state is restored", StaticActor != nullptr && StaticActor->StoredInt == 42);
+	
+	for (int32 Index = 0; Index < DynamicIds.Num(); ++Index)
+	{
+		APersistentStateTestActor* DynamicActor = DynamicIds[Index].ResolveObject<APersistentStateTestActor>();
+		UTEST_TRUE("Dynamic actor is restored", DynamicActor != nullptr);
+		UTEST_TRUE("Dynamic actor state is restored", DynamicActor->StoredInt == Index + 1 && DynamicActor->StoredString == FString::Printf(TEXT("DynamicActor%d"), Index));
+		UTEST_TRUE("Dynamic actor transform is restored", DynamicActor->GetActorTransform().Equals(DynamicTransforms[Index], UE_KINDA_SMALL_NUMBER));
+		UTEST_TRUE("Dynamic actor attachment is restored", (DynamicActor->GetAttachParentActor() == StaticActor) == (Index % 2 == 0));
+	}
+	
+	return !HasAnyErrors();
+}
+
 UE_ENABLE_OPTIMIZATION